@@ -1,6 +1,7 @@
 #include <iostream>
 #include <vector>
 #include <unordered_map>
+#include <unordered_set>
 #include <string>
 #include <chrono>
 #include <atomic>
@@ -8,35 +9,56 @@
 #include <fstream>
 #include <mutex>
 #include <optional>
+#include <algorithm>
+#include <array>
+#include <deque>
+#include <cstdlib>
+#include <thread>
+#include <condition_variable>
+#include <functional>
 #include <nlohmann/json.hpp>
+#include "lot_clock.h"
+#include "sim.h"
+#include "probes.h"
+#include "tracing.h"
+#include "memory_accounting.h"
+#include "async_log.h"
+#include "timer_wheel.h"
+#include "numa_placement.h"
+#include "huge_pages.h"
+#include "parking_core.h"
+#include "flat_combining.h"
+#include "atomic_status_array.h"
+#include "coupon_table.h"
+#include "tariff_vm.h"
+#include "fleet_ledger.h"
 using json = nlohmann::json;
 using namespace std;
 
 // ===================== Common =====================
-using TicketId = unsigned long long;
-using BillId   = unsigned long long;
-
-enum class VehicleType { Bike, Car, Truck };
-enum class SlotType    { TwoWheeler, FourWheeler, Heavy };
+// TicketId, BillId, VehicleType, SlotType, TypeRegistry: parking_core.h
+
+// ---- Vehicle and slot classes ----
+// Register before configuring lots that use them; ids are process-wide.
+// Re-registering an identical class returns its id.
+inline SlotType registerSlotType(const string& name, unsigned long long hourlyRate) {
+    int id = TypeRegistry::instance().addSlotType(name.c_str(), hourlyRate);
+    if (id < 0) throw runtime_error("Cannot register slot type " + name + " (bad or conflicting name, or table full)");
+    return (SlotType)id;
+}
+inline VehicleType registerVehicleType(const string& name, SlotType slot) {
+    int id = TypeRegistry::instance().addVehicleType(name.c_str(), slot);
+    if (id < 0) throw runtime_error("Cannot register vehicle type " + name + " (bad or conflicting name, or table full)");
+    return (VehicleType)id;
+}
 
 // ---- Vehicle ----
 struct Vehicle {
     string regNo;
     VehicleType type;
-    explicit Vehicle(string r, VehicleType t) : regNo(std::move(r)), type(t) {}
+    uint8_t customerClass = 0; // tariff customer class, see ParkingLot::customerClass()
+    explicit Vehicle(string r, VehicleType t, uint8_t cls = 0) : regNo(std::move(r)), type(t), customerClass(cls) {}
 };
-struct Bike  : Vehicle { using Vehicle::Vehicle; };
-struct Car   : Vehicle { using Vehicle::Vehicle; };
-struct Truck : Vehicle { using Vehicle::Vehicle; };
-
-static SlotType slotFor(VehicleType t) {
-    switch (t) {
-        case VehicleType::Bike:  return SlotType::TwoWheeler;
-        case VehicleType::Car:   return SlotType::FourWheeler;
-        case VehicleType::Truck: return SlotType::Heavy;
-    }
-    return SlotType::FourWheeler;
-}
 
 // ---- Core model ----
 struct ParkingSlot {
@@ -47,14 +69,10 @@ struct ParkingSlot {
 
 struct Floor {
     int floorNo = 0;
-    vector<ParkingSlot> slots;
+    vector<ParkingSlot, HugePageAllocator<ParkingSlot>> slots; // see huge_pages.h
 
     // not thread-safe alone; caller must hold lot mutex
-    int findFreeIndex(SlotType t) {
-        for (int i = 0; i < (int)slots.size(); ++i)
-            if (slots[i].type == t && slots[i].isFree) return i;
-        return -1;
-    }
+    int findFreeIndex(SlotType t) const { return firstFreeSlot(slots.data(), (int)slots.size(), t); }
 };
 
 struct Ticket {
@@ -65,86 +83,225 @@ struct Ticket {
     VehicleType vtype;
     SlotType stype;
     string vehicleReg;
+    TimerWheel::Handle timer = 0; // abandoned-ticket deadline, see sweepAbandoned()
+    bool abandoned = false;       // flagged by the sweeper
+    uint8_t customerClass = 0;    // from the Vehicle, priced by the tariff rule
+    bool dayPass = false;         // in/out until the pass expires, see enterWithDayPass()
 };
 
 struct TicketingService {
     std::atomic<TicketId> nextId{1};
+    const IClock* clock = &SystemClock::instance();
     Ticket openTicket(const string& gate, const ParkingSlot& slot, const Vehicle& v) {
         Ticket tk;
         tk.id = nextId.fetch_add(1, std::memory_order_relaxed);
         tk.entryGateId = gate;
-        tk.inTime = std::chrono::system_clock::now();
+        tk.inTime = clock->now();
         tk.slotId = slot.id;
         tk.vtype = v.type;
         tk.stype = slot.type;
         tk.vehicleReg = v.regNo;
+        tk.customerClass = v.customerClass;
         return tk;
     }
 };
 
-// ---------- Pricing (Strategy from Stage 3) ----------
-struct FeeBreakup {
-    unsigned long long amount = 0;   // INR
-    unsigned long long billedHours = 0;
-    unsigned long long parkedMinutes = 0;
+// ---- Open-ticket table ----
+// Hot/cold split. What exit, the sweeper and the timers read (id, slot
+// handle, in-time, timer, flags) lives in the hash node itself, one cache
+// line per ticket; the text fields live in a separate cold array, reached
+// through TicketHot::cold and read only when a whole Ticket is handed out.
+// Cold entries are recycled through a free list. Not thread-safe; the lot
+// lock guards it.
+struct TicketHot {
+    TicketId id = 0;
+    uint64_t slot = 0; // slot handle, see probes.h
+    std::chrono::system_clock::time_point inTime;
+    TimerWheel::Handle timer = 0;
+    uint32_t cold = 0; // index into the cold array
+    VehicleType vtype = VehicleType::Car;
+    SlotType stype = SlotType::FourWheeler;
+    bool abandoned = false;
+    uint8_t customerClass = 0;
+    bool dayPass = false;
 };
 
-struct IFeeStrategy {
-    virtual ~IFeeStrategy() = default;
-    virtual FeeBreakup compute(unsigned long long parkedMinutes) const = 0;
-protected:
-    static unsigned long long ceilHours(unsigned long long minutes) {
-        if (minutes == 0) return 0;
-        return (minutes + 59) / 60;
-    }
+struct TicketCold {
+    string entryGateId;
+    string slotId;
+    string vehicleReg;
 };
 
-static constexpr unsigned long long GRACE_MINUTES = 10; // Stage 5 add-on
+class TicketTable {
+public:
+    size_t size() const { return hot_.size(); }
 
-struct TwoWheelerFee final : IFeeStrategy {
-    FeeBreakup compute(unsigned long long minutes) const override {
-        FeeBreakup r; r.parkedMinutes = minutes;
-        if (minutes <= GRACE_MINUTES) { r.billedHours = 0; r.amount = 0; return r; }
-        auto hours = ceilHours(minutes);
-        r.billedHours = hours;
-        r.amount = hours * 10ULL;
-        return r;
+    TicketHot* find(TicketId id) {
+        auto it = hot_.find(id);
+        return it == hot_.end() ? nullptr : &it->second;
     }
-};
-struct FourWheelerFee final : IFeeStrategy {
-    FeeBreakup compute(unsigned long long minutes) const override {
-        FeeBreakup r; r.parkedMinutes = minutes;
-        if (minutes <= GRACE_MINUTES) { r.billedHours = 0; r.amount = 0; return r; }
-        auto hours = ceilHours(minutes);
-        r.billedHours = hours;
-        r.amount = hours * 20ULL;
-        return r;
+    const TicketCold& cold(const TicketHot& h) const { return cold_[h.cold]; }
+
+    // tk.id must not be open already.
+    TicketHot& insert(Ticket&& tk, uint64_t slot) {
+        uint32_t c;
+        if (!free_.empty()) {
+            c = free_.back();
+            free_.pop_back();
+        } else {
+            c = (uint32_t)cold_.size();
+            cold_.emplace_back();
+        }
+        cold_[c] = TicketCold{std::move(tk.entryGateId), std::move(tk.slotId), std::move(tk.vehicleReg)};
+        TicketHot& h = hot_[tk.id];
+        h = TicketHot{tk.id, slot, tk.inTime, tk.timer, c, tk.vtype, tk.stype, tk.abandoned, tk.customerClass, tk.dayPass};
+        return h;
     }
-};
-struct HeavyFee final : IFeeStrategy {
-    FeeBreakup compute(unsigned long long minutes) const override {
-        FeeBreakup r; r.parkedMinutes = minutes;
-        if (minutes <= GRACE_MINUTES) { r.billedHours = 0; r.amount = 0; return r; }
-        auto hours = ceilHours(minutes);
-        r.billedHours = hours;
-        r.amount = hours * 50ULL;
-        return r;
+
+    Ticket ticket(const TicketHot& h) const {
+        const TicketCold& c = cold_[h.cold];
+        Ticket tk;
+        tk.id = h.id;
+        tk.entryGateId = c.entryGateId;
+        tk.inTime = h.inTime;
+        tk.slotId = c.slotId;
+        tk.vtype = h.vtype;
+        tk.stype = h.stype;
+        tk.vehicleReg = c.vehicleReg;
+        tk.timer = h.timer;
+        tk.abandoned = h.abandoned;
+        tk.customerClass = h.customerClass;
+        tk.dayPass = h.dayPass;
+        return tk;
+    }
+
+    // Removes the ticket and returns it whole (text fields moved out).
+    Ticket take(TicketHot& h) {
+        TicketCold& c = cold_[h.cold];
+        Ticket tk;
+        tk.id = h.id;
+        tk.entryGateId = std::move(c.entryGateId);
+        tk.inTime = h.inTime;
+        tk.slotId = std::move(c.slotId);
+        tk.vtype = h.vtype;
+        tk.stype = h.stype;
+        tk.vehicleReg = std::move(c.vehicleReg);
+        tk.timer = h.timer;
+        tk.abandoned = h.abandoned;
+        tk.customerClass = h.customerClass;
+        tk.dayPass = h.dayPass;
+        free_.push_back(h.cold);
+        hot_.erase(tk.id); // not h.id: h is the node being erased
+        return tk;
+    }
+
+    // Every open ticket, emptying the table.
+    vector<Ticket> takeAll() {
+        vector<Ticket> out;
+        out.reserve(hot_.size());
+        for (auto& [id, h] : hot_) {
+            TicketCold& c = cold_[h.cold];
+            Ticket tk;
+            tk.id = id;
+            tk.entryGateId = std::move(c.entryGateId);
+            tk.inTime = h.inTime;
+            tk.slotId = std::move(c.slotId);
+            tk.vtype = h.vtype;
+            tk.stype = h.stype;
+            tk.vehicleReg = std::move(c.vehicleReg);
+            tk.timer = h.timer;
+            tk.abandoned = h.abandoned;
+            tk.customerClass = h.customerClass;
+            tk.dayPass = h.dayPass;
+            out.push_back(std::move(tk));
+        }
+        clear();
+        return out;
     }
+
+    // fn(TicketHot&) for every open ticket.
+    template <class F>
+    void forEach(F&& fn) {
+        for (auto& [id, h] : hot_) fn(h);
+    }
+    template <class F>
+    void forEach(F&& fn) const {
+        for (const auto& [id, h] : hot_) fn(h);
+    }
+
+    void clear() {
+        hot_.clear();
+        cold_.clear();
+        free_.clear();
+    }
+    void reserve(size_t n) {
+        hot_.reserve(n);
+        cold_.reserve(n);
+    }
+
+    size_t heapBytes() const { return hashMapHeapBytes(hot_) + vectorHeapBytes(cold_) + vectorHeapBytes(free_); }
+    size_t stringBytes() const {
+        size_t n = 0;
+        for (const auto& [id, h] : hot_) {
+            const TicketCold& c = cold_[h.cold];
+            n += stringHeapBytes(c.entryGateId) + stringHeapBytes(c.slotId) + stringHeapBytes(c.vehicleReg);
+        }
+        return n;
+    }
+
+private:
+    unordered_map<TicketId, TicketHot, hash<TicketId>, equal_to<TicketId>,
+                  HugePageAllocator<pair<const TicketId, TicketHot>>> hot_;
+    vector<TicketCold> cold_;
+    vector<uint32_t> free_;
+};
+
+// ---- Day passes ----
+// A day ticket lets its vehicle leave and come back until it expires,
+// under one prepaid bill. The lot keeps one DayPass per ticket (24 bytes)
+// whether the vehicle is in or out; the ticket itself is in the
+// open-ticket table only while the vehicle is inside. `floor` is where it
+// last parked and is tried first on re-entry.
+struct DayPass {
+    BillId bill = 0;        // the pass's only bill, created at purchase
+    uint32_t expiresAt = 0; // minutes since the epoch
+    uint16_t floor = 0;     // floor index
+    VehicleType vtype = VehicleType::Car;
+    SlotType stype = SlotType::FourWheeler;
+    uint8_t customerClass = 0;
+    bool inside = false;
+};
+
+// ---------- Pricing (Strategy from Stage 3) ----------
+// Rates and rounding live in parking_core.h (computeFee), shared with the
+// fixed-size engine. These price the default tariff; ParkingLot itself
+// bills from its current FeeSchedule (setFeeSchedule).
+struct IFeeStrategy {
+    virtual ~IFeeStrategy() = default;
+    virtual FeeBreakup compute(unsigned long long parkedMinutes) const = 0;
+};
+
+// Any slot type at its registered hourly rate.
+struct HourlyFee final : IFeeStrategy {
+    explicit HourlyFee(SlotType s) : type(s) {}
+    FeeBreakup compute(unsigned long long minutes) const override { return computeFee(type, minutes); }
+    SlotType type;
 };
 
 struct FeeStrategyFactory {
     static unique_ptr<IFeeStrategy> make(SlotType s) {
-        switch (s) {
-            case SlotType::TwoWheeler:  return make_unique<TwoWheelerFee>();
-            case SlotType::FourWheeler: return make_unique<FourWheelerFee>();
-            case SlotType::Heavy:       return make_unique<HeavyFee>();
-        }
-        throw runtime_error("Unknown SlotType for fee strategy");
+        if (!TypeRegistry::instance().isSlotType(s)) throw runtime_error("Unknown SlotType for fee strategy");
+        return make_unique<HourlyFee>(s);
     }
 };
 
 // ---- Billing (Stage 4) ----
-enum class BillStatus { Pending, Paid, Failed, Cancelled };
+// Waived: closed at zero fee (evacuation). Deferred: fee fixed at exit,
+// collected later; payable like Pending. Abandoned: closed by the sweeper
+// (vehicle left without scanning); payable like Pending. OnAccount: a
+// fleet exit charged to the account ledger (fleet_ledger.h); never stored
+// or payable, id 0.
+enum class BillStatus { Pending, Paid, Failed, Cancelled, Waived, Deferred, Abandoned, OnAccount };
 
 struct Bill {
     BillId id{};
@@ -157,10 +314,137 @@ struct Bill {
     std::chrono::system_clock::time_point outTime;
     unsigned long long parkedMinutes{};
     unsigned long long billedHours{};
-    unsigned long long amount{}; // INR
+    unsigned long long amount{};   // INR
+    unsigned long long discount{}; // INR off the fee for a coupon, already out of amount
+    BillStatus status{BillStatus::Pending};
+};
+
+// ---- Bill table ----
+// Same split for bills. pay() and cancel() read id, ticket, amount and
+// status: 32 bytes, two bills per cache line. Text fields, times and the
+// fee breakdown sit in the cold array at the same index and are read only
+// by get(). Bill ids are dense, so the index is id / stride (stride = the
+// number of tables ids are spread over) and a lookup is one array access,
+// no hashing. Bills are never removed. Not thread-safe; PaymentService
+// guards each table.
+struct BillHot {
+    BillId id{}; // 0 = no bill at this index
+    TicketId ticket{};
+    unsigned long long amount{};
     BillStatus status{BillStatus::Pending};
 };
 
+struct BillCold {
+    string vehicleReg;
+    string slotId;
+    string entryGateId;
+    string exitGateId;
+    std::chrono::system_clock::time_point inTime;
+    std::chrono::system_clock::time_point outTime;
+    unsigned long long parkedMinutes{};
+    unsigned long long billedHours{};
+    unsigned long long discount{};
+};
+
+class BillTable {
+public:
+    explicit BillTable(size_t stride = 1) : stride_(stride) {}
+
+    size_t size() const { return count_; }
+
+    BillHot* find(BillId id) {
+        size_t i = id / stride_;
+        return i < hot_.size() && hot_[i].id == id ? &hot_[i] : nullptr;
+    }
+    const BillHot* find(BillId id) const {
+        size_t i = id / stride_;
+        return i < hot_.size() && hot_[i].id == id ? &hot_[i] : nullptr;
+    }
+
+    // b.id must be new to the table. Ids may arrive out of order.
+    void insert(Bill&& b) {
+        size_t i = b.id / stride_;
+        if (i >= hot_.size()) {
+            hot_.resize(i + 1);
+            cold_.resize(i + 1);
+        }
+        hot_[i] = BillHot{b.id, b.ticket, b.amount, b.status};
+        cold_[i] = BillCold{std::move(b.vehicleReg), std::move(b.slotId), std::move(b.entryGateId),
+                            std::move(b.exitGateId), b.inTime, b.outTime, b.parkedMinutes, b.billedHours,
+                            b.discount};
+        ++count_;
+    }
+
+    Bill bill(const BillHot& h) const {
+        const BillCold& c = cold_[&h - hot_.data()];
+        Bill b;
+        b.id = h.id;
+        b.ticket = h.ticket;
+        b.vehicleReg = c.vehicleReg;
+        b.slotId = c.slotId;
+        b.entryGateId = c.entryGateId;
+        b.exitGateId = c.exitGateId;
+        b.inTime = c.inTime;
+        b.outTime = c.outTime;
+        b.parkedMinutes = c.parkedMinutes;
+        b.billedHours = c.billedHours;
+        b.discount = c.discount;
+        b.amount = h.amount;
+        b.status = h.status;
+        return b;
+    }
+
+    // Room for ids below `end`.
+    void reserve(BillId end) {
+        hot_.reserve(end / stride_ + 1);
+        cold_.reserve(end / stride_ + 1);
+    }
+    void clear() {
+        hot_.clear();
+        cold_.clear();
+        count_ = 0;
+    }
+
+    size_t heapBytes() const { return vectorHeapBytes(hot_) + vectorHeapBytes(cold_); }
+    size_t stringBytes() const {
+        size_t n = 0;
+        for (const BillCold& c : cold_)
+            n += stringHeapBytes(c.vehicleReg) + stringHeapBytes(c.slotId) + stringHeapBytes(c.entryGateId) +
+                 stringHeapBytes(c.exitGateId);
+        return n;
+    }
+
+private:
+    size_t stride_;
+    size_t count_ = 0;
+    vector<BillHot> hot_;
+    vector<BillCold> cold_;
+};
+
+// ---- Evacuation (bulk exit) ----
+enum class EvacuationBilling { Waive, Defer };
+
+struct EvacuationSummary {
+    size_t closed = 0;                     // tickets closed
+    BillId firstBill = 0;                  // bills are firstBill .. firstBill + closed - 1
+    unsigned long long deferredAmount = 0; // INR owed on Deferred bills
+};
+
+// ---- Abandoned-ticket sweeper ----
+enum class AbandonAction { Flag, Close };
+
+struct SweepPolicy {
+    std::chrono::minutes maxAge{24 * 60}; // tickets open this long count as abandoned
+    AbandonAction action = AbandonAction::Close;
+    size_t sliceBudget = 256; // timers/tickets handled per lot-lock hold
+};
+
+struct SweepResult {
+    size_t closed = 0;
+    size_t flagged = 0;
+    unsigned long long amount = 0; // INR billed on Abandoned bills
+};
+
 // ---- Receipt (after payment) ----
 struct Receipt {
     BillId bill{};
@@ -227,98 +511,307 @@ static unique_ptr<IPaymentProcessor> makeProcessor(PaymentMethod m) {
 }
 
 // ---- Services ----
+// How PaymentService serializes access to its bill table. Mutex: each call
+// takes mu_. FlatCombining: calls are delegated through a FlatCombiner, so
+// under exit/pay bursts one thread applies a batch of waiters' operations
+// instead of the lock bouncing between cores. Striped: bills are spread
+// over BILL_STRIPES tables by id, each with its own lock, so calls on
+// different bills rarely contend. In every mode status() reads a bill's
+// status without any lock.
+enum class PaymentConcurrency { Mutex, FlatCombining, Striped };
+
 class PaymentService {
-    unordered_map<BillId, Bill> bills_;
+public:
+    static constexpr size_t BILL_STRIPES = 64;
+
+private:
+    struct alignas(64) BillStripe {
+        mutable EngineMutex mu;
+        BillTable bills{BILL_STRIPES};
+    };
+
+    BillTable bills_;                  // Mutex / FlatCombining
+    BillStripe stripes_[BILL_STRIPES]; // Striped: bill id % BILL_STRIPES
+    AtomicStatusArray status_;         // BillStatus + 1 per bill id, 0 = none
     std::atomic<BillId> nextBill_{1};
-    mutable std::mutex mu_; // guards bills_
+    mutable EngineMutex mu_; // guards bills_ (Mutex mode)
+    mutable FlatCombiner combiner_; // guards bills_ (FlatCombining mode)
+    PaymentConcurrency concurrency_ = PaymentConcurrency::Mutex;
+    const IClock* clock_ = &SystemClock::instance();
+
+    // Runs fn with exclusive access to bills_.
+    template <class F>
+    auto withBills(F&& fn) const -> decltype(fn()) {
+        if (concurrency_ == PaymentConcurrency::FlatCombining) {
+            if (SimScheduler* s = SimScheduler::current()) s->yield(); // keep the scheduling point
+            return combiner_.run(fn);
+        }
+        ProbedLock lk(mu_);
+        return fn();
+    }
+
+    // Runs fn(table) with exclusive access to the table that holds bill `id`.
+    template <class F>
+    auto withBill(BillId id, F&& fn) -> decltype(fn(bills_)) {
+        if (concurrency_ == PaymentConcurrency::Striped) {
+            BillStripe& st = stripes_[id % BILL_STRIPES];
+            ProbedLock lk(st.mu);
+            return fn(st.bills);
+        }
+        return withBills([&] { return fn(bills_); });
+    }
+    template <class F>
+    auto withBill(BillId id, F&& fn) const -> decltype(fn(bills_)) {
+        if (concurrency_ == PaymentConcurrency::Striped) {
+            const BillStripe& st = stripes_[id % BILL_STRIPES];
+            ProbedLock lk(st.mu);
+            return fn(st.bills);
+        }
+        return withBills([&] { return fn(bills_); });
+    }
+
+    // fn(table) on every table, each under its own exclusion.
+    template <class F>
+    void forEachTable(F&& fn) const {
+        if (concurrency_ != PaymentConcurrency::Striped) {
+            withBills([&] { fn(bills_); });
+            return;
+        }
+        for (const BillStripe& st : stripes_) {
+            ProbedLock lk(st.mu);
+            fn(st.bills);
+        }
+    }
+
+    // Caller holds the bill's table.
+    void publish(BillId id, BillStatus st) { status_.store(id, (uint8_t)((int)st + 1)); }
 
 public:
-    Bill createBill(const Ticket& tk,
-                    const string& exitGate,
-                    const FeeBreakup& fb) {
+    static Bill makeBill(BillId id, const Ticket& tk, const string& exitGate, const FeeBreakup& fb,
+                         std::chrono::system_clock::time_point outTime, BillStatus status) {
         Bill b;
-        b.id = nextBill_.fetch_add(1, std::memory_order_relaxed);
+        b.id = id;
         b.ticket = tk.id;
         b.vehicleReg = tk.vehicleReg;
         b.slotId = tk.slotId;
         b.entryGateId = tk.entryGateId;
         b.exitGateId = exitGate;
         b.inTime = tk.inTime;
-        b.outTime = std::chrono::system_clock::now();
+        b.outTime = outTime;
         b.parkedMinutes = fb.parkedMinutes;
         b.billedHours = fb.billedHours;
         b.amount = fb.amount;
-        b.status = BillStatus::Pending;
+        b.discount = fb.discount;
+        b.status = status;
+        return b;
+    }
+
+    void setClock(const IClock& c) { clock_ = &c; }
+
+    // Switch only while the service holds no bills (after reset()) and no
+    // payment calls are in flight.
+    void setConcurrency(PaymentConcurrency c) { concurrency_ = c; }
+    PaymentConcurrency concurrency() const { return concurrency_; }
+    const FlatCombiner& combiner() const { return combiner_; }
 
-        std::lock_guard<std::mutex> lk(mu_);
-        bills_.emplace(b.id, b);
+    Bill createBill(const Ticket& tk,
+                    const string& exitGate,
+                    const FeeBreakup& fb) {
+        TraceSpan span("pay.create_bill", tk.id);
+        Bill b = makeBill(nextBill_.fetch_add(1, std::memory_order_relaxed), tk, exitGate, fb,
+                          clock_->now(), BillStatus::Pending);
+        withBill(b.id, [&](BillTable& bills) {
+            publish(b.id, b.status);
+            bills.insert(Bill(b));
+        });
         return b;
     }
 
+    // Bulk createBill: one id block for the whole batch and one lock per
+    // table touched. Bills get consecutive ids in input order; returns the
+    // first id (0 if empty).
+    BillId createBills(const vector<Ticket>& tks, const vector<FeeBreakup>& fbs,
+                       const string& exitGate, BillStatus status) {
+        if (tks.empty()) return 0;
+        TraceSpan span("pay.create_bills", tks.size());
+        BillId first = nextBill_.fetch_add(tks.size(), std::memory_order_relaxed);
+        auto now = clock_->now();
+
+        auto insert = [&](BillTable& bills, size_t from, size_t step) {
+            for (size_t i = from; i < tks.size(); i += step) {
+                Bill b = makeBill(first + i, tks[i], exitGate, fbs[i], now, status);
+                publish(b.id, b.status);
+                bills.insert(std::move(b));
+            }
+        };
+        if (concurrency_ != PaymentConcurrency::Striped) {
+            withBills([&] {
+                bills_.reserve(first + tks.size());
+                insert(bills_, 0, 1);
+            });
+            return first;
+        }
+        for (size_t k = 0; k < std::min(tks.size(), BILL_STRIPES); ++k) {
+            BillStripe& st = stripes_[(first + k) % BILL_STRIPES];
+            ProbedLock lk(st.mu);
+            insert(st.bills, k, BILL_STRIPES);
+        }
+        return first;
+    }
+
     optional<Bill> get(BillId id) const {
-        std::lock_guard<std::mutex> lk(mu_);
-        auto it = bills_.find(id);
-        if (it == bills_.end()) return nullopt;
-        return it->second;
+        return withBill(id, [&](const BillTable& bills) -> optional<Bill> {
+            const BillHot* b = bills.find(id);
+            if (!b) return nullopt;
+            return bills.bill(*b);
+        });
+    }
+
+    // Lock-free status read. Ids beyond AtomicStatusArray::capacity() fall
+    // back to get().
+    optional<BillStatus> status(BillId id) const {
+        {
+            EpochGuard g; // reset() retires status chunks
+            if (uint8_t v = status_.load(id)) return (BillStatus)(v - 1);
+        }
+        if (id < AtomicStatusArray::capacity()) return nullopt;
+        if (auto b = get(id)) return b->status;
+        return nullopt;
     }
 
     Receipt pay(const PaymentRequest& req) {
-        std::lock_guard<std::mutex> lk(mu_);
-        auto it = bills_.find(req.bill);
-        if (it == bills_.end()) throw runtime_error("Bill not found");
-        Bill& b = it->second;
+        return withBill(req.bill, [&](BillTable& bills) { return pay_nolock(bills, req); });
+    }
+
+    void cancel(BillId id) {
+        withBill(id, [&](BillTable& bills) {
+            BillHot* found = bills.find(id);
+            if (!found) throw runtime_error("Bill not found");
+            BillHot& b = *found;
+            if (b.status == BillStatus::Paid)
+                throw runtime_error("Cannot cancel a paid bill");
+            b.status = BillStatus::Cancelled;
+            publish(b.id, b.status);
+        });
+    }
+
+    // Clears the tables of every mode.
+    void reset() {
+        withBills([&] { bills_.clear(); });
+        for (BillStripe& st : stripes_) {
+            ProbedLock lk(st.mu);
+            st.bills.clear();
+        }
+        status_.clear();
+        nextBill_.store(1, std::memory_order_relaxed);
+    }
+
+    // Fills billTable / billStrings only.
+    MemoryUsage memoryUsage() const {
+        MemoryUsage mu;
+        forEachTable([&](const BillTable& bills) {
+            mu.billTable += bills.heapBytes();
+            mu.billStrings += bills.stringBytes();
+        });
+        mu.billTable += status_.heapBytes();
+        return mu;
+    }
+
+private:
+    Receipt pay_nolock(BillTable& bills, const PaymentRequest& req) {
+        BillHot* found = bills.find(req.bill);
+        if (!found) throw runtime_error("Bill not found");
+        BillHot& b = *found;
 
         if (b.status == BillStatus::Paid) {
             // idempotent: return a “paid” receipt again
-            return Receipt{b.id, b.ticket, b.amount, "ALREADY_PAID", std::chrono::system_clock::now()};
+            return Receipt{b.id, b.ticket, b.amount, "ALREADY_PAID", clock_->now()};
         }
-        if (b.status != BillStatus::Pending)
-            throw runtime_error("Bill is not payable (status != Pending)");
+        if (b.status != BillStatus::Pending && b.status != BillStatus::Deferred &&
+            b.status != BillStatus::Abandoned)
+            throw runtime_error("Bill is not payable (status not Pending/Deferred/Abandoned)");
 
         string reason;
         auto proc = makeProcessor(req.method);
+        ProbeTimer payTimer(PL_PROBE_ENABLED(pay__end));
+        PL_PROBE2(pay__start, b.id, (int)req.method);
+        TraceSpan chargeSpan("pay.charge", b.id);
         bool ok = proc->charge(req, reason);
+        chargeSpan.end();
+        PL_PROBE3(pay__end, b.id, (int)ok, payTimer.elapsed());
         if (!ok) {
             b.status = BillStatus::Failed;
+            publish(b.id, b.status);
+            PL_LOG(LogLevel::Warn, "pay_failed", "bill={} method={} reason={}", b.id, proc->name(), reason);
             throw runtime_error("Payment failed: " + reason);
         }
 
         b.status = BillStatus::Paid;
-        return Receipt{b.id, b.ticket, b.amount, proc->name(), std::chrono::system_clock::now()};
-    }
-
-    void cancel(BillId id) {
-        std::lock_guard<std::mutex> lk(mu_);
-        auto it = bills_.find(id);
-        if (it == bills_.end()) throw runtime_error("Bill not found");
-        if (it->second.status == BillStatus::Paid)
-            throw runtime_error("Cannot cancel a paid bill");
-        it->second.status = BillStatus::Cancelled;
-    }
-       void reset() {
-        std::lock_guard<std::mutex> lk(mu_);
-        bills_.clear();
-        nextBill_.store(1, std::memory_order_relaxed);
+        publish(b.id, b.status);
+        PL_LOG(LogLevel::Info, "pay", "bill={} ticket={} method={} amount={}", b.id, b.ticket, proc->name(), b.amount);
+        return Receipt{b.id, b.ticket, b.amount, proc->name(), clock_->now()};
     }
 };
 
 class ParkingLot {
     vector<Floor> floors_;
-    unordered_map<TicketId, Ticket> active_; // open tickets
+    // slot id -> slot handle, built by configure()
+    using SlotIndex = unordered_map<string, uint64_t, hash<string>, equal_to<string>,
+                                    HugePageAllocator<pair<const string, uint64_t>>>;
+    SlotIndex slotIndex_;
+    // free slots per slot type, lot-wide and per floor (see setSlotFree_nolock)
+    array<uint32_t, MAX_SLOT_TYPES> freeByType_{};
+    vector<array<uint32_t, MAX_SLOT_TYPES>> freeByFloor_;
+    TicketTable active_; // open tickets
+    unordered_map<TicketId, DayPass> passes_;
+    deque<pair<uint32_t, TicketId>> passExpiry_; // (expiresAt, ticket) in purchase order = expiry order
     TicketingService ticketSvc_;
     PaymentService paymentSvc_;
-    mutable std::mutex mu_; // Stage 5: coarse-grained safety
+    mutable EngineMutex mu_; // Stage 5: coarse-grained safety
+    const IClock* clock_ = &SystemClock::instance();
+    std::atomic<bool> evacuating_{false};
+    TimerWheel timers_; // abandoned-ticket deadlines, one timer per open ticket
+    SweepPolicy sweep_;
+    // Read under an EpochGuard; replaced whole, old ones retired (epoch.h).
+    std::atomic<const FeeSchedule*> fees_{new FeeSchedule};
+    std::atomic<const TariffRule*> tariff_{nullptr}; // overrides fees_ when set; same rules
+    CouponBook coupons_;
+    FleetLedger fleet_; // accounts and plates under mu_; kept across configure()
 
 public:
     static ParkingLot& instance() { static ParkingLot inst; return inst; }
     ParkingLot() = default;  
+    ~ParkingLot() {
+        delete fees_.load(std::memory_order_relaxed);
+        delete tariff_.load(std::memory_order_relaxed);
+    }
     ParkingLot(const ParkingLot&) = delete;
     ParkingLot& operator=(const ParkingLot&) = delete;
 
+    // Time source for tickets, fees and bills; set before serving traffic.
+    // The clock must outlive the lot.
+    void setClock(const IClock& c) {
+        std::lock_guard<EngineMutex> lk(mu_);
+        clock_ = &c;
+        ticketSvc_.clock = &c;
+        paymentSvc_.setClock(c);
+        rebuildTimers_nolock();
+    }
+
     // ---------- Stage 1 ----------
+// Holds the lot lock: an AbandonedTicketSweeper may be sweeping meanwhile.
+// A rejected layout throws before anything changes.
 void configure(vector<Floor> fs) {
+    SlotIndex index = buildSlotIndex(fs);
+    std::lock_guard<EngineMutex> lk(mu_);
     floors_ = std::move(fs);
+    slotIndex_ = std::move(index);
     active_.clear();
+    passes_.clear();
+    passExpiry_.clear();
+    countFree_nolock();
+    rebuildTimers_nolock();
+    PL_LOG(LogLevel::Info, "configure", "floors={} slots={}", floors_.size(), slotIndex_.size());
 
     // TicketingService reset
     ticketSvc_.nextId.store(1, std::memory_order_relaxed);
@@ -327,80 +820,510 @@ void configure(vector<Floor> fs) {
     paymentSvc_.reset();
 }
 
-    // ---------- Stage 2 ----------
-    TicketId enterVehicle(const string& entryGate, Vehicle& v) {
-        std::lock_guard<std::mutex> lk(mu_);
-        SlotType need = slotFor(v.type);
+    // Pre-sizes the ticket table for a full lot so the first entries after a
+    // restart do not pay for rehashing.
+    void warmUp() {
+        std::lock_guard<EngineMutex> lk(mu_);
+        active_.reserve(slotIndex_.size());
+    }
+
+    // ---------- Recovery ----------
+    // Open tickets, ordered by id; feed to restoreTickets() after a restart.
+    vector<Ticket> snapshotTickets() const {
+        std::lock_guard<EngineMutex> lk(mu_);
+        vector<Ticket> out;
+        out.reserve(active_.size());
+        active_.forEach([&](const TicketHot& h) { out.push_back(active_.ticket(h)); });
+        sort(out.begin(), out.end(), [](const Ticket& a, const Ticket& b) { return a.id < b.id; });
+        return out;
+    }
 
-        int chosenFloor = -1, idx = -1;
-        for (int f = 0; f < (int)floors_.size(); ++f) {
-            idx = floors_[f].findFreeIndex(need);
-            if (idx != -1) { chosenFloor = f; break; }
+    // Replays open tickets onto a freshly configured lot: re-occupies their
+    // slots and moves ticket numbering past the highest restored id. Every
+    // ticket is checked before any is applied, so a bad batch throws and
+    // leaves the lot as it was.
+    void restoreTickets(vector<Ticket> tickets) {
+        std::lock_guard<EngineMutex> lk(mu_);
+        vector<uint64_t> handles(tickets.size());
+        unordered_set<uint64_t> slotsTaken, idsTaken;
+        for (size_t i = 0; i < tickets.size(); ++i) {
+            const Ticket& tk = tickets[i];
+            ParkingSlot* slot = findSlotById_nolock(tk.slotId, &handles[i]);
+            if (!slot)
+                throw runtime_error("Recovered ticket " + to_string(tk.id) + " references unknown slot " + tk.slotId);
+            if (!slot->isFree || active_.find(tk.id) || !slotsTaken.insert(handles[i]).second ||
+                !idsTaken.insert(tk.id).second)
+                throw runtime_error("Recovered ticket " + to_string(tk.id) + " conflicts with open ticket");
+        }
+        active_.reserve(active_.size() + tickets.size());
+        TicketId maxId = 0;
+        for (size_t i = 0; i < tickets.size(); ++i) {
+            Ticket& tk = tickets[i];
+            uint64_t handle = handles[i];
+            setSlotFree_nolock(handle, false);
+            tk.stype = slotAt_nolock(handle).type;
+            tk.dayPass = false; // passes are not recovered; billed as a normal stay
+            maxId = std::max(maxId, tk.id);
+            scheduleTimer_nolock(active_.insert(std::move(tk), handle));
         }
-        if (chosenFloor == -1) throw runtime_error("No free slot available");
+        if (maxId >= ticketSvc_.nextId.load(std::memory_order_relaxed))
+            ticketSvc_.nextId.store(maxId + 1, std::memory_order_relaxed);
+        PL_LOG(LogLevel::Info, "restore", "tickets={} next_ticket={}", tickets.size(),
+               ticketSvc_.nextId.load(std::memory_order_relaxed));
+    }
 
-        ParkingSlot& slot = floors_[chosenFloor].slots[idx];
-        slot.isFree = false;
+    // ---------- Stage 2 ----------
+    TicketId enterVehicle(const string& entryGate, Vehicle& v) {
+        ProbeTimer enterTimer(PL_PROBE_ENABLED(enter__end));
+        PL_PROBE2(enter__start, entryGate.c_str(), (int)v.type);
+        TraceRequest req("lot.enter");
+        TraceSpan lockWait("lot.lock_wait");
+        ProbedLock lk(mu_);
+        lockWait.end();
+        if (evacuating_.load(std::memory_order_relaxed))
+            throw runtime_error("Lot is evacuating; entry closed");
+        if (!TypeRegistry::instance().isVehicleType(v.type)) throw runtime_error("Unknown vehicle type");
+        int need = (int)slotFor(v.type);
+
+        TraceSpan search("lot.slot_search");
+        uint64_t handle = takeFreeSlot_nolock((SlotType)need);
+        search.end();
+        int chosenFloor = (int)(handle >> 32);
+
+        ParkingSlot& slot = slotAt_nolock(handle);
+        PL_PROBE2(enter__slot, floors_[chosenFloor].floorNo, handle);
 
         Ticket tk = ticketSvc_.openTicket(entryGate, slot, v);
         TicketId tid = tk.id;
-        active_.emplace(tid, std::move(tk));
+        req.setArg(tid);
+        scheduleTimer_nolock(active_.insert(std::move(tk), handle));
+        PL_PROBE4(enter__end, tid, floors_[chosenFloor].floorNo, handle, enterTimer.elapsed());
+        PL_LOG(LogLevel::Info, "enter", "ticket={} gate={} floor={} slot={} vehicle={}",
+               tid, entryGate, floors_[chosenFloor].floorNo, slot.id, v.regNo);
         return tid;
     }
 
+    // ---------- Day passes ----------
+    // Enters on a day pass: the ticket's one bill (FeeSchedule::dayPassHours
+    // at the slot's hourly rate, gate "DAYPASS") is created here, and the
+    // vehicle may exit and reenterVehicle() with the same ticket until
+    // DAY_PASS_MINUTES after purchase. The sweeper leaves a pass ticket
+    // alone until the pass has expired.
+    TicketId enterWithDayPass(const string& entryGate, Vehicle& v) {
+        ProbedLock lk(mu_);
+        if (evacuating_.load(std::memory_order_relaxed))
+            throw runtime_error("Lot is evacuating; entry closed");
+        if (!TypeRegistry::instance().isVehicleType(v.type)) throw runtime_error("Unknown vehicle type");
+        SlotType need = slotFor(v.type);
+        uint64_t handle = takeFreeSlot_nolock(need);
+
+        Ticket tk = ticketSvc_.openTicket(entryGate, slotAt_nolock(handle), v);
+        tk.dayPass = true;
+        FeeBreakup fb;
+        {
+            EpochGuard g;
+            fb = computeDayPassFee(*fees_.load(std::memory_order_acquire), need);
+        }
+        DayPass p;
+        p.bill = paymentSvc_.createBill(tk, "DAYPASS", fb).id;
+        p.expiresAt = (uint32_t)(tickOf(tk.inTime) + DAY_PASS_MINUTES);
+        p.floor = (uint16_t)(handle >> 32);
+        p.vtype = v.type;
+        p.stype = need;
+        p.customerClass = v.customerClass;
+        p.inside = true;
+        TicketId tid = tk.id;
+        passes_.emplace(tid, p);
+        passExpiry_.emplace_back(p.expiresAt, tid);
+        scheduleTimer_nolock(active_.insert(std::move(tk), handle));
+        PL_LOG(LogLevel::Info, "day_pass", "ticket={} gate={} bill={} amount={} vehicle={}",
+               tid, entryGate, p.bill, fb.amount, v.regNo);
+        return tid;
+    }
+
+    // Brings a day-pass vehicle back in on its ticket, on the floor it last
+    // used when that floor has a free slot of its type.
+    void reenterVehicle(TicketId pass, const string& entryGate) {
+        ProbedLock lk(mu_);
+        if (evacuating_.load(std::memory_order_relaxed))
+            throw runtime_error("Lot is evacuating; entry closed");
+        auto it = passes_.find(pass);
+        if (it == passes_.end() || tickOf(clock_->now()) >= it->second.expiresAt)
+            throw runtime_error("Invalid or expired day pass");
+        DayPass& p = it->second;
+        if (p.inside) throw runtime_error("Day pass vehicle is already inside");
+        uint64_t handle = takeFreeSlot_nolock(p.stype, p.floor);
+
+        const ParkingSlot& slot = slotAt_nolock(handle);
+        Ticket tk;
+        tk.id = pass;
+        tk.entryGateId = entryGate;
+        tk.inTime = clock_->now();
+        tk.slotId = slot.id;
+        tk.vtype = p.vtype;
+        tk.stype = p.stype;
+        tk.vehicleReg = paymentSvc_.get(p.bill)->vehicleReg;
+        tk.customerClass = p.customerClass;
+        tk.dayPass = true;
+        p.floor = (uint16_t)(handle >> 32);
+        p.inside = true;
+        scheduleTimer_nolock(active_.insert(std::move(tk), handle));
+        PL_LOG(LogLevel::Info, "reenter", "ticket={} gate={} slot={}", pass, entryGate, slot.id);
+    }
+
     // ---------- Stage 3 (modified for Stage 4) ----------
     // exit -> compute fee -> create Bill (Pending) -> free slot
+    // A non-empty coupon (see loadCoupons) takes its discount off the fee,
+    // not off the lost-ticket penalty; an unknown code fails the exit
+    // before the ticket is touched.
     Bill exitVehicle(TicketId tid, const string& exitGate,
-                     bool lostTicket = false) {
-        using namespace std::chrono;
-
-        std::lock_guard<std::mutex> lk(mu_);
-        auto it = active_.find(tid);
-        if (it == active_.end())
+                     bool lostTicket = false, std::string_view coupon = {}) {
+        ProbeTimer exitTimer(PL_PROBE_ENABLED(exit__bill));
+        TraceRequest req("lot.exit", tid);
+        optional<CouponDiscount> discount;
+        if (!coupon.empty() && !(discount = coupons_.lookup(coupon)))
+            throw runtime_error("Unknown coupon code");
+        TraceSpan lockWait("lot.lock_wait");
+        ProbedLock lk(mu_);
+        lockWait.end();
+        TicketHot* open = active_.find(tid);
+        if (!open)
             throw runtime_error("Invalid or already-closed ticket");
+        auto now = clock_->now();
+        DayPass* pass = nullptr;
+        if (open->dayPass) {
+            pass = &passes_.at(tid);
+            if (tickOf(now) < pass->expiresAt) {
+                Bill bill = passOut_nolock(*open, *pass, exitGate, lostTicket, discount.has_value(), now);
+                PL_PROBE3(exit__bill, tid, bill.id, exitTimer.elapsed());
+                PL_LOG(LogLevel::Info, "exit", "ticket={} gate={} bill={} minutes={} amount={} lost={}",
+                       tid, exitGate, bill.id, bill.parkedMinutes, bill.amount, (int)lostTicket);
+                return bill;
+            }
+        }
 
-        Ticket tk = std::move(it->second);
-        active_.erase(it);
-
-        ParkingSlot* slotPtr = findSlotById_nolock(tk.slotId);
-        if (!slotPtr)
-            throw runtime_error("Slot referenced by ticket not found: " + tk.slotId);
-        slotPtr->isFree = true;
-
-        auto now = system_clock::now();
-        auto mins = duration_cast<minutes>(now - tk.inTime).count();
-        if (mins < 0) mins = 0;
-
-        unique_ptr<IFeeStrategy> strategy = FeeStrategyFactory::make(tk.stype);
-        FeeBreakup fb = strategy->compute(static_cast<unsigned long long>(mins));
+        uint64_t handle = open->slot;
+        Ticket tk = active_.take(*open);
+        timers_.cancel(tk.timer);
+        setSlotFree_nolock(handle, true);
+        PL_PROBE2(exit__found, tid, handle);
+        if (pass) {
+            // expired pass: the overstay is a normal stay from the expiry
+            tk.inTime = std::chrono::system_clock::time_point(std::chrono::minutes(pass->expiresAt));
+            passes_.erase(tid);
+        }
 
-        if (lostTicket) {
-            // Stage 5 add-on: flat penalty on top (configurable)
-            static constexpr unsigned long long LOST_TICKET_PENALTY = 200;
-            fb.amount += LOST_TICKET_PENALTY;
+        auto mins = parkedMinutesBetween(tk.inTime, now);
+
+        TraceSpan feeSpan("lot.fee_compute", tid);
+        FeeBreakup fb;
+        {
+            EpochGuard g;
+            const FeeSchedule& fs = *fees_.load(std::memory_order_acquire);
+            fb = priceStay(fs, tk, mins, now);
+            if (discount) {
+                fb.discount = discount->off(fb.amount);
+                fb.amount -= fb.discount;
+            }
+            // Stage 5 add-on: flat penalty on top
+            if (lostTicket) fb.amount += fs.lostTicketPenalty;
+        }
+        feeSpan.end();
+        PL_PROBE3(exit__fee, tid, fb.parkedMinutes, fb.amount);
+
+        if (auto account = fleet_.accountOf(tk.vehicleReg)) {
+            Bill slip = chargeAccount_nolock(*account, tk, exitGate, fb, now);
+            PL_LOG(LogLevel::Info, "exit_account", "ticket={} gate={} account={} minutes={} amount={}",
+                   tid, exitGate, *account, slip.parkedMinutes, slip.amount);
+            return slip;
         }
 
         // Create pending bill (Payment stage)
         Bill bill = paymentSvc_.createBill(tk, exitGate, fb);
+        PL_PROBE3(exit__bill, tid, bill.id, exitTimer.elapsed());
+        PL_LOG(LogLevel::Info, "exit", "ticket={} gate={} bill={} minutes={} amount={} lost={}",
+               tid, exitGate, bill.id, bill.parkedMinutes, bill.amount, (int)lostTicket);
         return bill;
     }
 
+    // Bill-table concurrency, see PaymentConcurrency. Set before configure();
+    // bills are not moved between tables.
+    void setPaymentConcurrency(PaymentConcurrency c) { paymentSvc_.setConcurrency(c); }
+
+    // Lock-free: never waits on the lot or bill-table locks.
+    optional<BillStatus> billStatus(BillId id) const { return paymentSvc_.status(id); }
+
+    // ---------- Coupons ----------
+    // Replaces the validation/coupon code set; see coupon_table.h. Safe
+    // while exits run: they see the old set or the new one, never a mix.
+    void loadCoupons(vector<CouponCampaign> campaigns, const vector<CouponCode>& codes) {
+        coupons_.load(std::move(campaigns), codes);
+        PL_LOG(LogLevel::Info, "coupons", "codes={} bytes={}", coupons_.size(), coupons_.heapBytes());
+    }
+    optional<CouponDiscount> couponDiscount(std::string_view code) const { return coupons_.lookup(code); }
+
+    // ---------- Tariff ----------
+    // Applies to exits from now on; bills already created keep their
+    // amount. Readers are never blocked: the old schedule is retired and
+    // freed once no quote or exit can still be using it.
+    void setFeeSchedule(const FeeSchedule& fs) {
+        const FeeSchedule* old = fees_.exchange(new FeeSchedule(fs), std::memory_order_acq_rel);
+        EpochDomain::instance().retire(old);
+    }
+    FeeSchedule feeSchedule() const {
+        EpochGuard g;
+        return *fees_.load(std::memory_order_acquire);
+    }
+    // Fee for a stay of `minutes` ending now, under the current tariff
+    // rule or else the schedule; lock-free.
+    FeeBreakup quoteFee(SlotType s, unsigned long long minutes, uint8_t customerClass = 0) const {
+        EpochGuard g;
+        const FeeSchedule& fs = *fees_.load(std::memory_order_acquire);
+        const TariffRule* tr = tariff_.load(std::memory_order_acquire);
+        if (!tr) return computeFee(fs, s, minutes);
+        auto now = clock_->now();
+        return tr->price(s, customerClass, minutes, now - std::chrono::minutes(minutes), now);
+    }
+
+    // Expression tariff (tariff_vm.h) replacing the schedule's hourly rates
+    // and grace period; the lost-ticket penalty and coupons still apply.
+    // Swapped like setFeeSchedule. Throws, keeping the current rule, if
+    // `source` does not compile.
+    void setTariff(const string& source, vector<string> customerClasses = {}, int utcOffsetMinutes = 0) {
+        auto* fresh = new TariffRule(TariffRule::compile(source, std::move(customerClasses), utcOffsetMinutes));
+        const TariffRule* old = tariff_.exchange(fresh, std::memory_order_acq_rel);
+        if (old) EpochDomain::instance().retire(old);
+        PL_LOG(LogLevel::Info, "tariff", "insns={} classes={}", fresh->program.size(),
+               fresh->customerClasses.size());
+    }
+    // Back to the fee schedule alone.
+    void clearTariff() {
+        const TariffRule* old = tariff_.exchange(nullptr, std::memory_order_acq_rel);
+        if (old) EpochDomain::instance().retire(old);
+    }
+    // Id of a customer class of the current rule, for Vehicle::customerClass.
+    uint8_t customerClass(std::string_view name) const {
+        EpochGuard g;
+        const TariffRule* tr = tariff_.load(std::memory_order_acquire);
+        int id = tr ? tr->classId(name) : -1;
+        if (id < 0) throw runtime_error("Unknown customer class: " + string(name));
+        return (uint8_t)id;
+    }
+
+    // ---------- Fleet accounts ----------
+    // Exits of a plate assigned to an account append a charge to the
+    // account's ledger (fleet_ledger.h) and return an OnAccount slip (id 0)
+    // instead of a payable bill. Sweep and evacuation bills and day-pass
+    // purchases stay ordinary bills.
+    FleetAccountId addFleetAccount(const string& name) {
+        std::lock_guard<EngineMutex> lk(mu_);
+        return fleet_.addAccount(name);
+    }
+    void assignFleetPlate(const string& plate, FleetAccountId account) {
+        std::lock_guard<EngineMutex> lk(mu_);
+        fleet_.assignPlate(plate, account);
+    }
+    void unassignFleetPlate(const string& plate) {
+        std::lock_guard<EngineMutex> lk(mu_);
+        fleet_.unassignPlate(plate);
+    }
+    optional<FleetAccountId> fleetAccount(const string& plate) const {
+        std::lock_guard<EngineMutex> lk(mu_);
+        return fleet_.accountOf(plate);
+    }
+    size_t fleetCharges() const { return fleet_.size(); }
+
+    // One invoice per account with charges whose exit falls in [from, to),
+    // by account id. The pass runs on `threads` threads (0: every core)
+    // without the lot lock; exits meanwhile are not included.
+    vector<FleetInvoice> fleetInvoices(std::chrono::system_clock::time_point from,
+                                       std::chrono::system_clock::time_point to, unsigned threads = 0) const {
+        size_t n;
+        vector<string> names;
+        {
+            std::lock_guard<EngineMutex> lk(mu_);
+            n = fleet_.size();
+            names.reserve(fleet_.accounts());
+            for (size_t a = 0; a < fleet_.accounts(); ++a) names.push_back(fleet_.name((FleetAccountId)a));
+        }
+        auto minuteOf = [](std::chrono::system_clock::time_point t) {
+            auto m = std::chrono::duration_cast<std::chrono::minutes>(t.time_since_epoch()).count();
+            return (uint32_t)std::clamp<long long>(m, 0, UINT32_MAX);
+        };
+        vector<FleetInvoice> out = fleet_.aggregate(n, minuteOf(from), minuteOf(to), names.size(), threads);
+        for (auto& inv : out) inv.name = names[inv.account];
+        PL_LOG(LogLevel::Info, "invoices", "charges={} accounts={} invoices={}", n, names.size(), out.size());
+        return out;
+    }
+    // Calendar month `month` (1-12) of `year`, local time at utcOffsetMinutes.
+    vector<FleetInvoice> monthlyInvoices(int year, unsigned month, unsigned threads = 0,
+                                         int utcOffsetMinutes = 0) const {
+        if (month < 1 || month > 12) throw runtime_error("Invalid invoice month");
+        auto start = [&](int y, unsigned m) {
+            return std::chrono::system_clock::time_point(std::chrono::minutes(
+                daysFromCivil(y, m, 1) * 24 * 60 - utcOffsetMinutes));
+        };
+        return fleetInvoices(start(year, month), start(year + (month == 12), month % 12 + 1), threads);
+    }
+
     // ---------- Stage 4 ----------
     Receipt payBill(const PaymentRequest& req) {
         // Payment service is internally locked, no lot-wide lock needed here.
+        TraceRequest span("lot.pay", req.bill);
         return paymentSvc_.pay(req);
     }
 
+    // ---------- Evacuation ----------
+    // While evacuating, enterVehicle() refuses new vehicles; exits and
+    // payments keep working.
+    void beginEvacuation() { evacuating_.store(true); }
+    void endEvacuation()   { evacuating_.store(false); }
+    bool evacuating() const { return evacuating_.load(); }
+
+    // Closes every open ticket in one pass under one lot lock: frees all
+    // slots, then creates one bill per ticket (ticket id order) in a single
+    // batch. Waive bills at zero; Defer computes the normal fee (no
+    // lost-ticket penalty) for later collection. Day-pass vehicles leave
+    // without a bill and may come back on the pass.
+    EvacuationSummary evacuateAll(const string& exitGate, EvacuationBilling billing) {
+        TraceRequest req("lot.evacuate");
+        ProbedLock lk(mu_);
+        vector<Ticket> closing = active_.takeAll();
+        timers_.reset(tickOf(clock_->now()));
+        // every occupied slot belongs to an open ticket
+        for (auto& f : floors_)
+            for (auto& s : f.slots) s.isFree = true;
+        countFree_nolock();
+        dropPassTickets_nolock(closing);
+        return closeTickets_nolock(closing, exitGate, billing);
+    }
+
+    // Same for the listed tickets; ids that are not open are skipped.
+    EvacuationSummary evacuate(const vector<TicketId>& tids, const string& exitGate,
+                               EvacuationBilling billing) {
+        TraceRequest req("lot.evacuate");
+        ProbedLock lk(mu_);
+        vector<Ticket> closing;
+        closing.reserve(tids.size());
+        for (TicketId tid : tids) {
+            TicketHot* open = active_.find(tid);
+            if (!open) continue;
+            setSlotFree_nolock(open->slot, true);
+            timers_.cancel(open->timer);
+            closing.push_back(active_.take(*open));
+        }
+        dropPassTickets_nolock(closing);
+        return closeTickets_nolock(closing, exitGate, billing);
+    }
+
+    // ---------- Abandoned tickets ----------
+    // Takes effect for open tickets too (their deadlines are recomputed).
+    void setSweepPolicy(const SweepPolicy& p) {
+        if (p.sliceBudget == 0) throw runtime_error("Sweep slice budget must be positive");
+        std::lock_guard<EngineMutex> lk(mu_);
+        sweep_ = p;
+        rebuildTimers_nolock();
+    }
+
+    // Flags or closes tickets open for at least maxAge. Due tickets come
+    // from the timer wheel, never from a scan of active_, and the lot lock
+    // is held for at most sliceBudget timers or tickets at a time. Closed
+    // tickets free their slot and get an Abandoned bill (normal fee up to
+    // now) at gate "SWEEP"; flagged ones stay open, see abandonedTickets().
+    // Also forgets expired day passes whose vehicle is out.
+    SweepResult sweepAbandoned() {
+        using namespace std::chrono;
+        TraceRequest req("lot.sweep");
+        vector<TimerWheel::Fired> fired;
+        for (bool caughtUp = false; !caughtUp;) {
+            ProbedLock lk(mu_);
+            size_t from = fired.size();
+            caughtUp = timers_.advance(tickOf(clock_->now()), sweep_.sliceBudget, fired);
+            for (size_t i = from; i < fired.size(); ++i) {
+                TicketHot* open = active_.find(fired[i].id);
+                if (open && open->timer == fired[i].handle) open->timer = 0;
+            }
+        }
+
+        {
+            ProbedLock lk(mu_);
+            purgePasses_nolock(tickOf(clock_->now()));
+        }
+
+        vector<TicketId> due;
+        due.reserve(fired.size());
+        for (const auto& f : fired) due.push_back(f.id);
+        sort(due.begin(), due.end()); // bills in ticket id order
+
+        SweepResult res;
+        EpochGuard feeGuard;
+        for (size_t at = 0; at < due.size();) {
+            ProbedLock lk(mu_);
+            const FeeSchedule& fs = *fees_.load(std::memory_order_acquire);
+            size_t end = std::min(due.size(), at + sweep_.sliceBudget);
+            auto now = clock_->now();
+            vector<Ticket> closing;
+            vector<FeeBreakup> fees;
+            for (; at < end; ++at) {
+                TicketHot* open = active_.find(due[at]);
+                if (!open || open->abandoned) continue;
+                TicketHot& tk = *open;
+                timers_.cancel(tk.timer); // re-armed by adjustInTimeForTest meanwhile
+                tk.timer = 0;
+                if (now - tk.inTime < sweep_.maxAge) { scheduleTimer_nolock(tk); continue; }
+                DayPass* pass = tk.dayPass ? &passes_.at(tk.id) : nullptr;
+                if (pass && tickOf(now) < pass->expiresAt) { scheduleTimer_nolock(tk); continue; }
+                if (sweep_.action == AbandonAction::Flag) {
+                    tk.abandoned = true;
+                    ++res.flagged;
+                    continue;
+                }
+                setSlotFree_nolock(tk.slot, true);
+                if (pass) {
+                    // the overstay is billed from the expiry, as on exit
+                    tk.inTime = std::chrono::system_clock::time_point(std::chrono::minutes(pass->expiresAt));
+                    passes_.erase(tk.id);
+                }
+                auto mins = duration_cast<minutes>(now - tk.inTime).count();
+                fees.push_back(priceStay(fs, tk, (unsigned long long)mins, now));
+                res.amount += fees.back().amount;
+                closing.push_back(active_.take(tk));
+            }
+            paymentSvc_.createBills(closing, fees, "SWEEP", BillStatus::Abandoned);
+            res.closed += closing.size();
+        }
+        if (res.closed || res.flagged)
+            PL_LOG(LogLevel::Warn, "sweep", "closed={} flagged={} amount={}", res.closed, res.flagged, res.amount);
+        return res;
+    }
+
+    // Open tickets the sweeper flagged, ordered by id.
+    vector<TicketId> abandonedTickets() const {
+        std::lock_guard<EngineMutex> lk(mu_);
+        vector<TicketId> out;
+        active_.forEach([&](const TicketHot& h) {
+            if (h.abandoned) out.push_back(h.id);
+        });
+        sort(out.begin(), out.end());
+        return out;
+    }
+
     // ---------- Utility ----------
     void adjustInTimeForTest(TicketId tid, long long minutesBack) {
-        std::lock_guard<std::mutex> lk(mu_);
-        auto it = active_.find(tid);
-        if (it == active_.end()) throw runtime_error("Ticket not found for adjustInTime");
-        it->second.inTime -= std::chrono::minutes(minutesBack);
+        std::lock_guard<EngineMutex> lk(mu_);
+        TicketHot* open = active_.find(tid);
+        if (!open) throw runtime_error("Ticket not found for adjustInTime");
+        TicketHot& tk = *open;
+        tk.inTime -= std::chrono::minutes(minutesBack);
+        if (tk.dayPass) passes_.at(tid).expiresAt -= (uint32_t)minutesBack;
+        if (!tk.abandoned) {
+            timers_.cancel(tk.timer);
+            scheduleTimer_nolock(tk);
+        }
     }
 
     void occupancy(int& freeCnt, int& usedCnt, int& total) const {
-        std::lock_guard<std::mutex> lk(mu_);
+        std::lock_guard<EngineMutex> lk(mu_);
         freeCnt = usedCnt = total = 0;
         for (const auto& f : floors_) {
             for (const auto& s : f.slots) {
@@ -410,37 +1333,434 @@ void configure(vector<Floor> fs) {
         }
     }
 
+    // Free slots of type t, from the per-type counters.
+    int freeSlots(SlotType t) const {
+        std::lock_guard<EngineMutex> lk(mu_);
+        return (int)t < MAX_SLOT_TYPES ? (int)freeByType_[(int)t] : 0;
+    }
+
     size_t activeCount() const {
-        std::lock_guard<std::mutex> lk(mu_);
+        std::lock_guard<EngineMutex> lk(mu_);
         return active_.size();
     }
 
+    // Heap bytes held by the lot, its passes, coupons, fleet ledger and payment
+    // service (see memory_accounting.h).
+    MemoryUsage memoryUsage() const {
+        MemoryUsage mu;
+        {
+            std::lock_guard<EngineMutex> lk(mu_);
+            mu.slotArrays = vectorHeapBytes(floors_) + vectorHeapBytes(freeByFloor_);
+            mu.slotIndex = hashMapHeapBytes(slotIndex_);
+            for (const auto& [sid, h] : slotIndex_) mu.slotIndex += stringHeapBytes(sid);
+            for (const auto& f : floors_) {
+                mu.slotArrays += vectorHeapBytes(f.slots);
+                for (const auto& s : f.slots) mu.slotStrings += stringHeapBytes(s.id);
+            }
+            mu.activeTable = active_.heapBytes() + timers_.heapBytes();
+            mu.ticketStrings = active_.stringBytes();
+            mu.passTable = hashMapHeapBytes(passes_) + dequeHeapBytes(passExpiry_);
+            mu.fleetLedger = fleet_.heapBytes();
+        }
+        mu.couponTable = coupons_.heapBytes();
+        mu += paymentSvc_.memoryUsage();
+        return mu;
+    }
+
 private:
-    ParkingSlot* findSlotById_nolock(const string& sid) {
-        for (auto& f : floors_)
-            for (auto& s : f.slots)
-                if (s.id == sid) return &s;
-        return nullptr;
+    // Wheel ticks are whole minutes since the epoch.
+    static uint64_t tickOf(std::chrono::system_clock::time_point t) {
+        auto m = std::chrono::duration_cast<std::chrono::minutes>(t.time_since_epoch()).count();
+        return m < 0 ? 0 : (uint64_t)m;
+    }
+
+    // Fee for a ticket (Ticket or TicketHot) leaving at `out`: the tariff
+    // rule if one is set, else the schedule. Caller holds an EpochGuard.
+    template <class T>
+    FeeBreakup priceStay(const FeeSchedule& fs, const T& tk, unsigned long long mins,
+                         std::chrono::system_clock::time_point out) const {
+        const TariffRule* tr = tariff_.load(std::memory_order_acquire);
+        return tr ? tr->price(tk.stype, tk.customerClass, mins, tk.inTime, out) : computeFee(fs, tk.stype, mins);
+    }
+
+    // A day-pass ticket is not due before its pass expires.
+    void scheduleTimer_nolock(TicketHot& tk) {
+        uint64_t due = tickOf(tk.inTime + sweep_.maxAge);
+        if (tk.dayPass) due = std::max<uint64_t>(due, passes_.at(tk.id).expiresAt);
+        tk.timer = timers_.schedule(tk.id, due);
+    }
+
+    // After a clock, policy or layout change: restart the wheel at the
+    // current time and re-arm every open, unflagged ticket.
+    void rebuildTimers_nolock() {
+        timers_.reset(tickOf(clock_->now()));
+        active_.forEach([&](TicketHot& tk) {
+            tk.timer = 0;
+            if (!tk.abandoned) scheduleTimer_nolock(tk);
+        });
+    }
+
+    // Fleet exit: the fee goes on the account's ledger; the slip returned
+    // is for the driver and is not stored.
+    Bill chargeAccount_nolock(FleetAccountId account, const Ticket& tk, const string& exitGate,
+                              const FeeBreakup& fb, std::chrono::system_clock::time_point now) {
+        FleetCharge c;
+        c.ticket = tk.id;
+        c.outMinute = (uint32_t)tickOf(now);
+        c.account = account;
+        c.parkedMinutes = (uint32_t)std::min<unsigned long long>(fb.parkedMinutes, UINT32_MAX);
+        c.billedHours = (uint32_t)std::min<unsigned long long>(fb.billedHours, UINT32_MAX);
+        c.amount = fb.amount;
+        fleet_.append(c);
+        return PaymentService::makeBill(0, tk, exitGate, fb, now, BillStatus::OnAccount);
+    }
+
+    // In-validity day-pass exit: checked against the pass record alone, no
+    // fee computed. Returns the pass bill stamped with this exit's gate and
+    // time (the stored bill is unchanged), or for a lost ticket a new
+    // Pending bill for the lost-ticket penalty alone.
+    Bill passOut_nolock(TicketHot& open, DayPass& p, const string& exitGate, bool lostTicket, bool coupon,
+                        std::chrono::system_clock::time_point now) {
+        if (coupon) throw runtime_error("Coupons do not apply to day passes");
+        if (paymentSvc_.status(p.bill) != BillStatus::Paid) throw runtime_error("Day pass not paid");
+        uint64_t handle = open.slot;
+        Ticket tk = active_.take(open); // `open` is gone from here on
+        timers_.cancel(tk.timer);
+        setSlotFree_nolock(handle, true);
+        PL_PROBE2(exit__found, tk.id, handle);
+        p.inside = false;
+        if (lostTicket) {
+            FeeBreakup fb;
+            fb.parkedMinutes = parkedMinutesBetween(tk.inTime, now);
+            {
+                EpochGuard g;
+                fb.amount = fees_.load(std::memory_order_acquire)->lostTicketPenalty;
+            }
+            return paymentSvc_.createBill(tk, exitGate, fb);
+        }
+        Bill b = *paymentSvc_.get(p.bill);
+        b.exitGateId = exitGate;
+        b.outTime = now;
+        return b;
+    }
+
+    // Evacuation: day-pass tickets leave `closing` unbilled; their pass
+    // stays valid.
+    void dropPassTickets_nolock(vector<Ticket>& closing) {
+        closing.erase(std::remove_if(closing.begin(), closing.end(), [&](const Ticket& tk) {
+            if (tk.dayPass) passes_.at(tk.id).inside = false;
+            return tk.dayPass;
+        }), closing.end());
+    }
+
+    // Passes expire in purchase order; an expired pass whose vehicle is
+    // still inside stays until its overstay exit.
+    void purgePasses_nolock(uint64_t nowTick) {
+        while (!passExpiry_.empty() && passExpiry_.front().first <= nowTick) {
+            auto it = passes_.find(passExpiry_.front().second);
+            passExpiry_.pop_front();
+            if (it != passes_.end() && !it->second.inside && it->second.expiresAt <= nowTick)
+                passes_.erase(it);
+        }
+    }
+
+    // Takes a free slot of type `need`, trying floor `preferFloor` first,
+    // and returns its handle; floors without a free slot of the type are
+    // skipped on the counters.
+    uint64_t takeFreeSlot_nolock(SlotType need, int preferFloor = -1) {
+        int t = (int)need;
+        if (freeByType_[t]) {
+            auto tryFloor = [&](int f) -> int {
+                return freeByFloor_[f][t] ? floors_[f].findFreeIndex(need) : -1;
+            };
+            int f = preferFloor, idx = -1;
+            if (f >= 0 && f < (int)floors_.size()) idx = tryFloor(f);
+            if (idx == -1)
+                for (f = 0; f < (int)floors_.size(); ++f)
+                    if ((idx = tryFloor(f)) != -1) break;
+            if (idx != -1) {
+                uint64_t handle = slotHandle(f, idx);
+                setSlotFree_nolock(handle, false);
+                return handle;
+            }
+        }
+        throw runtime_error("No free slot available");
+    }
+
+    EvacuationSummary closeTickets_nolock(vector<Ticket>& closing, const string& exitGate,
+                                          EvacuationBilling billing) {
+        sort(closing.begin(), closing.end(), [](const Ticket& a, const Ticket& b) { return a.id < b.id; });
+
+        EvacuationSummary sum;
+        sum.closed = closing.size();
+        vector<FeeBreakup> fees(closing.size());
+        auto now = clock_->now();
+        EpochGuard g;
+        const FeeSchedule& fs = *fees_.load(std::memory_order_acquire);
+        for (size_t i = 0; i < closing.size(); ++i) {
+            auto mins = parkedMinutesBetween(closing[i].inTime, now);
+            if (billing == EvacuationBilling::Waive) {
+                fees[i].parkedMinutes = mins;
+                continue;
+            }
+            fees[i] = priceStay(fs, closing[i], mins, now);
+            sum.deferredAmount += fees[i].amount;
+        }
+        sum.firstBill = paymentSvc_.createBills(closing, fees, exitGate,
+            billing == EvacuationBilling::Waive ? BillStatus::Waived : BillStatus::Deferred);
+        PL_LOG(LogLevel::Warn, "evacuate", "gate={} tickets={} first_bill={} deferred={} amount={}",
+               exitGate, sum.closed, sum.firstBill, (int)(billing == EvacuationBilling::Defer),
+               sum.deferredAmount);
+        return sum;
+    }
+
+    // Also validates the layout: throws on an unregistered type or a duplicate id.
+    static SlotIndex buildSlotIndex(const vector<Floor>& fs) {
+        SlotIndex index;
+        size_t total = 0;
+        for (const auto& f : fs) total += f.slots.size();
+        index.reserve(total);
+        for (size_t f = 0; f < fs.size(); ++f)
+            for (size_t i = 0; i < fs[f].slots.size(); ++i) {
+                const ParkingSlot& slot = fs[f].slots[i];
+                if (!TypeRegistry::instance().isSlotType(slot.type))
+                    throw runtime_error("Unregistered slot type in layout: " + slot.id);
+                if (!index.emplace(slot.id, slotHandle(f, i)).second)
+                    throw runtime_error("Duplicate slot id in layout: " + slot.id);
+            }
+        return index;
+    }
+
+    void countFree_nolock() {
+        freeByType_.fill(0);
+        freeByFloor_.assign(floors_.size(), {});
+        for (size_t f = 0; f < floors_.size(); ++f)
+            for (const auto& s : floors_[f].slots)
+                if (s.isFree) {
+                    ++freeByFloor_[f][(int)s.type];
+                    ++freeByType_[(int)s.type];
+                }
+    }
+
+    // Every isFree change after configure() goes through here.
+    void setSlotFree_nolock(uint64_t handle, bool free) {
+        ParkingSlot& s = slotAt_nolock(handle);
+        if (s.isFree == free) return;
+        s.isFree = free;
+        uint32_t d = free ? 1 : ~0u; // +1 / -1
+        freeByFloor_[handle >> 32][(int)s.type] += d;
+        freeByType_[(int)s.type] += d;
+    }
+
+    ParkingSlot& slotAt_nolock(uint64_t handle) {
+        return floors_[handle >> 32].slots[handle & 0xffffffffu];
+    }
+
+    // handle (optional) receives the slot handle, see probes.h
+    ParkingSlot* findSlotById_nolock(const string& sid, uint64_t* handle = nullptr) {
+        auto it = slotIndex_.find(sid);
+        if (it == slotIndex_.end()) return nullptr;
+        if (handle) *handle = it->second;
+        return &slotAt_nolock(it->second);
+    }
+};
+
+// Calls ParkingLot::sweepAbandoned() every `interval` on a background
+// thread until stopped or destroyed. threadInit runs first on that thread
+// (e.g. ThreadPlacement::pin(ThreadRole::Io)).
+class AbandonedTicketSweeper {
+    ParkingLot& lot_;
+    std::chrono::milliseconds interval_;
+    std::function<void()> threadInit_;
+    std::mutex m_;
+    std::condition_variable cv_;
+    bool stop_ = false;
+    std::thread th_;
+
+public:
+    AbandonedTicketSweeper(ParkingLot& lot, std::chrono::milliseconds interval,
+                           std::function<void()> threadInit = {})
+        : lot_(lot), interval_(interval), threadInit_(std::move(threadInit)), th_([this] { run(); }) {}
+    AbandonedTicketSweeper(const AbandonedTicketSweeper&) = delete;
+    AbandonedTicketSweeper& operator=(const AbandonedTicketSweeper&) = delete;
+    ~AbandonedTicketSweeper() { stop(); }
+
+    void stop() {
+        {
+            std::lock_guard<std::mutex> lk(m_);
+            stop_ = true;
+        }
+        cv_.notify_all();
+        if (th_.joinable()) th_.join();
+    }
+
+private:
+    void run() {
+        if (threadInit_) threadInit_();
+        std::unique_lock<std::mutex> lk(m_);
+        while (!cv_.wait_for(lk, interval_, [this] { return stop_; })) {
+            lk.unlock();
+            try {
+                lot_.sweepAbandoned();
+            } catch (const std::exception& e) {
+                AsyncLogger::instance().logSync(LogLevel::Error, "sweep_failed", e.what());
+            }
+            lk.lock();
+        }
     }
 };
 
 // ---------- JSON helpers ----------
 static SlotType slotTypeFromString(const string& s) {
-    if (s == "TwoWheeler")  return SlotType::TwoWheeler;
-    if (s == "FourWheeler") return SlotType::FourWheeler;
-    if (s == "Heavy")       return SlotType::Heavy;
-    throw runtime_error("Invalid SlotType in config: " + s);
+    int id = TypeRegistry::instance().findSlotType(s.c_str());
+    if (id < 0) throw runtime_error("Invalid SlotType in config: " + s);
+    return (SlotType)id;
 }
 static const json& must(const json& j, const char* key) {
     if (!j.contains(key))
         throw runtime_error(string("Config missing key: ") + key);
     return j.at(key);
 }
-static vector<Floor> loadConfigFromJson(const string& path) {
+[[maybe_unused]] static const char* vehicleTypeName(VehicleType t) {
+    return TypeRegistry::instance().isVehicleType(t) ? TypeRegistry::instance().name(t) : "Car";
+}
+[[maybe_unused]] static VehicleType vehicleTypeFromString(const string& s) {
+    int id = TypeRegistry::instance().findVehicleType(s.c_str());
+    if (id < 0) throw runtime_error("Invalid VehicleType in recovery log: " + s);
+    return (VehicleType)id;
+}
+
+// Recovery log: the open tickets of a lot, written at checkpoints and
+// replayed with ParkingLot::restoreTickets() on restart.
+[[maybe_unused]] static void saveRecoveryLog(const string& path, const vector<Ticket>& tickets) {
+    using namespace std::chrono;
+    json jt = json::array();
+    for (const auto& tk : tickets) {
+        json e = {{"id", tk.id}, {"slotId", tk.slotId}, {"vehicleReg", tk.vehicleReg},
+                  {"vehicleType", vehicleTypeName(tk.vtype)}, {"entryGateId", tk.entryGateId},
+                  {"inTimeMs", duration_cast<milliseconds>(tk.inTime.time_since_epoch()).count()}};
+        if (tk.customerClass) e["customerClass"] = tk.customerClass;
+        jt.push_back(std::move(e));
+    }
+    ofstream f(path);
+    if (!f) throw runtime_error("Could not open recovery log for writing: " + path);
+    f << json{{"tickets", jt}}.dump() << "\n";
+}
+[[maybe_unused]] static vector<Ticket> loadRecoveryLog(const string& path) {
+    ifstream f(path);
+    if (!f) throw runtime_error("Could not open recovery log: " + path);
+
+    json j; f >> j;
+    const auto& jt = must(j, "tickets");
+    if (!jt.is_array()) throw runtime_error("Recovery log 'tickets' must be an array");
+
+    vector<Ticket> out; out.reserve(jt.size());
+    for (const auto& e : jt) {
+        Ticket tk;
+        tk.id = must(e, "id").get<TicketId>();
+        tk.slotId = must(e, "slotId").get<string>();
+        tk.vehicleReg = must(e, "vehicleReg").get<string>();
+        tk.vtype = vehicleTypeFromString(must(e, "vehicleType").get<string>());
+        tk.stype = slotFor(tk.vtype); // restoreTickets() takes the slot's real type
+        tk.entryGateId = must(e, "entryGateId").get<string>();
+        tk.inTime = std::chrono::system_clock::time_point(
+            std::chrono::milliseconds(must(e, "inTimeMs").get<long long>()));
+        tk.customerClass = e.value("customerClass", (uint8_t)0);
+        out.push_back(std::move(tk));
+    }
+    return out;
+}
+
+// Optional "placement" section; absent keys leave threads unpinned:
+//   "placement": {"memoryNode": 0, "gateCpus": "0-3", "paymentCpus": "4", "ioCpus": "5"}
+[[maybe_unused]] static ThreadPlacement loadPlacementFromJson(const string& path) {
+    ifstream f(path);
+    if (!f) throw runtime_error("Could not open config file: " + path);
+
+    json j; f >> j;
+    ThreadPlacement tp;
+    if (!j.contains("placement")) return tp;
+    const auto& jp = j.at("placement");
+    tp.memoryNode = jp.value("memoryNode", -1);
+    if (tp.memoryNode >= numaNodeCount())
+        throw runtime_error("Config placement.memoryNode " + to_string(tp.memoryNode) + " does not exist");
+    tp.gateCpus = parseCpuList(jp.value("gateCpus", ""));
+    tp.paymentCpus = parseCpuList(jp.value("paymentCpus", ""));
+    tp.ioCpus = parseCpuList(jp.value("ioCpus", ""));
+    return tp;
+}
+
+// Optional "coupons" section; campaigns in order, each with its codes:
+//   "coupons": [{"name": "FOODCOURT", "percentOff": 100, "codes": ["FC-1001", ...]},
+//               {"name": "DIWALI-50", "amountOff": 50, "codes": [...]}]
+// Returns false (outputs untouched) when the section is absent.
+[[maybe_unused]] static bool loadCouponsFromJson(const string& path, vector<CouponCampaign>& campaigns,
+                                                 vector<CouponCode>& codes) {
+    ifstream f(path);
+    if (!f) throw runtime_error("Could not open config file: " + path);
+
+    json j; f >> j;
+    if (!j.contains("coupons")) return false;
+    const auto& jc = j.at("coupons");
+    if (!jc.is_array()) throw runtime_error("Config 'coupons' must be an array");
+    campaigns.clear();
+    codes.clear();
+    for (const auto& e : jc) {
+        CouponCampaign c;
+        c.name = must(e, "name").get<string>();
+        c.discount.percentOff = e.value("percentOff", 0u);
+        c.discount.amountOff = e.value("amountOff", 0ull);
+        const auto& jcodes = must(e, "codes");
+        if (!jcodes.is_array()) throw runtime_error("Config 'codes' must be an array for campaign " + c.name);
+        for (const auto& code : jcodes) codes.push_back(CouponCode{code.get<string>(), (uint16_t)campaigns.size()});
+        campaigns.push_back(std::move(c));
+    }
+    return true;
+}
+
+// Optional "tariff" section, see tariff_vm.h; class names in id order:
+//   "tariff": {"utcOffsetMinutes": 330, "customerClasses": ["regular", "member"],
+//              "rule": "class == member ? 0 : ..."}
+// Returns false (outputs untouched) when the section is absent.
+[[maybe_unused]] static bool loadTariffFromJson(const string& path, string& rule, vector<string>& customerClasses,
+                                                int& utcOffsetMinutes) {
+    ifstream f(path);
+    if (!f) throw runtime_error("Could not open config file: " + path);
+
+    json j; f >> j;
+    if (!j.contains("tariff")) return false;
+    const auto& jt = j.at("tariff");
+    rule = must(jt, "rule").get<string>();
+    customerClasses = jt.value("customerClasses", vector<string>{});
+    utcOffsetMinutes = jt.value("utcOffsetMinutes", 0);
+    return true;
+}
+
+// Optional "slotTypes" / "vehicleTypes" sections, registered before the
+// floors that use them:
+//   "slotTypes": [{"name": "EVCharging", "hourlyRate": 30}],
+//   "vehicleTypes": [{"name": "EVCar", "slotType": "EVCharging"}, {"name": "Bicycle", "slotType": "TwoWheeler"}]
+static void loadTypes(const json& j) {
+    if (j.contains("slotTypes")) {
+        const auto& js = j.at("slotTypes");
+        if (!js.is_array()) throw runtime_error("Config 'slotTypes' must be an array");
+        for (const auto& e : js)
+            registerSlotType(must(e, "name").get<string>(), must(e, "hourlyRate").get<unsigned long long>());
+    }
+    if (j.contains("vehicleTypes")) {
+        const auto& jv = j.at("vehicleTypes");
+        if (!jv.is_array()) throw runtime_error("Config 'vehicleTypes' must be an array");
+        for (const auto& e : jv)
+            registerVehicleType(must(e, "name").get<string>(), slotTypeFromString(must(e, "slotType").get<string>()));
+    }
+}
+
+[[maybe_unused]] static vector<Floor> loadConfigFromJson(const string& path) {
     ifstream f(path);
     if (!f) throw runtime_error("Could not open config file: " + path);
 
     json j; f >> j;
+    loadTypes(j);
 
     const auto& jfloors = must(j, "floors");
     if (!jfloors.is_array()) throw runtime_error("Config 'floors' must be an array");
@@ -469,6 +1789,8 @@ static vector<Floor> loadConfigFromJson(const string& path) {
     return fs;
 }
 
+// Benchmarks and tools #include this file with PARKINGLOT_NO_MAIN defined.
+#ifndef PARKINGLOT_NO_MAIN
 // ---------- Demo helpers ----------
 static void printBill(const Bill& b) {
     using std::chrono::system_clock;
@@ -481,10 +1803,15 @@ static void printBill(const Bill& b) {
     cout << "In : " << std::ctime(&tin);
     cout << "Out: " << std::ctime(&tout);
     cout << "Parked: " << b.parkedMinutes << " mins, Billed: " << b.billedHours << " hour(s)\n";
+    if (b.discount) cout << "Coupon: -INR " << b.discount << "\n";
     cout << "Amount: INR " << b.amount << " | Status: "
          << (b.status==BillStatus::Pending ? "Pending" :
              b.status==BillStatus::Paid ? "Paid" :
-             b.status==BillStatus::Failed ? "Failed" : "Cancelled")
+             b.status==BillStatus::Failed ? "Failed" :
+             b.status==BillStatus::Waived ? "Waived" :
+             b.status==BillStatus::Deferred ? "Deferred" :
+             b.status==BillStatus::Abandoned ? "Abandoned" :
+             b.status==BillStatus::OnAccount ? "On account" : "Cancelled")
          << "\n";
     cout << "------------------\n";
 }
@@ -497,16 +1824,44 @@ static void printReceipt(const Receipt& r) {
     cout << "=================\n";
 }
 
+static LogLevel logLevelFromEnv() {
+    const char* v = std::getenv("PARKINGLOT_LOG");
+    string s = v ? v : "warn";
+    if (s == "debug") return LogLevel::Debug;
+    if (s == "info")  return LogLevel::Info;
+    if (s == "error") return LogLevel::Error;
+    if (s == "off")   return LogLevel::Off;
+    return LogLevel::Warn;
+}
+
 int main() {
+    // PARKINGLOT_TRACE=<path> traces every request and writes a Chrome trace on exit.
+    const char* tracePath = std::getenv("PARKINGLOT_TRACE");
+    if (tracePath) Tracer::instance().enable(1);
     try {
-        // Bootstrap
-        vector<Floor> fs = loadConfigFromJson("parking_config.json");
+        // Bootstrap: lot tables on the configured node, this (gate) thread pinned
+        ThreadPlacement placement = loadPlacementFromJson("parking_config.json");
+        // PARKINGLOT_LOG=debug|info|warn|error|off selects the engine log level (stderr).
+        AsyncLogger::instance().start(stderr, logLevelFromEnv(),
+                                      [placement] { placement.pin(ThreadRole::Io); });
         auto& lot = ParkingLot::instance();
-        lot.configure(std::move(fs));
+        runOnNumaNode(placement.memoryNode, [&] {
+            lot.configure(loadConfigFromJson("parking_config.json"));
+            lot.warmUp();
+        });
+        vector<CouponCampaign> campaigns;
+        vector<CouponCode> codes;
+        if (loadCouponsFromJson("parking_config.json", campaigns, codes)) lot.loadCoupons(std::move(campaigns), codes);
+        string tariffRule;
+        vector<string> customerClasses;
+        int utcOffset = 0;
+        if (loadTariffFromJson("parking_config.json", tariffRule, customerClasses, utcOffset))
+            lot.setTariff(tariffRule, std::move(customerClasses), utcOffset);
+        placement.pin(ThreadRole::Gate);
 
         // Stage 2: entries
-        Bike  b("UP80 HM 8086", VehicleType::Bike);
-        Car   c("DL8CAF1234",   VehicleType::Car);
+        Vehicle b("UP80 HM 8086", VehicleType::Bike);
+        Vehicle c("DL8CAF1234",   VehicleType::Car);
 
         auto tb = lot.enterVehicle("E1", b);
         auto tc = lot.enterVehicle("E2", c);
@@ -549,10 +1904,20 @@ int main() {
         auto rd = lot.payBill(PaymentRequest{bd.id, bd.amount, PaymentMethod::UPI, "", "anil@upi"});
         printReceipt(rd);
 
+        // Shop validation stamp: food-court code from the config's coupons
+        if (lot.couponDiscount("FC-1001")) {
+            auto te = lot.enterVehicle("E1", c);
+            lot.adjustInTimeForTest(te, 150); // 2h30m -> 3h for 4W
+            Bill be = lot.exitVehicle(te, "X1", false, "FC-1001");
+            printBill(be);
+        }
+
+        if (tracePath) Tracer::instance().dumpChromeTrace(tracePath);
     } catch (const std::exception& e) {
-        cerr << "[FATAL] " << e.what() << "\n";
+        AsyncLogger::instance().stop();
+        AsyncLogger::instance().logSync(LogLevel::Error, "fatal", e.what());
         return 1;
     }
+    AsyncLogger::instance().stop();
 }
-
-
+#endif // PARKINGLOT_NO_MAIN
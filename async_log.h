@@ -0,0 +1,321 @@
+#pragma once
+// ===================== Asynchronous structured logging =====================
+// Binary, deferred-formatting logger for engine events.
+//
+//   PL_LOG(LogLevel::Info, "enter", "ticket={} gate={} slot={}", tid, gate, slotId);
+//
+// The call site copies a timestamp, a pointer to its static LogSite and the
+// raw arguments (integers, doubles, strings truncated to 23 bytes) into the
+// calling thread's single-producer ring; no formatting, no locks, no
+// allocation. A background writer drains all rings and renders logfmt
+// lines. A full ring drops the record and counts it (dropped()).
+// Until start() is called PL_LOG costs one relaxed atomic load.
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+enum class LogLevel : std::uint8_t { Debug, Info, Warn, Error, Off };
+
+inline const char* logLevelName(LogLevel l) {
+    switch (l) {
+        case LogLevel::Debug: return "DEBUG";
+        case LogLevel::Info:  return "INFO";
+        case LogLevel::Warn:  return "WARN";
+        case LogLevel::Error: return "ERROR";
+        case LogLevel::Off:   return "OFF";
+    }
+    return "?";
+}
+
+struct LogSite {
+    LogLevel level;
+    const char* event;
+    const char* fmt; // "key={} key={}", one {} per argument
+};
+
+struct LogArg {
+    enum Kind : std::uint8_t { U64, I64, F64, Str } kind = U64;
+    std::uint8_t len = 0;
+    union {
+        std::uint64_t u;
+        std::int64_t i;
+        double d;
+        char s[23];
+    };
+    LogArg() : u(0) {}
+};
+
+struct LogRecord {
+    static constexpr int MAX_ARGS = 6;
+    std::uint64_t tsNs = 0; // system_clock, ns since epoch
+    const LogSite* site = nullptr;
+    std::uint8_t nargs = 0;
+    LogArg args[MAX_ARGS];
+};
+
+namespace log_detail {
+template <class T>
+inline void encode(LogArg& a, const T& v) {
+    if constexpr (std::is_floating_point<T>::value) { a.kind = LogArg::F64; a.d = (double)v; }
+    else if constexpr (std::is_enum<T>::value) { a.kind = LogArg::I64; a.i = (std::int64_t)v; }
+    else if constexpr (std::is_signed<T>::value) { a.kind = LogArg::I64; a.i = (std::int64_t)v; }
+    else { a.kind = LogArg::U64; a.u = (std::uint64_t)v; }
+}
+inline void encodeStr(LogArg& a, const char* s, std::size_t n) {
+    a.kind = LogArg::Str;
+    a.len = (std::uint8_t)(n < sizeof(a.s) ? n : sizeof(a.s));
+    std::memcpy(a.s, s, a.len);
+}
+inline void encode(LogArg& a, const std::string& s) { encodeStr(a, s.data(), s.size()); }
+inline void encode(LogArg& a, const char* s) { encodeStr(a, s, std::strlen(s)); }
+} // namespace log_detail
+
+class AsyncLogger {
+public:
+    static constexpr std::size_t RING_CAPACITY = 1024; // records per thread, power of two
+
+    static AsyncLogger& instance() { static AsyncLogger l; return l; }
+
+    bool enabled(LogLevel l) const {
+        return (std::uint8_t)l >= minLevel_.load(std::memory_order_relaxed);
+    }
+
+    // Starts the writer thread; `out` must stay open until stop().
+    // threadInit runs first on the writer thread (e.g. CPU pinning).
+    void start(std::FILE* out, LogLevel minLevel = LogLevel::Info,
+               std::function<void()> threadInit = {}) {
+        std::lock_guard<std::mutex> lk(ctlMu_);
+        if (writer_.joinable()) return;
+        out_ = out;
+        running_.store(true);
+        writer_ = std::thread([this, init = std::move(threadInit)] {
+            if (init) init();
+            writerLoop();
+        });
+        minLevel_.store((std::uint8_t)minLevel, std::memory_order_relaxed);
+    }
+
+    // Disables logging, drains every ring and joins the writer.
+    void stop() {
+        std::lock_guard<std::mutex> lk(ctlMu_);
+        minLevel_.store((std::uint8_t)LogLevel::Off, std::memory_order_relaxed);
+        if (!writer_.joinable()) return;
+        running_.store(false);
+        writer_.join();
+        std::fflush(out_);
+    }
+
+    std::uint64_t dropped() const { return dropped_.load(std::memory_order_relaxed); }
+
+    // Slow path for rare, long messages (fatal errors): formats and writes
+    // immediately, even when the logger is not started. Not for hot paths.
+    void logSync(LogLevel level, const char* event, const std::string& msg) {
+        std::lock_guard<std::mutex> lk(ctlMu_);
+        std::time_t secs = std::time(nullptr);
+        std::tm tm{};
+        gmtime_r(&secs, &tm);
+        char ts[32];
+        std::strftime(ts, sizeof(ts), "%Y-%m-%dT%H:%M:%SZ", &tm);
+        std::fprintf(out_, "%s level=%s event=%s msg=\"%s\"\n", ts, logLevelName(level), event, msg.c_str());
+        std::fflush(out_);
+    }
+
+    template <class... Args>
+    void log(const LogSite* site, const Args&... args) {
+        static_assert(sizeof...(Args) <= LogRecord::MAX_ARGS, "too many log arguments");
+        Ring& r = local();
+        std::uint64_t head = r.head.load(std::memory_order_relaxed);
+        if (head - r.tail.load(std::memory_order_acquire) >= RING_CAPACITY) {
+            dropped_.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        LogRecord& rec = r.records[head & (RING_CAPACITY - 1)];
+        rec.tsNs = (std::uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count();
+        rec.site = site;
+        rec.nargs = (std::uint8_t)sizeof...(Args);
+        int i = 0;
+        (log_detail::encode(rec.args[i++], args), ...);
+        r.head.store(head + 1, std::memory_order_release);
+    }
+
+    ~AsyncLogger() { stop(); }
+
+private:
+    struct Ring {
+        std::atomic<std::uint64_t> head{0}; // written by the owning thread
+        char pad[64 - sizeof(std::atomic<std::uint64_t>)];
+        std::atomic<std::uint64_t> tail{0}; // written by the writer
+        std::vector<LogRecord> records = std::vector<LogRecord>(RING_CAPACITY);
+        std::atomic<bool> abandoned{false}; // owning thread has exited; head is final
+    };
+
+    // Thread-local owner of a ring; marks it abandoned when the thread exits.
+    struct RingOwner {
+        std::shared_ptr<Ring> ring;
+        ~RingOwner() { if (ring) ring->abandoned.store(true, std::memory_order_release); }
+    };
+
+    AsyncLogger() = default;
+
+    // A ring outlives its thread until the writer has drained it, so nothing
+    // is lost; drainAll() then unregisters it and the memory goes with it.
+    Ring& local() {
+        thread_local RingOwner owner;
+        if (!owner.ring) {
+            auto r = std::make_shared<Ring>();
+            std::lock_guard<std::mutex> lk(ringsMu_);
+            rings_.push_back(r);
+            owner.ring = std::move(r);
+        }
+        return *owner.ring;
+    }
+
+    void writerLoop() {
+        std::string line;
+        int idle = 0;
+        for (;;) {
+            bool stopping = !running_.load();
+            std::size_t n = drainAll(line);
+            if (n == 0) {
+                if (stopping) break;
+                // back off while idle; the hot path never waits on the writer
+                std::this_thread::sleep_for(std::chrono::microseconds(idle < 10 ? 50 : 1000));
+                ++idle;
+            } else {
+                idle = 0;
+            }
+        }
+    }
+
+    std::size_t drainAll(std::string& line) {
+        std::vector<std::shared_ptr<Ring>> rings;
+        {
+            std::lock_guard<std::mutex> lk(ringsMu_);
+            rings = rings_;
+        }
+        std::size_t n = 0;
+        bool reap = false;
+        for (auto& r : rings) {
+            // read before head: once set, the owner's last head store is visible
+            bool abandoned = r->abandoned.load(std::memory_order_acquire);
+            std::uint64_t tail = r->tail.load(std::memory_order_relaxed);
+            std::uint64_t head = r->head.load(std::memory_order_acquire);
+            for (; tail != head; ++tail, ++n) {
+                format(r->records[tail & (RING_CAPACITY - 1)], line);
+                std::fwrite(line.data(), 1, line.size(), out_);
+            }
+            r->tail.store(tail, std::memory_order_release);
+            reap |= abandoned;
+        }
+        if (n) std::fflush(out_);
+        if (reap) {
+            std::lock_guard<std::mutex> lk(ringsMu_);
+            rings_.erase(std::remove_if(rings_.begin(), rings_.end(),
+                                        [](const std::shared_ptr<Ring>& r) {
+                                            return r->abandoned.load(std::memory_order_acquire) &&
+                                                   r->tail.load(std::memory_order_relaxed) ==
+                                                       r->head.load(std::memory_order_acquire);
+                                        }),
+                         rings_.end());
+        }
+        return n;
+    }
+
+    static void format(const LogRecord& rec, std::string& out) {
+        out.clear();
+        std::time_t secs = (std::time_t)(rec.tsNs / 1000000000ULL);
+        std::tm tm{};
+        gmtime_r(&secs, &tm);
+        char ts[64];
+        std::size_t len = std::strftime(ts, sizeof(ts), "%Y-%m-%dT%H:%M:%S", &tm);
+        std::snprintf(ts + len, sizeof(ts) - len, ".%06lluZ",
+                      (unsigned long long)(rec.tsNs % 1000000000ULL / 1000));
+        out += ts;
+        out += " level=";
+        out += logLevelName(rec.site->level);
+        out += " event=";
+        out += rec.site->event;
+        out += ' ';
+        int arg = 0;
+        for (const char* p = rec.site->fmt; *p; ++p) {
+            if (p[0] == '{' && p[1] == '}' && arg < rec.nargs) {
+                appendArg(rec.args[arg++], out);
+                ++p;
+            } else {
+                out += *p;
+            }
+        }
+        out += '\n';
+    }
+
+    static void appendArg(const LogArg& a, std::string& out) {
+        char buf[32];
+        switch (a.kind) {
+            case LogArg::U64: std::snprintf(buf, sizeof(buf), "%llu", (unsigned long long)a.u); out += buf; break;
+            case LogArg::I64: std::snprintf(buf, sizeof(buf), "%lld", (long long)a.i); out += buf; break;
+            case LogArg::F64: std::snprintf(buf, sizeof(buf), "%g", a.d); out += buf; break;
+            case LogArg::Str: appendStr(a.s, a.len, out); break;
+        }
+    }
+
+    // logfmt value: quoted when empty or holding a space, '"', '=', a backslash or a
+    // control character; inside quotes '"' and backslashes are escaped, and
+    // control characters written as \n, \r, \t or \xNN, so a value can never
+    // end the line or start another key.
+    static void appendStr(const char* s, std::size_t len, std::string& out) {
+        bool quote = len == 0;
+        for (std::size_t i = 0; i < len && !quote; ++i)
+            quote = s[i] == ' ' || s[i] == '"' || s[i] == '=' || s[i] == '\\' || (unsigned char)s[i] < 0x20;
+        if (!quote) { out.append(s, len); return; }
+        out += '"';
+        for (std::size_t i = 0; i < len; ++i) {
+            unsigned char c = (unsigned char)s[i];
+            switch (c) {
+                case '"':  out += "\\\""; break;
+                case '\\': out += "\\\\"; break;
+                case '\n': out += "\\n"; break;
+                case '\r': out += "\\r"; break;
+                case '\t': out += "\\t"; break;
+                default:
+                    if (c < 0x20) {
+                        char buf[8];
+                        std::snprintf(buf, sizeof(buf), "\\x%02x", c);
+                        out += buf;
+                    } else {
+                        out += (char)c;
+                    }
+            }
+        }
+        out += '"';
+    }
+
+    std::atomic<std::uint8_t> minLevel_{(std::uint8_t)LogLevel::Off};
+    std::atomic<bool> running_{false};
+    std::atomic<std::uint64_t> dropped_{0};
+    std::mutex ctlMu_;   // start/stop
+    std::mutex ringsMu_; // guards rings_ (registration, writer snapshot and reaping)
+    std::vector<std::shared_ptr<Ring>> rings_;
+    std::FILE* out_ = stderr;
+    std::thread writer_;
+};
+
+#define PL_LOG(level, event, fmt, ...)                                               \
+    do {                                                                             \
+        if (AsyncLogger::instance().enabled(level)) {                                \
+            static const LogSite pl_log_site_{level, event, fmt};                    \
+            AsyncLogger::instance().log(&pl_log_site_, ##__VA_ARGS__);               \
+        }                                                                            \
+    } while (0)
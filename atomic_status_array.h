@@ -0,0 +1,73 @@
+#pragma once
+// ===================== Atomic status array =====================
+// One byte of state per dense id (bill ids), readable without any lock.
+// A fixed directory points at 16KB chunks that are allocated on first
+// store and installed with a CAS; loads are two acquire reads. clear()
+// unlinks the chunks and retires them through the epoch domain (epoch.h),
+// so load() must run inside an EpochGuard. Ids past capacity() are not
+// stored and load as 0; callers treat 0 as "unknown".
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+#include "epoch.h"
+
+class AtomicStatusArray {
+public:
+    static constexpr unsigned CHUNK_BITS = 14;
+    static constexpr std::size_t CHUNK = std::size_t(1) << CHUNK_BITS; // ids per chunk
+    static constexpr std::size_t DIR = 4096;                           // chunks
+
+    AtomicStatusArray() {
+        for (auto& d : dir_) d.store(nullptr, std::memory_order_relaxed);
+    }
+    AtomicStatusArray(const AtomicStatusArray&) = delete;
+    AtomicStatusArray& operator=(const AtomicStatusArray&) = delete;
+    ~AtomicStatusArray() {
+        for (auto& d : dir_) delete[] d.load(std::memory_order_relaxed);
+    }
+
+    static constexpr std::uint64_t capacity() { return (std::uint64_t)CHUNK * DIR; }
+
+    // Caller holds an EpochGuard.
+    std::uint8_t load(std::uint64_t id) const {
+        if (id >= capacity()) return 0;
+        const Cell* c = dir_[id >> CHUNK_BITS].load(std::memory_order_acquire);
+        return c ? c[id & (CHUNK - 1)].load(std::memory_order_acquire) : 0;
+    }
+
+    void store(std::uint64_t id, std::uint8_t v) {
+        if (id >= capacity()) return;
+        chunk(id >> CHUNK_BITS)[id & (CHUNK - 1)].store(v, std::memory_order_release);
+    }
+
+    // Every id back to 0. Not concurrent with store(); loads may overlap.
+    void clear() {
+        for (auto& d : dir_)
+            if (Cell* c = d.exchange(nullptr, std::memory_order_acq_rel))
+                EpochDomain::instance().retire(c, [](void* p) { delete[] static_cast<Cell*>(p); });
+    }
+
+    std::size_t heapBytes() const {
+        std::size_t n = 0;
+        for (auto& d : dir_)
+            if (d.load(std::memory_order_relaxed)) n += CHUNK * sizeof(Cell);
+        return n;
+    }
+
+private:
+    using Cell = std::atomic<std::uint8_t>;
+
+    Cell* chunk(std::size_t k) {
+        Cell* c = dir_[k].load(std::memory_order_acquire);
+        if (c) return c;
+        Cell* fresh = new Cell[CHUNK];
+        for (std::size_t i = 0; i < CHUNK; ++i) fresh[i].store(0, std::memory_order_relaxed);
+        if (dir_[k].compare_exchange_strong(c, fresh, std::memory_order_acq_rel)) return fresh;
+        delete[] fresh; // another writer installed it first
+        return c;
+    }
+
+    std::atomic<Cell*> dir_[DIR];
+};
@@ -0,0 +1,147 @@
+// ===================== Benchmarks =====================
+// enter / exit / pay / occupancy loops and a bulk evacuation of a full lot
+// (per closed ticket) with ns/op and, where the kernel
+// allows perf_event_open, hardware counters per op.
+//
+//   g++ -std=c++17 -O2 -pthread bench.cc -o parking_bench
+//   ./parking_bench [--slots N] [--floors F] [--reps R] [--json results.json]
+//
+// --json writes every repetition plus build/machine tags; compare two
+// result files with bench_compare.
+
+#define PARKINGLOT_NO_MAIN
+#define BENCH_MAIN
+#include "Parkinglot.cc"
+#include "bench_util.h"
+
+struct BenchConfig {
+    int slots = 4096;  // total FourWheeler slots
+    int floors = 8;
+    int reps = 5;
+    string jsonPath;
+};
+
+static vector<Floor> benchLayout(const BenchConfig& cfg) {
+    vector<Floor> fs(cfg.floors);
+    int perFloor = (cfg.slots + cfg.floors - 1) / cfg.floors;
+    for (int f = 0; f < cfg.floors; ++f) {
+        fs[f].floorNo = f + 1;
+        for (int i = 0; i < perFloor; ++i)
+            fs[f].slots.push_back(ParkingSlot{"F" + to_string(f + 1) + "-S" + to_string(i + 1),
+                                              SlotType::FourWheeler, true});
+    }
+    return fs;
+}
+
+static json runsToJson(const vector<Measurement>& runs) {
+    json j;
+    j["ops"] = runs.empty() ? 0 : runs.front().ops;
+    json ns = json::array(), allocs = json::array();
+    for (const auto& m : runs) { ns.push_back(m.nsPerOp); allocs.push_back(m.allocsPerOp); }
+    j["ns_per_op"] = ns;
+    j["allocs_per_op"] = allocs;
+    Measurement med = medianOf(runs);
+    json counters = json::object();
+    for (int k = 0; k < PerfCounters::COUNT; ++k)
+        if (med.perOp.ok[k]) counters[PerfCounters::name(k)] = med.perOp.v[k];
+    j["counters_per_op"] = counters;
+    return j;
+}
+
+static void writeJson(const BenchConfig& cfg, const vector<pair<string, vector<Measurement>>>& results) {
+    BenchEnv env = benchEnv();
+    json j;
+    j["schema"] = 1;
+    j["build"] = {{"compiler", env.compiler}, {"flags", env.buildFlags}, {"git", env.gitRev}};
+    j["machine"] = {{"hostname", env.hostname}, {"kernel", env.kernel},
+                    {"cpu", env.cpu}, {"cores", env.cores}};
+    j["config"] = {{"slots", cfg.slots}, {"floors", cfg.floors}, {"reps", cfg.reps}};
+    json b = json::object();
+    for (const auto& [name, runs] : results) b[name] = runsToJson(runs);
+    j["benchmarks"] = b;
+
+    ofstream f(cfg.jsonPath);
+    if (!f) throw runtime_error("Could not open results file: " + cfg.jsonPath);
+    f << j.dump(2) << "\n";
+}
+
+int main(int argc, char** argv) {
+    BenchConfig cfg;
+    for (BenchArgs args(argc, argv); args.next();) {
+        const string& a = args.flag();
+        int v = args.intValue();
+        if      (a == "--slots")  cfg.slots = v;
+        else if (a == "--floors") cfg.floors = v;
+        else if (a == "--reps")   cfg.reps = v;
+        else if (a == "--json")   cfg.jsonPath = args.value();
+        else { cerr << "unknown option " << a << "\n"; return 2; }
+    }
+    if (cfg.slots <= 0 || cfg.floors <= 0 || cfg.reps <= 0) {
+        cerr << "--slots, --floors and --reps must be positive\n";
+        return 2;
+    }
+
+    PerfCounters pc;
+    if (!pc.available())
+        cerr << "[bench] hardware counters unavailable (check perf_event_paranoid); timing only\n";
+
+    vector<Vehicle> cars;
+    for (int i = 0; i < cfg.slots; ++i) cars.emplace_back("CAR" + to_string(i), VehicleType::Car);
+
+    vector<Measurement> enterRuns, exitRuns, payRuns, occRuns, evacRuns;
+    try {
+        for (int r = 0; r < cfg.reps; ++r) {
+            ParkingLot lot;
+            lot.configure(benchLayout(cfg));
+            uint64_t n = (uint64_t)cfg.slots;
+
+            vector<TicketId> tickets(n);
+            enterRuns.push_back(timeLoop(pc, n, [&](uint64_t i) {
+                tickets[i] = lot.enterVehicle("E1", cars[i]);
+            }));
+
+            int freeC, usedC, total;
+            occRuns.push_back(timeLoop(pc, 1000, [&](uint64_t) {
+                lot.occupancy(freeC, usedC, total);
+                doNotOptimize(freeC);
+            }));
+
+            vector<Bill> bills(n);
+            exitRuns.push_back(timeLoop(pc, n, [&](uint64_t i) {
+                bills[i] = lot.exitVehicle(tickets[i], "X1");
+            }));
+
+            payRuns.push_back(timeLoop(pc, n, [&](uint64_t i) {
+                auto rc = lot.payBill(PaymentRequest{bills[i].id, bills[i].amount, PaymentMethod::Cash, "", ""});
+                doNotOptimize(rc.amount);
+            }));
+
+            for (uint64_t i = 0; i < n; ++i) lot.enterVehicle("E1", cars[i]);
+            evacRuns.push_back(timeBatch(pc, n, [&] {
+                auto sum = lot.evacuateAll("X1", EvacuationBilling::Defer);
+                doNotOptimize(sum.closed);
+            }));
+        }
+    } catch (const std::exception& e) {
+        cerr << "[FATAL] " << e.what() << "\n";
+        return 1;
+    }
+
+    printf("slots=%d floors=%d reps=%d (median run)\n", cfg.slots, cfg.floors, cfg.reps);
+    printHeader();
+    printRow("enter", medianOf(enterRuns));
+    printRow("exit", medianOf(exitRuns));
+    printRow("pay", medianOf(payRuns));
+    printRow("occupancy", medianOf(occRuns));
+    printRow("evacuate", medianOf(evacRuns));
+
+    if (!cfg.jsonPath.empty()) {
+        try {
+            writeJson(cfg, {{"enter", enterRuns}, {"exit", exitRuns},
+                            {"pay", payRuns}, {"occupancy", occRuns}, {"evacuate", evacRuns}});
+        } catch (const std::exception& e) {
+            cerr << "[FATAL] " << e.what() << "\n";
+            return 1;
+        }
+    }
+}
@@ -0,0 +1,170 @@
+// ===================== Benchmark comparison =====================
+// Compares two parking_bench --json result files and flags regressions.
+//
+//   g++ -std=c++17 -O2 bench_compare.cc -o bench_compare
+//   ./bench_compare base.json new.json [--threshold 5] [--alpha 0.05]
+//
+// ns/op: Welch's t-test over the per-repetition samples; a benchmark is a
+// REGRESSION when the mean got slower by more than --threshold percent and
+// the difference is significant at --alpha. allocs/op is deterministic, so
+// any increase of the median is flagged. Exit status 1 if anything regressed.
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <nlohmann/json.hpp>
+
+#include "bench_util.h"
+
+using json = nlohmann::json;
+using namespace std;
+
+struct Stats {
+    double mean = 0, var = 0, median = 0;
+    size_t n = 0;
+};
+
+static Stats statsOf(vector<double> xs) {
+    Stats s;
+    s.n = xs.size();
+    if (xs.empty()) return s;
+    for (double x : xs) s.mean += x;
+    s.mean /= (double)s.n;
+    for (double x : xs) s.var += (x - s.mean) * (x - s.mean);
+    s.var = s.n > 1 ? s.var / (double)(s.n - 1) : 0.0;
+    sort(xs.begin(), xs.end());
+    s.median = xs[xs.size() / 2];
+    return s;
+}
+
+// Continued fraction for the regularized incomplete beta (Lentz's method).
+static double betacf(double a, double b, double x) {
+    const double EPS = 1e-12, TINY = 1e-300;
+    double qab = a + b, qap = a + 1, qam = a - 1;
+    double c = 1, d = 1 - qab * x / qap;
+    if (fabs(d) < TINY) d = TINY;
+    d = 1 / d;
+    double h = d;
+    for (int m = 1; m <= 200; ++m) {
+        int m2 = 2 * m;
+        double aa = m * (b - m) * x / ((qam + m2) * (a + m2));
+        d = 1 + aa * d; if (fabs(d) < TINY) d = TINY;
+        c = 1 + aa / c; if (fabs(c) < TINY) c = TINY;
+        d = 1 / d; h *= d * c;
+        aa = -(a + m) * (qab + m) * x / ((a + m2) * (qap + m2));
+        d = 1 + aa * d; if (fabs(d) < TINY) d = TINY;
+        c = 1 + aa / c; if (fabs(c) < TINY) c = TINY;
+        d = 1 / d;
+        double del = d * c;
+        h *= del;
+        if (fabs(del - 1) < EPS) break;
+    }
+    return h;
+}
+
+static double incompleteBeta(double a, double b, double x) {
+    if (x <= 0) return 0;
+    if (x >= 1) return 1;
+    double bt = exp(lgamma(a + b) - lgamma(a) - lgamma(b) + a * log(x) + b * log(1 - x));
+    if (x < (a + 1) / (a + b + 2)) return bt * betacf(a, b, x) / a;
+    return 1 - bt * betacf(b, a, 1 - x) / b;
+}
+
+// Two-sided p-value of Welch's t-test.
+static double welchPValue(const Stats& a, const Stats& b) {
+    if (a.n < 2 || b.n < 2) return 1.0;
+    double va = a.var / (double)a.n, vb = b.var / (double)b.n;
+    if (va + vb == 0) return a.mean == b.mean ? 1.0 : 0.0;
+    double t = (b.mean - a.mean) / sqrt(va + vb);
+    double df = (va + vb) * (va + vb) /
+                (va * va / (double)(a.n - 1) + vb * vb / (double)(b.n - 1));
+    return incompleteBeta(df / 2, 0.5, df / (df + t * t));
+}
+
+static json loadResults(const string& path) {
+    ifstream f(path);
+    if (!f) throw runtime_error("Could not open results file: " + path);
+    json j; f >> j;
+    if (!j.contains("benchmarks")) throw runtime_error("Not a benchmark result file: " + path);
+    return j;
+}
+
+static vector<double> samples(const json& bench, const char* key) {
+    vector<double> xs;
+    if (bench.contains(key))
+        for (const auto& v : bench.at(key)) xs.push_back(v.get<double>());
+    return xs;
+}
+
+static void warnIfDifferent(const json& a, const json& b, const char* section, const char* key) {
+    auto va = a.value(section, json::object()).value(key, json());
+    auto vb = b.value(section, json::object()).value(key, json());
+    if (va != vb)
+        cerr << "[compare] warning: " << section << "." << key << " differs: "
+             << va.dump() << " vs " << vb.dump() << "\n";
+}
+
+int main(int argc, char** argv) {
+    if (argc < 3) {
+        cerr << "usage: bench_compare base.json new.json [--threshold pct] [--alpha p]\n";
+        return 2;
+    }
+    double thresholdPct = 5.0, alpha = 0.05;
+    for (BenchArgs args(argc, argv, 3); args.next();) {
+        const string& a = args.flag();
+        if      (a == "--threshold") thresholdPct = args.doubleValue();
+        else if (a == "--alpha")     alpha = args.doubleValue();
+        else { cerr << "unknown option " << a << "\n"; return 2; }
+    }
+
+    try {
+        json base = loadResults(argv[1]);
+        json cur  = loadResults(argv[2]);
+        warnIfDifferent(base, cur, "machine", "cpu");
+        warnIfDifferent(base, cur, "machine", "hostname");
+        warnIfDifferent(base, cur, "build", "flags");
+        warnIfDifferent(base, cur, "config", "slots");
+
+        printf("base: %s  new: %s\n", base["build"].value("git", "?").c_str(),
+               cur["build"].value("git", "?").c_str());
+        printf("%-12s %12s %12s %8s %9s %10s %10s  %s\n", "benchmark", "base ns/op",
+               "new ns/op", "change", "p", "base alloc", "new alloc", "verdict");
+
+        bool regressed = false;
+        for (auto it = base["benchmarks"].begin(); it != base["benchmarks"].end(); ++it) {
+            const string& name = it.key();
+            if (!cur["benchmarks"].contains(name)) {
+                printf("%-12s missing from new results\n", name.c_str());
+                continue;
+            }
+            const json& bb = it.value();
+            const json& cb = cur["benchmarks"][name];
+            Stats a = statsOf(samples(bb, "ns_per_op"));
+            Stats b = statsOf(samples(cb, "ns_per_op"));
+            Stats aa = statsOf(samples(bb, "allocs_per_op"));
+            Stats ab = statsOf(samples(cb, "allocs_per_op"));
+
+            double change = a.mean > 0 ? (b.mean - a.mean) / a.mean * 100.0 : 0.0;
+            double p = welchPValue(a, b);
+            string verdict = "ok";
+            if (change > thresholdPct && p < alpha) verdict = "REGRESSION";
+            else if (change < -thresholdPct && p < alpha) verdict = "improved";
+            if (ab.median > aa.median + 1e-9)
+                verdict = verdict == "ok" ? "ALLOC-REGRESSION" : verdict + ",ALLOC-REGRESSION";
+            if (verdict.find("REGRESSION") != string::npos) regressed = true;
+
+            printf("%-12s %12.1f %12.1f %+7.1f%% %9.4f %10.2f %10.2f  %s\n", name.c_str(),
+                   a.mean, b.mean, change, p, aa.median, ab.median, verdict.c_str());
+        }
+        return regressed ? 1 : 0;
+    } catch (const std::exception& e) {
+        cerr << "[FATAL] " << e.what() << "\n";
+        return 2;
+    }
+}
@@ -0,0 +1,131 @@
+// ===================== Coupon table benchmark =====================
+// Builds a CouponTable over N random codes (shop stamps and campaign
+// coupons, 10-12 characters) and times lookups of codes in the set and of
+// codes that are not, next to an unordered_map<string, campaign>. It
+// reports build time, heap bytes per code and ns per lookup. Every code is
+// checked against its campaign and every miss must be rejected, so a wrong
+// table fails the run.
+//
+//   g++ -std=c++17 -O2 -pthread bench_coupons.cc -o parking_bench_coupons
+//   ./parking_bench_coupons [--codes 100000,1000000] [--lookups N] [--reps R]
+
+#define PARKINGLOT_NO_MAIN
+#define BENCH_MAIN
+#include "Parkinglot.cc"
+#include "bench_util.h"
+
+#include <random>
+
+struct CouponBenchConfig {
+    vector<int> codes = {100000, 1000000};
+    int lookups = 1000000;
+    int reps = 3;
+};
+
+static string randomCode(mt19937_64& rng, const char* prefix) {
+    static const char alphabet[] = "ABCDEFGHJKLMNPQRSTUVWXYZ23456789";
+    string s = prefix;
+    int len = 8 + (int)(rng() % 3);
+    for (int i = 0; i < len; ++i) s += alphabet[rng() % 32];
+    return s;
+}
+
+struct CouponRun {
+    double buildMs = 0;
+    double hitNs = 0, missNs = 0;       // CouponTable
+    double mapHitNs = 0, mapMissNs = 0; // unordered_map
+};
+
+static CouponRun runOnce(int n, int lookups, uint64_t seed, size_t& bytes, size_t& mapBytes) {
+    mt19937_64 rng(seed);
+    vector<CouponCampaign> campaigns = {{"FOODCOURT", {0, 40}}, {"CINEMA", {100, 0}}, {"DIWALI-50", {0, 50}}};
+    vector<CouponCode> codes;
+    codes.reserve(n);
+    unordered_map<string, uint16_t> set;
+    set.reserve(n);
+    while ((int)codes.size() < n) {
+        uint16_t c = (uint16_t)(rng() % campaigns.size());
+        string code = randomCode(rng, c == 0 ? "FC-" : c == 1 ? "CN-" : "DW-");
+        if (set.emplace(code, c).second) codes.push_back(CouponCode{code, c});
+    }
+    vector<string> misses;
+    while ((int)misses.size() < std::min(n, lookups)) {
+        string code = randomCode(rng, "FC-");
+        if (!set.count(code)) misses.push_back(code);
+    }
+    vector<uint32_t> probe(lookups);
+    for (auto& p : probe) p = (uint32_t)(rng() % codes.size());
+
+    CouponRun r;
+    uint64_t t0 = benchNowNs();
+    unique_ptr<CouponTable> table = CouponTable::build(campaigns, codes);
+    r.buildMs = (double)(benchNowNs() - t0) / 1e6;
+    bytes = table->heapBytes();
+    mapBytes = hashMapHeapBytes(set);
+    for (const auto& [code, c] : set) mapBytes += stringHeapBytes(code);
+
+    for (const CouponCode& c : codes) {
+        uint32_t i = table->find(c.code);
+        if (i == CouponTable::NONE || &table->campaignOf(i) != &table->campaigns()[c.campaign])
+            throw runtime_error("coupon " + c.code + " not found or in the wrong campaign");
+    }
+    for (const string& m : misses)
+        if (table->find(m) != CouponTable::NONE) throw runtime_error("unknown coupon accepted: " + m);
+
+    uint64_t sum = 0;
+    t0 = benchNowNs();
+    for (uint32_t p : probe) sum += table->find(codes[p].code);
+    r.hitNs = (double)(benchNowNs() - t0) / lookups;
+    t0 = benchNowNs();
+    for (int i = 0; i < lookups; ++i) sum += table->find(misses[i % misses.size()]);
+    r.missNs = (double)(benchNowNs() - t0) / lookups;
+    t0 = benchNowNs();
+    for (uint32_t p : probe) sum += set.find(codes[p].code)->second;
+    r.mapHitNs = (double)(benchNowNs() - t0) / lookups;
+    t0 = benchNowNs();
+    for (int i = 0; i < lookups; ++i) sum += set.count(misses[i % misses.size()]);
+    r.mapMissNs = (double)(benchNowNs() - t0) / lookups;
+    doNotOptimize(sum);
+    return r;
+}
+
+int main(int argc, char** argv) {
+    CouponBenchConfig cfg;
+    for (BenchArgs args(argc, argv); args.next();) {
+        const string& a = args.flag();
+        if (a == "--codes") {
+            cfg.codes.clear();
+            string list = args.value();
+            for (size_t pos = 0; pos != string::npos; pos = list.find(',', pos), pos += pos != string::npos)
+                cfg.codes.push_back(atoi(list.c_str() + pos));
+            continue;
+        }
+        int v = args.intValue();
+        if      (a == "--lookups") cfg.lookups = v;
+        else if (a == "--reps")    cfg.reps = v;
+        else { cerr << "unknown option " << a << "\n"; return 2; }
+    }
+    if (cfg.lookups <= 0 || cfg.reps <= 0 || cfg.codes.empty() ||
+        *min_element(cfg.codes.begin(), cfg.codes.end()) <= 0) {
+        cerr << "--lookups, --reps and every --codes entry must be positive\n";
+        return 2;
+    }
+
+    printf("lookups=%d reps=%d (median run)\n", cfg.lookups, cfg.reps);
+    printf("%10s %10s %10s %10s %10s %12s %12s\n", "codes", "build_ms", "bytes/code", "hit_ns", "miss_ns",
+           "map_bytes/cd", "map_hit/miss");
+    try {
+        for (int n : cfg.codes) {
+            vector<CouponRun> runs;
+            size_t bytes = 0, mapBytes = 0;
+            for (int r = 0; r < cfg.reps; ++r) runs.push_back(runOnce(n, cfg.lookups, r + 1, bytes, mapBytes));
+            sort(runs.begin(), runs.end(), [](const CouponRun& a, const CouponRun& b) { return a.hitNs < b.hitNs; });
+            const CouponRun& g = runs[runs.size() / 2];
+            printf("%10d %10.1f %10.2f %10.1f %10.1f %12.1f %6.1f/%5.1f\n", n, g.buildMs, (double)bytes / n, g.hitNs,
+                   g.missNs, (double)mapBytes / n, g.mapHitNs, g.mapMissNs);
+        }
+    } catch (const std::exception& e) {
+        cerr << "[FATAL] " << e.what() << "\n";
+        return 1;
+    }
+}
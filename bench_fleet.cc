@@ -0,0 +1,111 @@
+// ===================== Fleet invoicing benchmark =====================
+// Fills a FleetLedger (fleet_ledger.h) with N charges over A accounts,
+// spread across three months, and times the monthly invoice pass for the
+// middle month at 1..T threads. Every run is checked against a plain loop
+// over the charges, so a wrong split or merge fails the run. ns/op is per
+// charge in the ledger, not per charge invoiced.
+//
+//   g++ -std=c++17 -O2 -pthread bench_fleet.cc -o parking_bench_fleet
+//   ./parking_bench_fleet [--charges N] [--accounts A] [--reps R] [--threads 1,2,4,8]
+
+#define PARKINGLOT_NO_MAIN
+#define BENCH_MAIN
+#include "Parkinglot.cc"
+#include "bench_util.h"
+
+#include <random>
+
+struct FleetBenchConfig {
+    int charges = 1 << 23;
+    int accounts = 500;
+    int reps = 3;
+    vector<int> threads = {1, 2, 4, 8};
+};
+
+int main(int argc, char** argv) {
+    FleetBenchConfig cfg;
+    for (BenchArgs args(argc, argv); args.next();) {
+        const string& a = args.flag();
+        if (a == "--threads") {
+            cfg.threads.clear();
+            string list = args.value();
+            for (size_t pos = 0; pos != string::npos; pos = list.find(',', pos), pos += pos != string::npos)
+                cfg.threads.push_back(atoi(list.c_str() + pos));
+            continue;
+        }
+        int v = args.intValue();
+        if      (a == "--charges")  cfg.charges = v;
+        else if (a == "--accounts") cfg.accounts = v;
+        else if (a == "--reps")     cfg.reps = v;
+        else { cerr << "unknown option " << a << "\n"; return 2; }
+    }
+    if (cfg.charges <= 0 || cfg.accounts <= 0 || cfg.reps <= 0 || cfg.threads.empty() ||
+        *min_element(cfg.threads.begin(), cfg.threads.end()) <= 0) {
+        cerr << "--charges, --accounts, --reps and every --threads entry must be positive\n";
+        return 2;
+    }
+
+    PerfCounters pc;
+    if (!pc.available())
+        cerr << "[bench] hardware counters unavailable (check perf_event_paranoid); timing only\n";
+    try {
+        FleetLedger ledger;
+        for (int a = 0; a < cfg.accounts; ++a) ledger.addAccount("FLEET" + to_string(a));
+        // Jan..Mar 2026, invoiced for Feb
+        const uint32_t jan = (uint32_t)(daysFromCivil(2026, 1, 1) * 24 * 60);
+        const uint32_t feb = (uint32_t)(daysFromCivil(2026, 2, 1) * 24 * 60);
+        const uint32_t mar = (uint32_t)(daysFromCivil(2026, 3, 1) * 24 * 60);
+        const uint32_t apr = (uint32_t)(daysFromCivil(2026, 4, 1) * 24 * 60);
+        mt19937_64 rng(1);
+        uint64_t t0 = benchNowNs();
+        for (int i = 0; i < cfg.charges; ++i) {
+            FleetCharge c;
+            c.ticket = (TicketId)i + 1;
+            c.outMinute = jan + (uint32_t)((uint64_t)i * (apr - jan) / (uint64_t)cfg.charges);
+            c.account = (FleetAccountId)(rng() % cfg.accounts);
+            c.parkedMinutes = (uint32_t)(rng() % (24 * 60));
+            c.billedHours = (c.parkedMinutes + 59) / 60;
+            c.amount = c.billedHours * 50;
+            ledger.append(c);
+        }
+        double appendNs = (double)(benchNowNs() - t0) / cfg.charges;
+
+        vector<FleetInvoice> want(cfg.accounts);
+        for (int a = 0; a < cfg.accounts; ++a) want[a].account = (FleetAccountId)a;
+        for (size_t i = 0; i < ledger.size(); ++i) {
+            FleetCharge c = ledger.charge(i);
+            if (c.outMinute < feb || c.outMinute >= mar) continue;
+            FleetInvoice& inv = want[c.account];
+            ++inv.charges;
+            inv.parkedMinutes += c.parkedMinutes;
+            inv.billedHours += c.billedHours;
+            inv.amount += c.amount;
+        }
+        want.erase(remove_if(want.begin(), want.end(), [](const FleetInvoice& v) { return !v.charges; }),
+                   want.end());
+
+        printf("charges=%d accounts=%d reps=%d cores=%u append=%.1f ns/charge ledger=%zu MB (median run)\n",
+               cfg.charges, cfg.accounts, cfg.reps, std::thread::hardware_concurrency(), appendNs,
+               ledger.heapBytes() >> 20);
+        printHeader();
+        for (int threads : cfg.threads) {
+            vector<Measurement> runs;
+            for (int r = 0; r < cfg.reps; ++r) {
+                vector<FleetInvoice> got;
+                runs.push_back(timeBatch(pc, ledger.size(), [&] {
+                    got = ledger.aggregate(ledger.size(), feb, mar, ledger.accounts(), (unsigned)threads);
+                }));
+                bool same = got.size() == want.size();
+                for (size_t k = 0; same && k < got.size(); ++k)
+                    same = got[k].account == want[k].account && got[k].charges == want[k].charges &&
+                           got[k].parkedMinutes == want[k].parkedMinutes &&
+                           got[k].billedHours == want[k].billedHours && got[k].amount == want[k].amount;
+                if (!same) throw runtime_error("invoices at " + to_string(threads) + " threads disagree");
+            }
+            printRow("invoice.t" + to_string(threads), medianOf(runs));
+        }
+    } catch (const std::exception& e) {
+        cerr << "[FATAL] " << e.what() << "\n";
+        return 1;
+    }
+}
@@ -0,0 +1,170 @@
+// ===================== Gate latency benchmark =====================
+// Barrier-open latency through the GateServer request loop, default
+// (blocking) workers versus busy-poll workers. Each client runs a closed
+// loop of enter + exit round trips with a think gap between requests, so
+// the server goes idle the way a real gate does between cars; latency is
+// submit-to-response as seen by the client. Reports p50/p99/p99.9/max per
+// request and the process CPU time per request, the price of polling.
+// --reporters R adds R threads flooding status requests; with priority
+// lanes the gate latency should barely move while status calls are shed.
+//
+//   g++ -std=c++17 -O2 -pthread bench_gate.cc -o parking_bench_gate
+//   ./parking_bench_gate [--ops N] [--clients C] [--workers W] [--gap-us U] [--reps R]
+//                        [--reporters R] [--cpus 2,3]   (busy-poll worker cores)
+//
+// Busy polling only pays off with a spare core per worker; on smaller
+// machines the pollers compete with the clients and the numbers say so.
+
+#define PARKINGLOT_NO_MAIN
+#define BENCH_MAIN
+#include "Parkinglot.cc"
+#include "gate_server.h"
+#include "bench_util.h"
+
+#include <random>
+#include <sys/resource.h>
+
+struct GateBenchConfig {
+    int ops = 20000;   // round trips per client
+    int clients = 1;
+    int workers = 1;
+    int gapUs = 50;    // think time between round trips
+    int reps = 3;
+    int reporters = 0; // status-flood threads
+    vector<int> cpus;
+};
+
+struct GateRun {
+    double p50 = 0, p99 = 0, p999 = 0, max = 0;
+    double cpuUsPerReq = 0;
+    uint64_t statusServed = 0, statusShed = 0;
+};
+
+static double cpuSeconds() {
+    rusage ru{};
+    getrusage(RUSAGE_SELF, &ru);
+    return ru.ru_utime.tv_sec + ru.ru_stime.tv_sec + (ru.ru_utime.tv_usec + ru.ru_stime.tv_usec) / 1e6;
+}
+
+static GateRun runOnce(const GateBenchConfig& cfg, WaitMode mode, int rep) {
+    vector<Floor> fs(1);
+    fs[0].floorNo = 1;
+    for (int i = 0; i < 64 * cfg.clients; ++i)
+        fs[0].slots.push_back(ParkingSlot{"F1-S" + to_string(i + 1), SlotType::FourWheeler, true});
+    ParkingLot lot;
+    lot.configure(std::move(fs));
+    lot.warmUp();
+
+    GateServerConfig sc;
+    sc.workers = cfg.workers;
+    sc.mode = mode;
+    if (mode == WaitMode::BusyPoll) sc.cpus = cfg.cpus;
+    GateServer srv(lot, sc);
+
+    vector<uint32_t> lat;
+    std::mutex latMu;
+    double cpu0 = cpuSeconds();
+    vector<std::thread> clients;
+    for (int c = 0; c < cfg.clients; ++c)
+        clients.emplace_back([&, c] {
+            mt19937 rng(rep * 131 + c);
+            std::uniform_int_distribution<int> gap(cfg.gapUs / 2, cfg.gapUs * 3 / 2);
+            Vehicle v("GATE" + to_string(c), VehicleType::Car);
+            vector<uint32_t> mine;
+            mine.reserve(2 * cfg.ops);
+            GateCall call;
+            auto roundTrip = [&](const GateRequest& r) {
+                call.req = r;
+                uint64_t a = benchNowNs();
+                while (!srv.submit(call)) std::this_thread::yield(); // shed: retry
+                call.wait();
+                mine.push_back((uint32_t)std::min<uint64_t>(benchNowNs() - a, UINT32_MAX));
+                if (!call.resp.ok) throw runtime_error(call.resp.error);
+            };
+            for (int i = 0; i < cfg.ops; ++i) {
+                roundTrip(GateRequest::enter("E1", v));
+                TicketId t = call.resp.ticket;
+                if (cfg.gapUs > 0) std::this_thread::sleep_for(std::chrono::microseconds(gap(rng)));
+                roundTrip(GateRequest::exit("X1", t));
+                if (cfg.gapUs > 0) std::this_thread::sleep_for(std::chrono::microseconds(gap(rng)));
+            }
+            std::lock_guard<std::mutex> lk(latMu);
+            lat.insert(lat.end(), mine.begin(), mine.end());
+        });
+    std::atomic<bool> flooding{true};
+    vector<std::thread> reporters;
+    for (int r = 0; r < cfg.reporters; ++r)
+        reporters.emplace_back([&] {
+            vector<GateCall> calls(256); // kept in flight to overrun the status lane
+            while (flooding.load(std::memory_order_relaxed)) {
+                for (GateCall& c : calls) {
+                    c.req = GateRequest::status();
+                    srv.submit(c);
+                }
+                for (GateCall& c : calls) c.wait();
+            }
+        });
+    for (auto& t : clients) t.join();
+    flooding = false;
+    for (auto& t : reporters) t.join();
+    srv.stop();
+    double cpu = cpuSeconds() - cpu0;
+
+    sort(lat.begin(), lat.end());
+    GateRun r;
+    r.p50 = lat[lat.size() / 2];
+    r.p99 = lat[lat.size() * 99 / 100];
+    r.p999 = lat[lat.size() * 999 / 1000];
+    r.max = lat.back();
+    r.cpuUsPerReq = cpu * 1e6 / (double)lat.size();
+    GateLaneStats st = srv.laneStats(GateClass::Status);
+    r.statusServed = st.accepted;
+    r.statusShed = st.shed;
+    return r;
+}
+
+int main(int argc, char** argv) {
+    GateBenchConfig cfg;
+    for (BenchArgs args(argc, argv); args.next();) {
+        const string& a = args.flag();
+        if (a == "--cpus") { cfg.cpus = parseCpuList(args.value()); continue; }
+        int v = args.intValue();
+        if      (a == "--ops")     cfg.ops = v;
+        else if (a == "--clients") cfg.clients = v;
+        else if (a == "--workers") cfg.workers = v;
+        else if (a == "--gap-us")  cfg.gapUs = v;
+        else if (a == "--reps")    cfg.reps = v;
+        else if (a == "--reporters") cfg.reporters = v;
+        else { cerr << "unknown option " << a << "\n"; return 2; }
+    }
+    if (cfg.ops <= 0 || cfg.clients <= 0 || cfg.workers <= 0 || cfg.reps <= 0 || cfg.gapUs < 0 ||
+        cfg.reporters < 0) {
+        cerr << "--ops, --clients, --workers and --reps must be positive, --gap-us and --reporters non-negative\n";
+        return 2;
+    }
+
+    unsigned cores = std::thread::hardware_concurrency();
+    if (cores < (unsigned)(cfg.clients + cfg.workers))
+        cerr << "[bench] " << cores << " cores for " << cfg.clients << " clients + " << cfg.workers
+             << " pollers: busy-poll will contend with the clients\n";
+
+    struct Mode { WaitMode mode; const char* name; };
+    const Mode modes[] = {{WaitMode::Block, "block"}, {WaitMode::BusyPoll, "busy-poll"}};
+    printf("clients=%d workers=%d ops/client=%d gap=%dus reporters=%d reps=%d (median run by p99.9; ns per request)\n",
+           cfg.clients, cfg.workers, cfg.ops, cfg.gapUs, cfg.reporters, cfg.reps);
+    printf("%-10s %9s %9s %9s %10s %12s %13s %12s\n", "mode", "p50", "p99", "p99.9", "max", "cpu us/req",
+           "status served", "status shed");
+    try {
+        for (const Mode& m : modes) {
+            vector<GateRun> runs;
+            for (int r = 0; r < cfg.reps; ++r) runs.push_back(runOnce(cfg, m.mode, r));
+            sort(runs.begin(), runs.end(), [](const GateRun& a, const GateRun& b) { return a.p999 < b.p999; });
+            const GateRun& g = runs[runs.size() / 2];
+            printf("%-10s %9.0f %9.0f %9.0f %10.0f %12.2f %13llu %12llu\n", m.name, g.p50, g.p99, g.p999, g.max,
+                   g.cpuUsPerReq, (unsigned long long)g.statusServed, (unsigned long long)g.statusShed);
+        }
+    } catch (const std::exception& e) {
+        cerr << "[FATAL] " << e.what() << "\n";
+        return 1;
+    }
+}
@@ -0,0 +1,183 @@
+// ===================== Hot/cold layout benchmark =====================
+// Exit and pay against the ticket and bill tables with N open tickets
+// (default 1M, far beyond the LLC), in random order. "aos" replays the
+// previous layout: one unordered_map node per Ticket / Bill holding every
+// field, plus the slot-id string lookup exit used to make. "split" runs the
+// same steps on TicketTable / BillTable: ticket hot fields in the hash node
+// and bill hot fields in an array indexed by id, text fields in separate
+// cold arrays.
+// "lot" rows time the whole ParkingLot::exitVehicle / payBill. Cache and
+// dTLB misses per op are printed where the PMU allows.
+//
+//   g++ -std=c++17 -O2 -pthread bench_hotcold.cc -o parking_bench_hotcold
+//   ./parking_bench_hotcold [--tickets N] [--reps R]
+
+#define PARKINGLOT_NO_MAIN
+#define BENCH_MAIN
+#include "Parkinglot.cc"
+#include "bench_util.h"
+
+#include <random>
+
+struct HotColdBenchConfig {
+    int tickets = 1 << 20;
+    int reps = 3;
+};
+
+static Ticket makeTicket(int i, std::chrono::system_clock::time_point now) {
+    Ticket tk;
+    tk.id = (TicketId)i + 1;
+    tk.entryGateId = "GATE-EAST-" + to_string(i % 4);
+    tk.inTime = now;
+    tk.slotId = "F" + to_string(i / 4096 + 1) + "-S" + to_string(i % 4096 + 1);
+    tk.vtype = VehicleType::Car;
+    tk.stype = SlotType::FourWheeler;
+    tk.vehicleReg = "KA01AB" + to_string(100000 + i);
+    return tk;
+}
+
+static Bill makeBill(const Ticket& tk, BillId id, unsigned long long amount) {
+    Bill b;
+    b.id = id;
+    b.ticket = tk.id;
+    b.vehicleReg = tk.vehicleReg;
+    b.slotId = tk.slotId;
+    b.entryGateId = tk.entryGateId;
+    b.exitGateId = "GATE-WEST-1";
+    b.inTime = tk.inTime;
+    b.outTime = tk.inTime;
+    b.amount = amount;
+    return b;
+}
+
+// Previous layout: Ticket / Bill by value in node-based maps.
+static void runAos(const HotColdBenchConfig& cfg, const vector<TicketId>& order, PerfCounters& pc,
+                   vector<Measurement>& exits, vector<Measurement>& pays) {
+    auto now = std::chrono::system_clock::now();
+    unordered_map<string, uint64_t> slotIndex;
+    unordered_map<TicketId, Ticket, hash<TicketId>, equal_to<TicketId>,
+                  HugePageAllocator<pair<const TicketId, Ticket>>> active;
+    slotIndex.reserve(cfg.tickets);
+    active.reserve(cfg.tickets);
+    for (int i = 0; i < cfg.tickets; ++i) {
+        Ticket tk = makeTicket(i, now);
+        slotIndex.emplace(tk.slotId, slotHandle(i / 4096, i % 4096));
+        active.emplace(tk.id, std::move(tk));
+    }
+
+    unordered_map<BillId, Bill> bills;
+    bills.reserve(cfg.tickets);
+    BillId nextBill = 1;
+    exits.push_back(timeLoop(pc, order.size(), [&](uint64_t i) {
+        auto it = active.find(order[i]);
+        Ticket tk = std::move(it->second);
+        active.erase(it);
+        doNotOptimize(slotIndex.find(tk.slotId)->second);
+        auto mins = parkedMinutesBetween(tk.inTime, now);
+        Bill b = makeBill(tk, nextBill++, computeFee(tk.stype, mins).amount + tk.timer);
+        bills.emplace(b.id, std::move(b));
+    }));
+
+    // bill ids are 1..N too; paying in `order` is a different random order than creation
+    pays.push_back(timeLoop(pc, order.size(), [&](uint64_t i) {
+        Bill& b = bills.find(order[i])->second;
+        if (b.status == BillStatus::Pending) b.status = BillStatus::Paid;
+        doNotOptimize(b.amount + b.ticket);
+    }));
+}
+
+// Current layout: hot records plus cold text.
+static void runSplit(const HotColdBenchConfig& cfg, const vector<TicketId>& order, PerfCounters& pc,
+                     vector<Measurement>& exits, vector<Measurement>& pays) {
+    auto now = std::chrono::system_clock::now();
+    TicketTable active;
+    active.reserve(cfg.tickets);
+    for (int i = 0; i < cfg.tickets; ++i) active.insert(makeTicket(i, now), slotHandle(i / 4096, i % 4096));
+
+    BillTable bills;
+    bills.reserve(cfg.tickets);
+    BillId nextBill = 1;
+    exits.push_back(timeLoop(pc, order.size(), [&](uint64_t i) {
+        TicketHot* open = active.find(order[i]);
+        doNotOptimize(open->slot);
+        Ticket tk = active.take(*open);
+        auto mins = parkedMinutesBetween(tk.inTime, now);
+        bills.insert(makeBill(tk, nextBill++, computeFee(tk.stype, mins).amount + tk.timer));
+    }));
+
+    pays.push_back(timeLoop(pc, order.size(), [&](uint64_t i) {
+        BillHot& b = *bills.find(order[i]);
+        if (b.status == BillStatus::Pending) b.status = BillStatus::Paid;
+        doNotOptimize(b.amount + b.ticket);
+    }));
+}
+
+// Whole engine: exitVehicle / payBill on a restored lot.
+static void runLot(const HotColdBenchConfig& cfg, const vector<TicketId>& order, PerfCounters& pc,
+                   vector<Measurement>& exits, vector<Measurement>& pays) {
+    auto now = std::chrono::system_clock::now();
+    vector<Floor> fs((cfg.tickets + 4095) / 4096);
+    vector<Ticket> open(cfg.tickets);
+    for (int i = 0; i < cfg.tickets; ++i) {
+        open[i] = makeTicket(i, now);
+        Floor& f = fs[i / 4096];
+        f.floorNo = i / 4096 + 1;
+        f.slots.push_back(ParkingSlot{open[i].slotId, SlotType::FourWheeler, true});
+    }
+    ParkingLot lot;
+    lot.configure(std::move(fs));
+    lot.warmUp();
+    lot.restoreTickets(std::move(open));
+
+    vector<BillId> billOf(order.size());
+    exits.push_back(timeLoop(pc, order.size(), [&](uint64_t i) {
+        billOf[i] = lot.exitVehicle(order[i], "GATE-WEST-1").id;
+    }));
+    PaymentRequest req;
+    req.method = PaymentMethod::Cash;
+    pays.push_back(timeLoop(pc, order.size(), [&](uint64_t i) {
+        req.bill = billOf[order[i] - 1]; // bills in a different random order than exits
+        doNotOptimize(lot.payBill(req).amount);
+    }));
+}
+
+int main(int argc, char** argv) {
+    HotColdBenchConfig cfg;
+    for (BenchArgs args(argc, argv); args.next();) {
+        const string& a = args.flag();
+        int v = args.intValue();
+        if      (a == "--tickets") cfg.tickets = v;
+        else if (a == "--reps")    cfg.reps = v;
+        else { cerr << "unknown option " << a << "\n"; return 2; }
+    }
+    if (cfg.tickets <= 0 || cfg.reps <= 0) {
+        cerr << "--tickets and --reps must be positive\n";
+        return 2;
+    }
+
+    PerfCounters pc;
+    if (!pc.available())
+        cerr << "[bench] hardware counters unavailable (check perf_event_paranoid); timing only\n";
+    printf("tickets=%d reps=%d sizeof: Ticket=%zu TicketHot=%zu Bill=%zu BillHot=%zu (median run)\n",
+           cfg.tickets, cfg.reps, sizeof(Ticket), sizeof(TicketHot), sizeof(Bill), sizeof(BillHot));
+    printHeader();
+    try {
+        vector<Measurement> exits[3], pays[3];
+        for (int r = 0; r < cfg.reps; ++r) {
+            vector<TicketId> order(cfg.tickets);
+            for (int i = 0; i < cfg.tickets; ++i) order[i] = (TicketId)i + 1;
+            shuffle(order.begin(), order.end(), mt19937_64(r + 1));
+            runAos(cfg, order, pc, exits[0], pays[0]);
+            runSplit(cfg, order, pc, exits[1], pays[1]);
+            runLot(cfg, order, pc, exits[2], pays[2]);
+        }
+        const char* tags[] = {"aos", "split", "lot"};
+        for (int k = 0; k < 3; ++k) {
+            printRow(string("exit.") + tags[k], medianOf(exits[k]));
+            printRow(string("pay.") + tags[k], medianOf(pays[k]));
+        }
+    } catch (const std::exception& e) {
+        cerr << "[FATAL] " << e.what() << "\n";
+        return 1;
+    }
+}
@@ -0,0 +1,129 @@
+// ===================== Huge-page benchmark =====================
+// Free-slot scans and ticket lookups on a million-slot lot with the
+// huge-page allocator off, on transparent huge pages and on explicit
+// (hugetlbfs) pages. The lot is restored 90% full from the front, so each
+// enter scans ~0.9 N slots; the lookup phase exits random open tickets.
+// Each mode runs in a forked child (the mode is latched per process) and
+// prints dTLB load misses per op next to ns/op where the PMU allows, plus
+// how much of the process is actually huge-page backed.
+//
+//   g++ -std=c++17 -O2 -pthread bench_hugepages.cc -o parking_bench_hugepages
+//   ./parking_bench_hugepages [--slots N] [--scans N] [--lookups N] [--reps R]
+
+#define PARKINGLOT_NO_MAIN
+#define BENCH_MAIN
+#include "Parkinglot.cc"
+#include "bench_util.h"
+
+#include <random>
+#include <sys/wait.h>
+
+struct HugeBenchConfig {
+    int slots = 1 << 20;
+    int scans = 32;
+    int lookups = 200000;
+    int reps = 3;
+};
+
+// AnonHugePages of the whole process, in KB.
+static uint64_t anonHugeKb() {
+    ifstream f("/proc/self/smaps_rollup");
+    for (string line; getline(f, line);)
+        if (line.rfind("AnonHugePages:", 0) == 0) return stoull(line.substr(14));
+    return 0;
+}
+
+static void runMode(const HugeBenchConfig& cfg, HugePageMode mode, const char* tag) {
+    setHugePageMode(mode); // before the first arena allocation in this process
+    PerfCounters pc;
+    vector<Measurement> scanRuns, lookupRuns;
+    uint64_t hugeKb = 0;
+    for (int r = 0; r < cfg.reps; ++r) {
+        vector<Floor> fs(1);
+        fs[0].floorNo = 1;
+        fs[0].slots.reserve(cfg.slots);
+        for (int i = 0; i < cfg.slots; ++i)
+            fs[0].slots.push_back(ParkingSlot{"F1-S" + to_string(i + 1), SlotType::FourWheeler, true});
+
+        int filled = cfg.slots / 10 * 9;
+        vector<Ticket> open(filled);
+        auto now = std::chrono::system_clock::now();
+        for (int i = 0; i < filled; ++i) {
+            open[i].id = (TicketId)i + 1;
+            open[i].slotId = fs[0].slots[i].id;
+            open[i].vehicleReg = "CAR" + to_string(i);
+            open[i].vtype = VehicleType::Car;
+            open[i].entryGateId = "E1";
+            open[i].inTime = now;
+        }
+
+        ParkingLot lot;
+        lot.configure(std::move(fs));
+        lot.warmUp();
+        lot.restoreTickets(std::move(open));
+
+        Vehicle car("SCAN", VehicleType::Car);
+        scanRuns.push_back(timeLoop(pc, cfg.scans, [&](uint64_t) { lot.enterVehicle("E1", car); }));
+
+        vector<TicketId> ids(filled);
+        for (int i = 0; i < filled; ++i) ids[i] = (TicketId)i + 1;
+        shuffle(ids.begin(), ids.end(), mt19937_64(r + 1));
+        uint64_t n = (uint64_t)std::min(cfg.lookups, filled);
+        lookupRuns.push_back(timeLoop(pc, n, [&](uint64_t i) {
+            Bill b = lot.exitVehicle(ids[i], "X1");
+            doNotOptimize(b.amount);
+        }));
+        hugeKb = std::max(hugeKb, anonHugeKb());
+    }
+    printRow(string("scan.") + tag, medianOf(scanRuns));
+    printRow(string("lookup.") + tag, medianOf(lookupRuns));
+    HugePageStats st = HugePageArena::instance().stats();
+    printf("  %s: AnonHugePages %llu KB, arena thp %zu KB, explicit %zu KB, fallbacks %zu\n", tag,
+           (unsigned long long)hugeKb, st.thpBytes >> 10, st.explicitBytes >> 10, st.fallbacks);
+    fflush(stdout);
+}
+
+int main(int argc, char** argv) {
+    HugeBenchConfig cfg;
+    for (BenchArgs args(argc, argv); args.next();) {
+        const string& a = args.flag();
+        int v = args.intValue();
+        if      (a == "--slots")   cfg.slots = v;
+        else if (a == "--scans")   cfg.scans = v;
+        else if (a == "--lookups") cfg.lookups = v;
+        else if (a == "--reps")    cfg.reps = v;
+        else { cerr << "unknown option " << a << "\n"; return 2; }
+    }
+    if (cfg.slots < 10 || cfg.scans <= 0 || cfg.lookups <= 0 || cfg.reps <= 0) {
+        cerr << "--scans, --lookups and --reps must be positive, --slots at least 10\n";
+        return 2;
+    }
+
+    PerfCounters probe;
+    if (!probe.available())
+        cerr << "[bench] hardware counters unavailable (check perf_event_paranoid); timing only\n";
+
+    struct Mode { HugePageMode mode; const char* tag; };
+    const Mode modes[] = {{HugePageMode::Off, "off"}, {HugePageMode::Transparent, "thp"},
+                          {HugePageMode::Explicit, "explicit"}};
+    printf("slots=%d scans=%d lookups=%d reps=%d (median run; ops are per enter / per exit)\n",
+           cfg.slots, cfg.scans, cfg.lookups, cfg.reps);
+    printHeader();
+    fflush(stdout);
+    for (const Mode& m : modes) {
+        pid_t pid = fork();
+        if (pid < 0) { perror("fork"); return 1; }
+        if (pid == 0) {
+            try {
+                runMode(cfg, m.mode, m.tag);
+            } catch (const std::exception& e) {
+                cerr << "[FATAL] " << e.what() << "\n";
+                _exit(1);
+            }
+            _exit(0);
+        }
+        int status = 0;
+        waitpid(pid, &status, 0);
+        if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) return 1;
+    }
+}
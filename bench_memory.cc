@@ -0,0 +1,111 @@
+// ===================== Memory footprint benchmark =====================
+// Fills lots of increasing size and prints, per size, the accounted bytes
+// (ParkingLot::memoryUsage) next to what the process really holds: malloc
+// in-use bytes (mallinfo2) and RSS. Each size runs in a forked child so
+// RSS starts from the same baseline. Output is CSV, ready to plot.
+//
+//   g++ -std=c++17 -O2 -pthread bench_memory.cc -o parking_bench_memory
+//   ./parking_bench_memory [--max-slots N] [--floors F] > memory.csv
+//
+// Phases per size: configured (empty lot), full (every slot has an active
+// ticket) and drained (every ticket exited, one bill each). per_unit is
+// bytes per slot, per active ticket and per bill for the three phases.
+
+#define PARKINGLOT_NO_MAIN
+#define BENCH_MAIN
+#include "Parkinglot.cc"
+#include "bench_util.h"
+
+#include <malloc.h>
+#include <sys/wait.h>
+
+static size_t rssBytes() {
+    ifstream statm("/proc/self/statm");
+    size_t pages = 0, resident = 0;
+    statm >> pages >> resident;
+    return resident * (size_t)sysconf(_SC_PAGESIZE);
+}
+
+static size_t heapInUseBytes() {
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 33))
+    struct mallinfo2 mi = mallinfo2();
+    return mi.uordblks + mi.hblkhd; // arena + mmapped (large) blocks
+#else
+    return 0;
+#endif
+}
+
+static vector<Floor> memoryLayout(int slots, int floors) {
+    vector<Floor> fs(floors);
+    int perFloor = (slots + floors - 1) / floors;
+    for (int f = 0; f < floors; ++f) {
+        fs[f].floorNo = f + 1;
+        for (int i = 0; i < perFloor; ++i)
+            fs[f].slots.push_back(ParkingSlot{"F" + to_string(f + 1) + "-S" + to_string(i + 1),
+                                              SlotType::FourWheeler, true});
+    }
+    return fs;
+}
+
+static void printPhase(int slots, const char* phase, const MemoryUsage& mu,
+                       size_t unitBytes, size_t heap0, size_t rss0) {
+    printf("%d,%s,%zu,%zu,%zu,%zu,%zu,%zu,%zu,%zu,%zu,%zu,%zu,%.1f,%zu,%zu\n", slots, phase,
+           mu.slotArrays, mu.slotStrings, mu.slotIndex, mu.activeTable, mu.ticketStrings,
+           mu.billTable, mu.billStrings, mu.passTable, mu.couponTable, mu.fleetLedger, mu.total(), (double)unitBytes / slots,
+           heapInUseBytes() - heap0, rssBytes() - rss0);
+    fflush(stdout);
+}
+
+static void runSize(int slots, int floors) {
+    // the benchmark's own ticket list is allocated before the baseline
+    vector<TicketId> tickets;
+    tickets.reserve(slots);
+
+    size_t heap0 = heapInUseBytes(), rss0 = rssBytes();
+    ParkingLot lot;
+    lot.configure(memoryLayout(slots, floors));
+    MemoryUsage mu = lot.memoryUsage();
+    printPhase(slots, "configured", mu, mu.slotArrays + mu.slotStrings + mu.slotIndex, heap0, rss0);
+
+    for (int i = 0; i < slots; ++i) {
+        Vehicle v("CAR" + to_string(i), VehicleType::Car);
+        tickets.push_back(lot.enterVehicle("E1", v));
+    }
+    mu = lot.memoryUsage();
+    printPhase(slots, "full", mu, mu.activeTable + mu.ticketStrings, heap0, rss0);
+
+    for (TicketId t : tickets) lot.exitVehicle(t, "X1");
+    mu = lot.memoryUsage();
+    printPhase(slots, "drained", mu, mu.billTable + mu.billStrings, heap0, rss0);
+}
+
+int main(int argc, char** argv) {
+    int maxSlots = 65536, floors = 16;
+    for (BenchArgs args(argc, argv); args.next();) {
+        const string& a = args.flag();
+        if      (a == "--max-slots") maxSlots = args.intValue();
+        else if (a == "--floors")    floors = args.intValue();
+        else { cerr << "unknown option " << a << "\n"; return 2; }
+    }
+    if (maxSlots <= 0 || floors <= 0) { cerr << "--max-slots and --floors must be positive\n"; return 2; }
+
+    printf("slots,phase,slot_arrays,slot_strings,slot_index,active_table,ticket_strings,"
+           "bill_table,bill_strings,pass_table,coupon_table,fleet_ledger,accounted,per_unit,heap_in_use,rss\n");
+    fflush(stdout);
+    for (int slots = 1024; slots <= maxSlots; slots *= 4) {
+        pid_t pid = fork();
+        if (pid < 0) { perror("fork"); return 1; }
+        if (pid == 0) {
+            try {
+                runSize(slots, floors);
+            } catch (const std::exception& e) {
+                cerr << "[FATAL] " << e.what() << "\n";
+                _exit(1);
+            }
+            _exit(0);
+        }
+        int status = 0;
+        waitpid(pid, &status, 0);
+        if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) return 1;
+    }
+}
@@ -0,0 +1,217 @@
+// ===================== NUMA placement benchmark =====================
+// Gate latency with the lot's tables on the gate threads' node ("local")
+// versus the farthest node ("remote"). Gate threads are pinned to node 0;
+// the lot is configured, warmed up and half filled through
+// runOnNumaNode(memNode). Each gate op is exit(random own ticket) +
+// enterVehicle. Reports ns/op, p50/p99 per op, node-load counters per op
+// where the PMU exposes them, and where the setup's pages landed (from
+// /proc/self/numa_maps). Every run is a forked child so one case's freed
+// heap pages are not recycled into the next.
+//
+//   g++ -std=c++17 -O2 -pthread bench_numa.cc -o parking_bench_numa
+//   ./parking_bench_numa [--slots N] [--ops N] [--threads T] [--reps R]
+//
+// On a single-node machine both cases run on node 0 and should match.
+
+#define PARKINGLOT_NO_MAIN
+#define BENCH_MAIN
+#include "Parkinglot.cc"
+#include "bench_util.h"
+
+#include <random>
+#include <sstream>
+#include <sys/wait.h>
+
+struct NumaBenchConfig {
+    int slots = 1 << 16;
+    int ops = 20000; // per gate thread
+    int threads = 2;
+    int reps = 3;
+};
+
+// Resident KB per node for the whole process.
+static vector<uint64_t> residentKbPerNode(int nodes) {
+    vector<uint64_t> kb(nodes, 0);
+    ifstream f("/proc/self/numa_maps");
+    for (string line; getline(f, line);) {
+        uint64_t pageKb = 4;
+        vector<pair<int, uint64_t>> counts;
+        istringstream is(line);
+        for (string tok; is >> tok;) {
+            if (tok.rfind("kernelpagesize_kB=", 0) == 0) pageKb = stoull(tok.substr(18));
+            else if (tok.size() > 2 && tok[0] == 'N' && isdigit((unsigned char)tok[1])) {
+                auto eq = tok.find('=');
+                if (eq != string::npos) counts.push_back({stoi(tok.substr(1, eq - 1)), stoull(tok.substr(eq + 1))});
+            }
+        }
+        for (auto [node, pages] : counts)
+            if (node < nodes) kb[node] += pages * pageKb;
+    }
+    return kb;
+}
+
+struct CaseResult {
+    double nsPerOp = 0, p50 = 0, p99 = 0;
+    PerfCounters::Values perOp;
+    vector<int64_t> setupKb; // per node, delta over setup
+};
+
+static CaseResult runCase(const NumaBenchConfig& cfg, int memNode, int gateNode, int nodes) {
+    vector<Floor> fs(1);
+    fs[0].floorNo = 1;
+    for (int i = 0; i < cfg.slots; ++i)
+        fs[0].slots.push_back(ParkingSlot{"F1-S" + to_string(i + 1), SlotType::FourWheeler, true});
+
+    ParkingLot lot;
+    vector<vector<TicketId>> tickets(cfg.threads);
+    vector<uint64_t> before = residentKbPerNode(nodes);
+    runOnNumaNode(memNode, [&] {
+        lot.configure(fs);
+        lot.warmUp();
+        for (int i = 0; i < cfg.slots / 2; ++i) {
+            Vehicle v("CAR" + to_string(i), VehicleType::Car);
+            tickets[i % cfg.threads].push_back(lot.enterVehicle("E1", v));
+        }
+    });
+    vector<uint64_t> after = residentKbPerNode(nodes);
+
+    CaseResult res;
+    for (int n = 0; n < nodes; ++n) res.setupKb.push_back((int64_t)after[n] - (int64_t)before[n]);
+
+    vector<uint32_t> lat;
+    std::mutex latMu;
+    vector<uint64_t> elapsed(cfg.threads);
+    vector<PerfCounters::Values> counts(cfg.threads);
+    vector<std::thread> gates;
+    for (int t = 0; t < cfg.threads; ++t)
+        gates.emplace_back([&, t] {
+            pinThisThread(numaCpusOfNode(gateNode));
+            mt19937_64 rng(t + 1);
+            vector<uint32_t> mine;
+            mine.reserve(cfg.ops);
+            vector<TicketId>& own = tickets[t];
+            Vehicle v("GATE" + to_string(t), VehicleType::Car);
+            PerfCounters pc;
+            uint64_t t0 = benchNowNs();
+            pc.start();
+            for (int i = 0; i < cfg.ops; ++i) {
+                size_t j = rng() % own.size();
+                uint64_t a = benchNowNs();
+                lot.exitVehicle(own[j], "X1");
+                own[j] = lot.enterVehicle("E1", v);
+                mine.push_back((uint32_t)std::min<uint64_t>(benchNowNs() - a, UINT32_MAX));
+            }
+            counts[t] = pc.stop();
+            elapsed[t] = benchNowNs() - t0;
+            std::lock_guard<std::mutex> lk(latMu);
+            lat.insert(lat.end(), mine.begin(), mine.end());
+        });
+    for (auto& g : gates) g.join();
+
+    uint64_t totalOps = (uint64_t)cfg.ops * cfg.threads;
+    uint64_t ns = 0;
+    PerfCounters::Values sum;
+    for (int t = 0; t < cfg.threads; ++t) {
+        ns += elapsed[t];
+        for (int k = 0; k < PerfCounters::COUNT; ++k) {
+            sum.v[k] += counts[t].v[k];
+            sum.ok[k] = counts[t].ok[k];
+        }
+    }
+    res.nsPerOp = (double)ns / (double)totalOps;
+    res.perOp = sum.perOp(totalOps);
+    sort(lat.begin(), lat.end());
+    res.p50 = lat[lat.size() / 2];
+    res.p99 = lat[lat.size() * 99 / 100];
+    return res;
+}
+
+// runCase() in a forked child; the result comes back as one text line.
+static CaseResult runCaseForked(const NumaBenchConfig& cfg, int memNode, int gateNode, int nodes) {
+    int fds[2];
+    if (pipe(fds) != 0) throw runtime_error("pipe failed");
+    pid_t pid = fork();
+    if (pid < 0) throw runtime_error("fork failed");
+    if (pid == 0) {
+        close(fds[0]);
+        try {
+            CaseResult r = runCase(cfg, memNode, gateNode, nodes);
+            ostringstream os;
+            os << r.nsPerOp << " " << r.p50 << " " << r.p99;
+            for (int k = 0; k < PerfCounters::COUNT; ++k) os << " " << r.perOp.ok[k] << " " << r.perOp.v[k];
+            for (int64_t kb : r.setupKb) os << " " << kb;
+            os << "\n";
+            string s = os.str();
+            if (write(fds[1], s.data(), s.size()) != (ssize_t)s.size()) _exit(1);
+        } catch (const std::exception& e) {
+            cerr << "[FATAL] " << e.what() << "\n";
+            _exit(1);
+        }
+        _exit(0);
+    }
+    close(fds[1]);
+    string out;
+    char buf[512];
+    for (ssize_t n; (n = read(fds[0], buf, sizeof(buf))) > 0;) out.append(buf, (size_t)n);
+    close(fds[0]);
+    int status = 0;
+    waitpid(pid, &status, 0);
+    if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) throw runtime_error("benchmark child failed");
+
+    CaseResult r;
+    istringstream is(out);
+    is >> r.nsPerOp >> r.p50 >> r.p99;
+    for (int k = 0; k < PerfCounters::COUNT; ++k) is >> r.perOp.ok[k] >> r.perOp.v[k];
+    r.setupKb.resize(nodes);
+    for (auto& kb : r.setupKb) is >> kb;
+    return r;
+}
+
+int main(int argc, char** argv) {
+    NumaBenchConfig cfg;
+    for (BenchArgs args(argc, argv); args.next();) {
+        const string& a = args.flag();
+        int v = args.intValue();
+        if      (a == "--slots")   cfg.slots = v;
+        else if (a == "--ops")     cfg.ops = v;
+        else if (a == "--threads") cfg.threads = v;
+        else if (a == "--reps")    cfg.reps = v;
+        else { cerr << "unknown option " << a << "\n"; return 2; }
+    }
+    if (cfg.slots < 2 * cfg.threads || cfg.ops <= 0 || cfg.threads <= 0 || cfg.reps <= 0) {
+        cerr << "--ops, --threads and --reps must be positive, --slots at least 2 per thread\n";
+        return 2;
+    }
+
+    int nodes = numaNodeCount();
+    int far = nodes - 1;
+    if (nodes == 1)
+        cerr << "[bench] single NUMA node: local and remote cases are identical\n";
+
+    struct Case { const char* name; int memNode; };
+    const Case cases[] = {{"local", 0}, {"remote", far}};
+    printf("slots=%d threads=%d ops/thread=%d reps=%d nodes=%d gate node=0 (median run)\n",
+           cfg.slots, cfg.threads, cfg.ops, cfg.reps, nodes);
+    printf("%-8s %8s %10s %9s %9s %14s %16s  %s\n", "case", "mem node", "ns/op", "p50 ns", "p99 ns",
+           "node-loads", "node-load-miss", "setup KB per node");
+    try {
+        for (const Case& c : cases) {
+            vector<CaseResult> runs;
+            for (int r = 0; r < cfg.reps; ++r) runs.push_back(runCaseForked(cfg, c.memNode, 0, nodes));
+            sort(runs.begin(), runs.end(),
+                 [](const CaseResult& a, const CaseResult& b) { return a.nsPerOp < b.nsPerOp; });
+            const CaseResult& m = runs[runs.size() / 2];
+            printf("%-8s %8d %10.1f %9.0f %9.0f", c.name, c.memNode, m.nsPerOp, m.p50, m.p99);
+            for (int k : {PerfCounters::NodeLoads, PerfCounters::NodeLoadMisses}) {
+                if (m.perOp.ok[k]) printf(" %*.2f", k == PerfCounters::NodeLoads ? 14 : 16, m.perOp.v[k]);
+                else               printf(" %*s", k == PerfCounters::NodeLoads ? 14 : 16, "n/a");
+            }
+            printf(" ");
+            for (int n = 0; n < nodes; ++n) printf(" N%d=%lld", n, (long long)m.setupKb[n]);
+            printf("\n");
+        }
+    } catch (const std::exception& e) {
+        cerr << "[FATAL] " << e.what() << "\n";
+        return 1;
+    }
+}
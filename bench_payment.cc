@@ -0,0 +1,110 @@
+// ===================== Payment contention benchmark =====================
+// PaymentService under exit bursts: T threads each create a bill, pay it
+// (cash) and read it back, all against one service. It compares the mutex
+// around the bill table with flat combining and the lock-striped table at
+// 8..64 threads. Reports ns/op (wall time / total calls), throughput, and
+// for combining the mean batch applied per combiner pass.
+//
+//   g++ -std=c++17 -O2 -pthread bench_payment.cc -o parking_bench_payment
+//   ./parking_bench_payment [--ops N] [--reps R] [--threads 8,16,32,64]
+
+#define PARKINGLOT_NO_MAIN
+#define BENCH_MAIN
+#include "Parkinglot.cc"
+#include "bench_util.h"
+
+struct PaymentBenchConfig {
+    int ops = 20000; // create+pay+get rounds per thread
+    int reps = 3;
+    vector<int> threads = {8, 16, 32, 64};
+};
+
+struct PaymentRun {
+    double nsPerOp = 0;
+    double batch = 0; // combining only
+};
+
+static PaymentRun runOnce(const PaymentBenchConfig& cfg, PaymentConcurrency mode, int threads) {
+    PaymentService svc;
+    svc.setConcurrency(mode);
+    std::atomic<int> ready{0};
+    std::atomic<bool> go{false};
+    vector<std::thread> ts;
+    for (int t = 0; t < threads; ++t)
+        ts.emplace_back([&, t] {
+            Ticket tk;
+            tk.slotId = "F1-S" + to_string(t + 1);
+            tk.vehicleReg = "CAR" + to_string(t);
+            tk.entryGateId = "E1";
+            FeeBreakup fb{40, 2, 95};
+            PaymentRequest req;
+            req.method = PaymentMethod::Cash;
+            ready.fetch_add(1);
+            while (!go.load(std::memory_order_acquire)) std::this_thread::yield();
+            for (int i = 0; i < cfg.ops; ++i) {
+                tk.id = (TicketId)t * cfg.ops + i + 1;
+                Bill b = svc.createBill(tk, "X1", fb);
+                req.bill = b.id;
+                req.amount = b.amount;
+                doNotOptimize(svc.pay(req).amount);
+                doNotOptimize(svc.get(b.id)->status);
+            }
+        });
+    while (ready.load() < threads) std::this_thread::yield();
+    uint64_t t0 = benchNowNs();
+    go.store(true, std::memory_order_release);
+    for (auto& t : ts) t.join();
+    uint64_t ns = benchNowNs() - t0;
+
+    PaymentRun r;
+    r.nsPerOp = (double)ns / (3.0 * threads * cfg.ops);
+    const FlatCombiner& fc = svc.combiner();
+    r.batch = fc.passes() ? (double)fc.combined() / (double)fc.passes() : 0;
+    return r;
+}
+
+int main(int argc, char** argv) {
+    PaymentBenchConfig cfg;
+    for (BenchArgs args(argc, argv); args.next();) {
+        const string& a = args.flag();
+        if (a == "--threads") {
+            cfg.threads.clear();
+            string list = args.value();
+            for (size_t pos = 0; pos != string::npos; pos = list.find(',', pos), pos += pos != string::npos)
+                cfg.threads.push_back(atoi(list.c_str() + pos));
+            continue;
+        }
+        int v = args.intValue();
+        if      (a == "--ops")  cfg.ops = v;
+        else if (a == "--reps") cfg.reps = v;
+        else { cerr << "unknown option " << a << "\n"; return 2; }
+    }
+    if (cfg.ops <= 0 || cfg.reps <= 0 || cfg.threads.empty() ||
+        *min_element(cfg.threads.begin(), cfg.threads.end()) <= 0) {
+        cerr << "--ops, --reps and every --threads entry must be positive\n";
+        return 2;
+    }
+
+    struct Mode { PaymentConcurrency mode; const char* name; };
+    const Mode modes[] = {{PaymentConcurrency::Mutex, "mutex"}, {PaymentConcurrency::FlatCombining, "combining"},
+                          {PaymentConcurrency::Striped, "striped"}};
+    printf("ops/thread=%d (x3 calls) reps=%d cores=%u (median run)\n", cfg.ops, cfg.reps,
+           std::thread::hardware_concurrency());
+    printf("%-10s %8s %10s %12s %8s\n", "mode", "threads", "ns/op", "Mops/s", "batch");
+    try {
+        for (int threads : cfg.threads)
+            for (const Mode& m : modes) {
+                vector<PaymentRun> runs;
+                for (int r = 0; r < cfg.reps; ++r) runs.push_back(runOnce(cfg, m.mode, threads));
+                sort(runs.begin(), runs.end(),
+                     [](const PaymentRun& a, const PaymentRun& b) { return a.nsPerOp < b.nsPerOp; });
+                const PaymentRun& g = runs[runs.size() / 2];
+                printf("%-10s %8d %10.1f %12.2f", m.name, threads, g.nsPerOp, 1e3 / g.nsPerOp);
+                if (m.mode == PaymentConcurrency::FlatCombining) printf(" %8.2f\n", g.batch);
+                else printf(" %8s\n", "-");
+            }
+    } catch (const std::exception& e) {
+        cerr << "[FATAL] " << e.what() << "\n";
+        return 1;
+    }
+}
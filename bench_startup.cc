@@ -0,0 +1,163 @@
+// ===================== Startup-time benchmark =====================
+// Time from process start to the first enterVehicle served, for several
+// layout sizes and recovery log sizes. Each run execs a fresh copy of this
+// binary (--child) so process creation, dynamic loading and static init
+// are part of the measurement; the child reports its phase timings back.
+//
+//   g++ -std=c++17 -O2 -pthread bench_startup.cc -o parking_bench_startup
+//   ./parking_bench_startup [--max-slots N] [--reps R] [--dir /tmp]
+//
+// Phases: exec (fork/exec until main), load (loadConfigFromJson), index
+// (configure: slot index build), replay (loadRecoveryLog + restoreTickets),
+// warmup (ParkingLot::warmUp) and first (the first enterVehicle).
+
+#define PARKINGLOT_NO_MAIN
+#define BENCH_MAIN
+#include "Parkinglot.cc"
+#include "bench_util.h"
+
+#include <sstream>
+#include <sys/wait.h>
+
+static const int PHASES = 6;
+static const char* phaseNames[PHASES] = {"exec", "load", "index", "replay", "warmup", "first"};
+
+// Child: run the restart sequence and print absolute phase boundaries.
+static int runChild(const char* configPath, const char* logPath) {
+    uint64_t t[PHASES + 1];
+    t[1] = benchNowNs(); // main entered
+    try {
+        vector<Floor> fs = loadConfigFromJson(configPath);
+        t[2] = benchNowNs();
+        ParkingLot lot;
+        lot.configure(std::move(fs));
+        t[3] = benchNowNs();
+        lot.restoreTickets(loadRecoveryLog(logPath));
+        t[4] = benchNowNs();
+        lot.warmUp();
+        t[5] = benchNowNs();
+        Vehicle v("FIRST0001", VehicleType::Car);
+        lot.enterVehicle("E1", v);
+        t[6] = benchNowNs();
+    } catch (const std::exception& e) {
+        cerr << "[FATAL] " << e.what() << "\n";
+        return 1;
+    }
+    for (int i = 1; i <= PHASES; ++i) printf("%llu ", (unsigned long long)t[i]);
+    printf("\n");
+    return 0;
+}
+
+static void writeLayout(const string& path, int slots, int floors) {
+    json jf = json::array();
+    int perFloor = (slots + floors - 1) / floors;
+    for (int f = 0; f < floors; ++f) {
+        json js = json::array();
+        for (int i = 0; i < perFloor; ++i)
+            js.push_back({{"id", "F" + to_string(f + 1) + "-S" + to_string(i + 1)}, {"type", "FourWheeler"}});
+        jf.push_back({{"floorNo", f + 1}, {"slots", js}});
+    }
+    ofstream out(path);
+    if (!out) throw runtime_error("Could not write layout: " + path);
+    out << json{{"floors", jf}}.dump() << "\n";
+}
+
+// Recovery log with `open` tickets, produced by a real lot.
+static void writeRecoveryLog(const string& configPath, const string& path, int open) {
+    ParkingLot lot;
+    lot.configure(loadConfigFromJson(configPath));
+    for (int i = 0; i < open; ++i) {
+        Vehicle v("CAR" + to_string(i), VehicleType::Car);
+        lot.enterVehicle("E1", v);
+    }
+    saveRecoveryLog(path, lot.snapshotTickets());
+}
+
+// Parent: spawn one child, return per-phase ns (exec .. first).
+static bool spawnChild(const string& self, const string& cfg, const string& log, vector<double>& phases) {
+    int fds[2];
+    if (pipe(fds) != 0) return false;
+    uint64_t t0 = benchNowNs();
+    pid_t pid = fork();
+    if (pid < 0) return false;
+    if (pid == 0) {
+        dup2(fds[1], STDOUT_FILENO);
+        close(fds[0]); close(fds[1]);
+        execl(self.c_str(), self.c_str(), "--child", cfg.c_str(), log.c_str(), (char*)nullptr);
+        _exit(127);
+    }
+    close(fds[1]);
+    string out;
+    char buf[256];
+    ssize_t n;
+    while ((n = read(fds[0], buf, sizeof(buf))) > 0) out.append(buf, (size_t)n);
+    close(fds[0]);
+    int status = 0;
+    waitpid(pid, &status, 0);
+    if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) return false;
+
+    istringstream in(out);
+    uint64_t prev = t0, t;
+    phases.clear();
+    while (in >> t) { phases.push_back((double)(t - prev)); prev = t; }
+    return phases.size() == PHASES;
+}
+
+int main(int argc, char** argv) {
+    if (argc == 4 && string(argv[1]) == "--child") return runChild(argv[2], argv[3]);
+
+    int maxSlots = 65536, reps = 5;
+    string dir = "/tmp";
+    for (BenchArgs args(argc, argv); args.next();) {
+        const string& a = args.flag();
+        if      (a == "--max-slots") maxSlots = args.intValue();
+        else if (a == "--reps")      reps = args.intValue();
+        else if (a == "--dir")       dir = args.value();
+        else { cerr << "unknown option " << a << "\n"; return 2; }
+    }
+    if (maxSlots <= 0 || reps <= 0) { cerr << "--max-slots and --reps must be positive\n"; return 2; }
+
+    char selfBuf[4096];
+    ssize_t len = readlink("/proc/self/exe", selfBuf, sizeof(selfBuf) - 1);
+    if (len <= 0) { cerr << "[FATAL] cannot resolve /proc/self/exe\n"; return 1; }
+    string self(selfBuf, (size_t)len);
+
+    printf("%8s %8s", "slots", "tickets");
+    for (const char* p : phaseNames) printf(" %10s", p);
+    printf(" %10s   (us, median of %d)\n", "total", reps);
+
+    try {
+        for (int slots = 1024; slots <= maxSlots; slots *= 4) {
+            string cfg = dir + "/parking_startup_layout_" + to_string(slots) + ".json";
+            writeLayout(cfg, slots, 16);
+            for (int open : {0, slots / 4, slots / 2}) {
+                string log = dir + "/parking_startup_log_" + to_string(slots) + "_" + to_string(open) + ".json";
+                writeRecoveryLog(cfg, log, open);
+
+                vector<vector<double>> runs;
+                for (int r = 0; r < reps; ++r) {
+                    vector<double> ph;
+                    if (!spawnChild(self, cfg, log, ph)) { cerr << "[FATAL] child run failed\n"; return 1; }
+                    runs.push_back(ph);
+                }
+                // median run by total time
+                sort(runs.begin(), runs.end(), [](const vector<double>& a, const vector<double>& b) {
+                    double sa = 0, sb = 0;
+                    for (double x : a) sa += x;
+                    for (double x : b) sb += x;
+                    return sa < sb;
+                });
+                const auto& med = runs[runs.size() / 2];
+                double total = 0;
+                printf("%8d %8d", slots, open);
+                for (double x : med) { printf(" %10.1f", x / 1000.0); total += x; }
+                printf(" %10.1f\n", total / 1000.0);
+                remove(log.c_str());
+            }
+            remove(cfg.c_str());
+        }
+    } catch (const std::exception& e) {
+        cerr << "[FATAL] " << e.what() << "\n";
+        return 1;
+    }
+}
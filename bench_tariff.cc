@@ -0,0 +1,118 @@
+// ===================== Tariff rule benchmark =====================
+// Compiles a few tariff rules (tariff_vm.h) and times evaluation over N
+// random stays (slot type, 0-48h, customer class, in/out time), next to
+// computeFee on the same stays. "default" bills like the FeeSchedule and
+// is checked against computeFee on every stay, so a wrong VM fails the run.
+// "lot" rows time ParkingLot::quoteFee with the rule installed, which adds
+// the epoch pin and the time-of-day split. Prints instructions per rule and
+// compile time.
+//
+//   g++ -std=c++17 -O2 -pthread bench_tariff.cc -o parking_bench_tariff
+//   ./parking_bench_tariff [--stays N] [--reps R]
+
+#define PARKINGLOT_NO_MAIN
+#define BENCH_MAIN
+#include "Parkinglot.cc"
+#include "bench_util.h"
+
+#include <random>
+
+struct TariffBenchConfig {
+    int stays = 1 << 20;
+    int reps = 5;
+};
+
+struct BenchRule {
+    const char* name;
+    const char* source;
+};
+
+static const BenchRule kRules[] = {
+    {"default", "minutes <= 10 ? 0 : hours * (slot == Heavy ? 50 : slot == FourWheeler ? 20 : 10)"},
+    {"night", "class == member ? 0 : (out_hour >= 22 || out_hour < 6) && hours <= 8 ? 30 * (1 + (slot == Heavy))"
+              " : minutes <= 10 ? 0 : max(hours, 1) * (slot == Heavy ? 50 : 20)"},
+    {"tiered", "class == staff ? 0 : minutes <= 15 ? 0 :"
+               " min(hours, 3) * (slot + 1) * 15 + max(hours - 3, 0) * (slot + 1) * 10"
+               " + (out_weekday == Sat || out_weekday == Sun) * 20 - (class == member) * min(hours * 5, 100)"
+               " + (in_hour < 9 && out_hour >= 18) * 50 * (60 / 60)"},
+};
+
+struct Stay {
+    SlotType slot;
+    uint8_t cls;
+    unsigned long long minutes;
+    std::chrono::system_clock::time_point in, out;
+};
+
+int main(int argc, char** argv) {
+    TariffBenchConfig cfg;
+    for (BenchArgs args(argc, argv); args.next();) {
+        const string& a = args.flag();
+        int v = args.intValue();
+        if      (a == "--stays") cfg.stays = v;
+        else if (a == "--reps")  cfg.reps = v;
+        else { cerr << "unknown option " << a << "\n"; return 2; }
+    }
+    if (cfg.stays <= 0 || cfg.reps <= 0) {
+        cerr << "--stays and --reps must be positive\n";
+        return 2;
+    }
+
+    PerfCounters pc;
+    if (!pc.available())
+        cerr << "[bench] hardware counters unavailable (check perf_event_paranoid); timing only\n";
+    try {
+        const vector<string> classes = {"regular", "member", "staff"};
+        mt19937_64 rng(1);
+        auto base = std::chrono::system_clock::now();
+        vector<Stay> stays(cfg.stays);
+        for (Stay& s : stays) {
+            s.slot = (SlotType)(rng() % TypeRegistry::instance().slotTypes());
+            s.cls = (uint8_t)(rng() % classes.size());
+            s.minutes = rng() % (48 * 60);
+            s.out = base + std::chrono::minutes(rng() % (7 * 24 * 60));
+            s.in = s.out - std::chrono::minutes(s.minutes);
+        }
+
+        printf("stays=%d reps=%d (median run)\n", cfg.stays, cfg.reps);
+        printf("%-10s %6s %11s\n", "rule", "insns", "compile_us");
+        vector<TariffRule> rules;
+        for (const BenchRule& r : kRules) {
+            uint64_t t0 = benchNowNs();
+            rules.push_back(TariffRule::compile(r.source, classes, 330));
+            printf("%-10s %6zu %11.1f\n", r.name, rules.back().program.size(), (double)(benchNowNs() - t0) / 1e3);
+        }
+        for (const Stay& s : stays) {
+            FeeBreakup want = computeFee(s.slot, s.minutes), got = rules[0].price(s.slot, s.cls, s.minutes, s.in, s.out);
+            if (got.amount != want.amount || got.billedHours != want.billedHours)
+                throw runtime_error("default rule disagrees with computeFee at " + to_string(s.minutes) + " minutes");
+        }
+
+        ParkingLot lot;
+        printHeader();
+        vector<Measurement> fixed;
+        for (int r = 0; r < cfg.reps; ++r)
+            fixed.push_back(timeLoop(pc, stays.size(), [&](uint64_t i) {
+                doNotOptimize(computeFee(stays[i].slot, stays[i].minutes).amount);
+            }));
+        printRow("computeFee", medianOf(fixed));
+        for (size_t k = 0; k < rules.size(); ++k) {
+            vector<Measurement> vm, quote;
+            lot.setTariff(kRules[k].source, classes, 330);
+            for (int r = 0; r < cfg.reps; ++r) {
+                vm.push_back(timeLoop(pc, stays.size(), [&](uint64_t i) {
+                    const Stay& s = stays[i];
+                    doNotOptimize(rules[k].price(s.slot, s.cls, s.minutes, s.in, s.out).amount);
+                }));
+                quote.push_back(timeLoop(pc, stays.size(), [&](uint64_t i) {
+                    doNotOptimize(lot.quoteFee(stays[i].slot, stays[i].minutes, stays[i].cls).amount);
+                }));
+            }
+            printRow(string("vm.") + kRules[k].name, medianOf(vm));
+            printRow(string("lot.") + kRules[k].name, medianOf(quote));
+        }
+    } catch (const std::exception& e) {
+        cerr << "[FATAL] " << e.what() << "\n";
+        return 1;
+    }
+}
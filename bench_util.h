@@ -0,0 +1,295 @@
+#pragma once
+// ===================== Benchmark helpers =====================
+// Wall-clock timing and perf_event_open hardware counters shared by the
+// bench_*.cc programs. Counters degrade gracefully: anything the kernel
+// refuses (perf_event_paranoid, containers, VMs) is reported as n/a.
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <new>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <sys/utsname.h>
+#include <unistd.h>
+#endif
+
+inline std::uint64_t benchNowNs() {
+    return (std::uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Keeps the optimizer from discarding a computed value.
+template <class T> inline void doNotOptimize(const T& v) {
+    asm volatile("" : : "r,m"(v) : "memory");
+}
+
+// ---- Allocation counting ----
+// benchAllocCount() is the running total of global operator new calls. The
+// counting operator new/delete are defined only in the TU that defines
+// BENCH_MAIN before including this header (the bench program's main file),
+// so a second TU including it still links; without any BENCH_MAIN TU the
+// count stays 0.
+namespace bench_detail { inline std::atomic<std::uint64_t> allocs{0}; }
+
+inline std::uint64_t benchAllocCount() {
+    return bench_detail::allocs.load(std::memory_order_relaxed);
+}
+
+#ifdef BENCH_MAIN
+// noinline: once inlined GCC pairs malloc with `delete` and warns (-Wmismatched-new-delete).
+__attribute__((noinline)) void* operator new(std::size_t n) {
+    bench_detail::allocs.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = std::malloc(n ? n : 1)) return p;
+    throw std::bad_alloc();
+}
+__attribute__((noinline)) void operator delete(void* p) noexcept { std::free(p); }
+__attribute__((noinline)) void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+#endif
+
+// ---- Command line ----
+// "--flag value" pairs from argv[first..]:
+//
+//   for (BenchArgs args(argc, argv); args.next();)
+//       if (args.flag() == "--reps") reps = args.intValue(); else ...
+//
+// A flag without a value (e.g. a lone --help) or a stray non-flag argument
+// prints an error and exits with status 2 instead of running defaults.
+class BenchArgs {
+public:
+    BenchArgs(int argc, char** argv, int first = 1) : argc_(argc), argv_(argv), i_(first) {}
+
+    bool next() {
+        if (i_ >= argc_) return false;
+        flag_ = argv_[i_];
+        if (flag_.rfind("--", 0) != 0) fail("unexpected argument " + flag_);
+        if (i_ + 1 >= argc_) fail("missing value for " + flag_);
+        value_ = argv_[i_ + 1];
+        i_ += 2;
+        return true;
+    }
+    const std::string& flag() const { return flag_; }
+    const char* value() const { return value_; }
+    int intValue() const { return std::atoi(value_); }
+    double doubleValue() const { return std::atof(value_); }
+
+private:
+    [[noreturn]] void fail(const std::string& what) const {
+        std::fprintf(stderr, "%s: %s\n", argv_[0], what.c_str());
+        std::exit(2);
+    }
+
+    int argc_;
+    char** argv_;
+    int i_;
+    std::string flag_;
+    const char* value_ = nullptr;
+};
+
+class PerfCounters {
+public:
+    // NodeLoads / NodeLoadMisses: loads served by (local / remote) memory
+    // nodes; the generic NODE cache event, missing on many CPUs and VMs.
+    enum Kind { Cycles, Instructions, CacheMisses, BranchMisses, NodeLoads, NodeLoadMisses,
+                DtlbLoadMisses, COUNT };
+
+    struct Values {
+        double v[COUNT] = {};
+        bool ok[COUNT] = {};
+        Values perOp(std::uint64_t ops) const {
+            Values r = *this;
+            for (int k = 0; k < COUNT; ++k) r.v[k] = ops ? v[k] / (double)ops : 0.0;
+            return r;
+        }
+    };
+
+    static const char* name(int k) {
+        static const char* names[COUNT] = {"cycles", "instructions", "cache-misses", "branch-misses",
+                                           "node-loads", "node-load-misses", "dTLB-load-misses"};
+        return names[k];
+    }
+
+    PerfCounters() {
+        for (int k = 0; k < COUNT; ++k) fd_[k] = openCounter(k);
+    }
+    ~PerfCounters() {
+#ifdef __linux__
+        for (int fd : fd_) if (fd >= 0) ::close(fd);
+#endif
+    }
+    PerfCounters(const PerfCounters&) = delete;
+    PerfCounters& operator=(const PerfCounters&) = delete;
+
+    bool available() const {
+        for (int fd : fd_) if (fd >= 0) return true;
+        return false;
+    }
+
+    void start() {
+#ifdef __linux__
+        for (int fd : fd_) if (fd >= 0) {
+            ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+            ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+        }
+#endif
+    }
+
+    Values stop() {
+        Values r;
+#ifdef __linux__
+        for (int k = 0; k < COUNT; ++k) {
+            if (fd_[k] < 0) continue;
+            ioctl(fd_[k], PERF_EVENT_IOC_DISABLE, 0);
+            std::uint64_t buf[3] = {}; // value, time_enabled, time_running
+            if (::read(fd_[k], buf, sizeof(buf)) != (ssize_t)sizeof(buf) || buf[2] == 0) continue;
+            // scale for multiplexing when more counters than PMU slots
+            r.v[k] = (double)buf[0] * ((double)buf[1] / (double)buf[2]);
+            r.ok[k] = true;
+        }
+#endif
+        return r;
+    }
+
+private:
+    int fd_[COUNT];
+
+    static int openCounter(int kind) {
+#ifdef __linux__
+        constexpr std::uint64_t nodeRead = PERF_COUNT_HW_CACHE_NODE | (PERF_COUNT_HW_CACHE_OP_READ << 8);
+        static const struct { std::uint32_t type; std::uint64_t config; } events[COUNT] = {
+            {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES},
+            {PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS},
+            {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES},
+            {PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES},
+            {PERF_TYPE_HW_CACHE, nodeRead | (PERF_COUNT_HW_CACHE_RESULT_ACCESS << 16)},
+            {PERF_TYPE_HW_CACHE, nodeRead | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16)},
+            {PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_DTLB | (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                                 (PERF_COUNT_HW_CACHE_RESULT_MISS << 16)}};
+        perf_event_attr attr;
+        std::memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = events[kind].type;
+        attr.config = events[kind].config;
+        attr.disabled = 1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+        return (int)syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+#else
+        (void)kind;
+        return -1;
+#endif
+    }
+};
+
+// One timed run of an operation loop.
+struct Measurement {
+    std::uint64_t ops = 0;
+    double nsPerOp = 0;
+    double allocsPerOp = 0;
+    PerfCounters::Values perOp;
+};
+
+// Times one body() call that handles `ops` items; figures are per item.
+template <class F>
+inline Measurement timeBatch(PerfCounters& pc, std::uint64_t ops, F&& body) {
+    Measurement m;
+    m.ops = ops;
+    std::uint64_t a0 = benchAllocCount();
+    pc.start();
+    std::uint64_t t0 = benchNowNs();
+    body();
+    std::uint64_t t1 = benchNowNs();
+    m.perOp = pc.stop().perOp(ops);
+    m.nsPerOp = ops ? (double)(t1 - t0) / (double)ops : 0.0;
+    m.allocsPerOp = ops ? (double)(benchAllocCount() - a0) / (double)ops : 0.0;
+    return m;
+}
+
+// Times body(i) for i in [0, ops) with counters around the whole loop.
+template <class F>
+inline Measurement timeLoop(PerfCounters& pc, std::uint64_t ops, F&& body) {
+    return timeBatch(pc, ops, [&] { for (std::uint64_t i = 0; i < ops; ++i) body(i); });
+}
+
+// Median run by ns/op; counters reported are from that same run.
+inline Measurement medianOf(std::vector<Measurement> runs) {
+    std::sort(runs.begin(), runs.end(),
+              [](const Measurement& a, const Measurement& b) { return a.nsPerOp < b.nsPerOp; });
+    return runs[runs.size() / 2];
+}
+
+inline void printHeader() {
+    std::printf("%-12s %10s %9s", "benchmark", "ns/op", "allocs/op");
+    for (int k = 0; k < PerfCounters::COUNT; ++k) std::printf(" %14s", PerfCounters::name(k));
+    std::printf("\n");
+}
+
+inline void printRow(const std::string& name, const Measurement& m) {
+    std::printf("%-12s %10.1f %9.2f", name.c_str(), m.nsPerOp, m.allocsPerOp);
+    for (int k = 0; k < PerfCounters::COUNT; ++k) {
+        if (m.perOp.ok[k]) std::printf(" %14.2f", m.perOp.v[k]);
+        else               std::printf(" %14s", "n/a");
+    }
+    std::printf("\n");
+}
+
+// ---- Run metadata ----
+// Tags result files so runs from different builds/machines are not compared blindly.
+// Pass -DPARKINGLOT_GIT_REV=\"$(git rev-parse --short HEAD)\" to record the revision.
+struct BenchEnv {
+    std::string compiler, buildFlags, gitRev, hostname, kernel, cpu;
+    unsigned cores = 0;
+};
+
+inline BenchEnv benchEnv() {
+    BenchEnv e;
+#if defined(__clang__)
+    e.compiler = std::string("clang ") + __clang_version__;
+#elif defined(__GNUC__)
+    e.compiler = std::string("gcc ") + __VERSION__;
+#else
+    e.compiler = "unknown";
+#endif
+#ifdef __OPTIMIZE__
+    e.buildFlags = "optimized";
+#else
+    e.buildFlags = "debug";
+#endif
+#ifdef NDEBUG
+    e.buildFlags += ",NDEBUG";
+#endif
+#ifdef PARKINGLOT_GIT_REV
+    e.gitRev = PARKINGLOT_GIT_REV;
+#else
+    e.gitRev = "unknown";
+#endif
+    e.cores = std::thread::hardware_concurrency();
+#ifdef __linux__
+    utsname u;
+    if (uname(&u) == 0) {
+        e.hostname = u.nodename;
+        e.kernel = std::string(u.sysname) + " " + u.release + " " + u.machine;
+    }
+    std::ifstream cpuinfo("/proc/cpuinfo");
+    for (std::string line; std::getline(cpuinfo, line);) {
+        if (line.rfind("model name", 0) == 0) {
+            auto colon = line.find(':');
+            if (colon != std::string::npos) e.cpu = line.substr(colon + 2);
+            break;
+        }
+    }
+#endif
+    return e;
+}
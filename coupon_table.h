@@ -0,0 +1,245 @@
+#pragma once
+// ===================== Coupon codes =====================
+// Shop validation stamps and campaign coupons, applied at exit.
+//
+// A CouponTable is built once over the whole code set. A minimal perfect
+// hash (hash-and-displace, as in CHD/PTHash) gives each of the n codes its
+// own index in [0, n):
+//   - code -> 64-bit hash -> bucket (about 4 codes per bucket)
+//   - the bucket's pilot, found at build time, mixes the hash into an index
+//     that no other code in the set uses.
+// A lookup is therefore one hash, one pilot read and one entry read, with
+// no probing and no string compare.
+//
+// Each entry packs a 48-bit fingerprint of its code and the code's
+// campaign. A code outside the set lands on some entry and is rejected by
+// the fingerprint; a wrong code is accepted with probability 2^-48. The
+// code strings are not kept: about 9 bytes per code (8-byte entry plus one
+// 4-byte pilot per four codes).
+//
+// CouponBook holds the current table behind an atomic pointer. load()
+// builds a new table off to the side and swaps it in. Lookups pin an epoch
+// (epoch.h), so the old table is freed once no lookup can still use it.
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "epoch.h"
+
+struct CouponDiscount {
+    unsigned percentOff = 0;          // of the parking fee, 0..100
+    unsigned long long amountOff = 0; // INR, after the percentage
+
+    // INR taken off `fee`; never more than the fee.
+    unsigned long long off(unsigned long long fee) const {
+        unsigned long long d = fee * percentOff / 100 + amountOff;
+        return d < fee ? d : fee;
+    }
+};
+
+struct CouponCampaign {
+    std::string name; // e.g. "FOODCOURT-STAMP", "DIWALI-50"
+    CouponDiscount discount;
+};
+
+struct CouponCode {
+    std::string code;
+    std::uint16_t campaign = 0; // index into the campaign list
+};
+
+class CouponTable {
+public:
+    static constexpr std::uint32_t NONE = ~0u;
+    static constexpr std::size_t MAX_CAMPAIGNS = 0xffff;
+
+    // Throws std::runtime_error on a duplicate or empty code, a bad
+    // campaign index or percentage, or too many campaigns.
+    static std::unique_ptr<CouponTable> build(std::vector<CouponCampaign> campaigns,
+                                              const std::vector<CouponCode>& codes) {
+        if (campaigns.size() > MAX_CAMPAIGNS) throw std::runtime_error("Too many coupon campaigns");
+        for (const CouponCampaign& c : campaigns)
+            if (c.discount.percentOff > 100)
+                throw std::runtime_error("Coupon campaign " + c.name + " takes off more than 100%");
+        for (const CouponCode& c : codes) {
+            if (c.code.empty()) throw std::runtime_error("Empty coupon code");
+            if (c.campaign >= campaigns.size())
+                throw std::runtime_error("Coupon code " + c.code + " names an unknown campaign");
+        }
+        std::unique_ptr<CouponTable> t(new CouponTable);
+        t->campaigns_ = std::move(campaigns);
+        for (std::uint64_t seed = 1;; ++seed) {
+            if (seed > MAX_SEEDS) throw std::runtime_error("Coupon table build failed");
+            if (t->tryBuild(codes, seed)) return t;
+        }
+    }
+
+    // Index of `code`, or NONE.
+    std::uint32_t find(std::string_view code) const {
+        if (entries_.empty()) return NONE;
+        std::uint64_t h = hashCode(code, seed_);
+        std::uint64_t pos = position(h, pilots_[range(h, pilots_.size())]);
+        return (entries_[pos] >> 16) == fingerprint(h) ? (std::uint32_t)pos : NONE;
+    }
+
+    const CouponCampaign& campaignOf(std::uint32_t idx) const { return campaigns_[entries_[idx] & 0xffff]; }
+    const std::vector<CouponCampaign>& campaigns() const { return campaigns_; }
+
+    std::size_t size() const { return entries_.size(); }
+    std::size_t heapBytes() const {
+        std::size_t n = entries_.capacity() * sizeof(std::uint64_t) + pilots_.capacity() * sizeof(std::uint32_t) +
+                        campaigns_.capacity() * sizeof(CouponCampaign);
+        for (const CouponCampaign& c : campaigns_)
+            if (c.name.capacity() > 15) n += c.name.capacity() + 1;
+        return n;
+    }
+
+private:
+    static constexpr std::size_t CODES_PER_BUCKET = 4;
+    static constexpr std::uint32_t MAX_PILOT = 1u << 24; // per bucket, then reseed
+    static constexpr std::uint64_t MAX_SEEDS = 16;
+
+    CouponTable() = default;
+
+    static std::uint64_t mix(std::uint64_t x) { // splitmix64 finalizer
+        x ^= x >> 30;
+        x *= 0xbf58476d1ce4e5b9ULL;
+        x ^= x >> 27;
+        x *= 0x94d049bb133111ebULL;
+        return x ^ (x >> 31);
+    }
+    static std::uint64_t hashCode(std::string_view s, std::uint64_t seed) {
+        std::uint64_t h = mix(seed ^ (s.size() * 0x9e3779b97f4a7c15ULL));
+        std::size_t i = 0;
+        for (; i + 8 <= s.size(); i += 8) {
+            std::uint64_t w;
+            std::memcpy(&w, s.data() + i, 8);
+            h = mix(h ^ w);
+        }
+        std::uint64_t w = 0;
+        std::memcpy(&w, s.data() + i, s.size() - i);
+        return mix(h ^ w);
+    }
+    // x scaled onto [0, n) without a division.
+    static std::uint64_t range(std::uint64_t x, std::uint64_t n) {
+        return (std::uint64_t)(((unsigned __int128)x * n) >> 64);
+    }
+    static std::uint64_t fingerprint(std::uint64_t h) { return mix(h ^ 0x5bd1e9955bd1e995ULL) >> 16; }
+    std::uint64_t position(std::uint64_t h, std::uint32_t pilot) const {
+        return range(mix(h ^ (pilot * 0x9e3779b97f4a7c15ULL)), entries_.size());
+    }
+
+    bool tryBuild(const std::vector<CouponCode>& codes, std::uint64_t seed) {
+        std::size_t n = codes.size();
+        seed_ = seed;
+        entries_.assign(n, 0);
+        pilots_.assign(n ? (n + CODES_PER_BUCKET - 1) / CODES_PER_BUCKET : 0, 0);
+        if (!n) return true;
+
+        std::vector<std::uint64_t> hs(n);
+        for (std::size_t i = 0; i < n; ++i) hs[i] = hashCode(codes[i].code, seed);
+
+        // codes grouped by bucket (counting sort); equal hashes are either
+        // duplicate codes or a collision that a new seed resolves
+        std::size_t nb = pilots_.size();
+        std::vector<std::uint32_t> start(nb + 1, 0), keys(n);
+        for (std::uint64_t h : hs) ++start[range(h, nb) + 1];
+        for (std::size_t b = 0; b < nb; ++b) start[b + 1] += start[b];
+        std::vector<std::uint32_t> fill(start.begin(), start.end() - 1);
+        for (std::size_t i = 0; i < n; ++i) keys[fill[range(hs[i], nb)]++] = (std::uint32_t)i;
+        for (std::size_t b = 0; b < nb; ++b)
+            for (std::uint32_t i = start[b]; i < start[b + 1]; ++i)
+                for (std::uint32_t j = start[b]; j < i; ++j)
+                    if (hs[keys[i]] == hs[keys[j]]) {
+                        if (codes[keys[i]].code == codes[keys[j]].code)
+                            throw std::runtime_error("Duplicate coupon code: " + codes[keys[i]].code);
+                        return false;
+                    }
+
+        // largest buckets first, while most indices are still free
+        std::vector<std::uint32_t> order(nb);
+        for (std::size_t b = 0; b < nb; ++b) order[b] = (std::uint32_t)b;
+        std::stable_sort(order.begin(), order.end(), [&](std::uint32_t a, std::uint32_t b) {
+            return start[a + 1] - start[a] > start[b + 1] - start[b];
+        });
+
+        std::vector<bool> taken(n, false);
+        std::vector<std::uint64_t> pos;
+        for (std::uint32_t b : order) {
+            std::uint32_t lo = start[b], hi = start[b + 1];
+            if (lo == hi) break; // the rest are empty too
+            std::uint32_t pilot = 0;
+            for (;; ++pilot) {
+                if (pilot == MAX_PILOT) return false;
+                pos.clear();
+                bool ok = true;
+                for (std::uint32_t k = lo; k < hi && ok; ++k) {
+                    std::uint64_t p = position(hs[keys[k]], pilot);
+                    ok = !taken[p] && std::find(pos.begin(), pos.end(), p) == pos.end();
+                    pos.push_back(p);
+                }
+                if (ok) break;
+            }
+            pilots_[b] = pilot;
+            for (std::uint32_t k = lo; k < hi; ++k) {
+                std::uint64_t p = pos[k - lo];
+                taken[p] = true;
+                entries_[p] = (fingerprint(hs[keys[k]]) << 16) | codes[keys[k]].campaign;
+            }
+        }
+        return true;
+    }
+
+    std::uint64_t seed_ = 0;
+    std::vector<std::uint64_t> entries_; // fingerprint << 16 | campaign
+    std::vector<std::uint32_t> pilots_;
+    std::vector<CouponCampaign> campaigns_;
+};
+
+class CouponBook {
+public:
+    CouponBook() = default;
+    CouponBook(const CouponBook&) = delete;
+    CouponBook& operator=(const CouponBook&) = delete;
+    ~CouponBook() { delete table_.load(std::memory_order_relaxed); }
+
+    // Replaces the whole code set. Throws (keeping the current set) if the
+    // new one does not build. Lookups keep running during the build.
+    void load(std::vector<CouponCampaign> campaigns, const std::vector<CouponCode>& codes) {
+        std::unique_ptr<CouponTable> fresh = CouponTable::build(std::move(campaigns), codes);
+        const CouponTable* old = table_.exchange(fresh.release(), std::memory_order_acq_rel);
+        if (old) EpochDomain::instance().retire(old);
+    }
+
+    // The discount `code` gives, or nullopt for an unknown code. Lock-free.
+    std::optional<CouponDiscount> lookup(std::string_view code) const {
+        EpochGuard g;
+        const CouponTable* t = table_.load(std::memory_order_acquire);
+        if (!t) return std::nullopt;
+        std::uint32_t i = t->find(code);
+        if (i == CouponTable::NONE) return std::nullopt;
+        return t->campaignOf(i).discount;
+    }
+
+    std::size_t size() const {
+        EpochGuard g;
+        const CouponTable* t = table_.load(std::memory_order_acquire);
+        return t ? t->size() : 0;
+    }
+    std::size_t heapBytes() const {
+        EpochGuard g;
+        const CouponTable* t = table_.load(std::memory_order_acquire);
+        return t ? sizeof(CouponTable) + t->heapBytes() : 0;
+    }
+
+private:
+    std::atomic<const CouponTable*> table_{nullptr};
+};
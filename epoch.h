@@ -0,0 +1,172 @@
+#pragma once
+// ===================== Epoch-based reclamation =====================
+// Safe deferred frees for lock-free readers (RCU-style fee schedules, the
+// bill status array). Readers pin the current epoch for the duration of a
+// read; writers unlink an object and retire() it. A retired object is
+// freed once the global epoch has moved two steps past its retirement,
+// i.e. once every reader that could still hold it has unpinned.
+//
+//   { EpochGuard g; const FeeSchedule* s = cur.load(std::memory_order_acquire); use(*s); }
+//   const FeeSchedule* old = cur.exchange(fresh);
+//   EpochDomain::instance().retire(old);
+//
+// Each thread gets a record on first use (records are reused after the
+// thread exits). Retired objects queue on the retiring thread; every
+// RETIRE_BATCH retirements it tries to advance the epoch and frees what is
+// old enough, so garbage per writer thread stays around 3 * RETIRE_BATCH
+// as long as readers do not stay pinned. Objects left behind by exiting
+// threads move to a shared orphan list, freed by the next collect().
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+class EpochDomain {
+public:
+    static constexpr std::size_t RETIRE_BATCH = 64;
+
+    static EpochDomain& instance() { static EpochDomain d; return d; }
+
+    void pin() {
+        Record& r = record();
+        if (r.nest++ == 0) {
+            r.state.store((global_.load(std::memory_order_relaxed) << 1) | 1, std::memory_order_seq_cst);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+        }
+    }
+    void unpin() {
+        Record& r = record();
+        if (--r.nest == 0) r.state.store(0, std::memory_order_release);
+    }
+
+    // Frees p with deleter once no pinned reader can still reach it.
+    void retire(void* p, void (*deleter)(void*)) {
+        Record& r = record();
+        r.limbo.push_back(Retired{p, deleter, global_.load(std::memory_order_seq_cst)});
+        pending_.fetch_add(1, std::memory_order_relaxed);
+        if (r.limbo.size() % RETIRE_BATCH == 0) collect();
+    }
+    template <class T>
+    void retire(T* p) {
+        retire(const_cast<void*>(static_cast<const void*>(p)), [](void* q) { delete static_cast<T*>(q); });
+    }
+
+    // Advances the epoch if every pinned thread has seen the current one,
+    // then frees this thread's (and orphaned) objects that are old enough.
+    void collect() {
+        tryAdvance();
+        uint64_t safe = global_.load(std::memory_order_seq_cst);
+        Record& r = record();
+        freeOld(r.limbo, safe);
+        if (orphanCount_.load(std::memory_order_relaxed)) {
+            std::lock_guard<std::mutex> lk(orphanMu_);
+            freeOld(orphans_, safe);
+            orphanCount_.store(orphans_.size(), std::memory_order_relaxed);
+        }
+    }
+
+    uint64_t epoch() const { return global_.load(std::memory_order_relaxed); }
+    // Retired, not yet freed, across all threads.
+    std::size_t pending() const { return pending_.load(std::memory_order_relaxed); }
+
+private:
+    struct Retired {
+        void* p;
+        void (*deleter)(void*);
+        uint64_t epoch;
+    };
+
+    struct alignas(64) Record {
+        std::atomic<uint64_t> state{0}; // (epoch << 1) | pinned
+        std::atomic<bool> inUse{false};
+        int nest = 0;
+        std::vector<Retired> limbo;
+        Record* next = nullptr;
+    };
+
+    // Gives the record back when its thread exits.
+    struct Owner {
+        EpochDomain* domain = nullptr;
+        Record* rec = nullptr;
+        ~Owner() { if (rec) domain->release(*rec); }
+    };
+
+    EpochDomain() = default;
+
+    Record& record() {
+        thread_local Owner owner;
+        if (!owner.rec) {
+            owner.domain = this;
+            owner.rec = acquire();
+        }
+        return *owner.rec;
+    }
+
+    Record* acquire() {
+        for (Record* r = head_.load(std::memory_order_acquire); r; r = r->next) {
+            bool expected = false;
+            if (!r->inUse.load(std::memory_order_relaxed) &&
+                r->inUse.compare_exchange_strong(expected, true, std::memory_order_acquire))
+                return r;
+        }
+        Record* r = new Record; // never freed; reused by later threads
+        r->inUse.store(true, std::memory_order_relaxed);
+        Record* old = head_.load(std::memory_order_relaxed);
+        do r->next = old;
+        while (!head_.compare_exchange_weak(old, r, std::memory_order_release, std::memory_order_relaxed));
+        return r;
+    }
+
+    void release(Record& r) {
+        r.state.store(0, std::memory_order_release);
+        r.nest = 0;
+        if (!r.limbo.empty()) {
+            std::lock_guard<std::mutex> lk(orphanMu_);
+            orphans_.insert(orphans_.end(), r.limbo.begin(), r.limbo.end());
+            orphanCount_.store(orphans_.size(), std::memory_order_relaxed);
+            r.limbo.clear();
+        }
+        r.inUse.store(false, std::memory_order_release);
+    }
+
+    void tryAdvance() {
+        uint64_t e = global_.load(std::memory_order_seq_cst);
+        for (Record* r = head_.load(std::memory_order_acquire); r; r = r->next) {
+            uint64_t s = r->state.load(std::memory_order_seq_cst);
+            if ((s & 1) && (s >> 1) != e) return; // a reader is still in an older epoch
+        }
+        global_.compare_exchange_strong(e, e + 1, std::memory_order_seq_cst);
+    }
+
+    // Frees entries retired at least two epochs before `now`.
+    void freeOld(std::vector<Retired>& list, uint64_t now) {
+        std::size_t kept = 0;
+        for (Retired& x : list) {
+            if (x.epoch + 2 <= now) {
+                x.deleter(x.p);
+                pending_.fetch_sub(1, std::memory_order_relaxed);
+            } else {
+                list[kept++] = x;
+            }
+        }
+        list.resize(kept);
+    }
+
+    std::atomic<uint64_t> global_{2}; // starts at 2 so epoch - 2 never wraps
+    std::atomic<Record*> head_{nullptr};
+    std::atomic<std::size_t> pending_{0};
+    std::mutex orphanMu_;
+    std::vector<Retired> orphans_;
+    std::atomic<std::size_t> orphanCount_{0};
+};
+
+// Pins the calling thread's epoch for its lifetime; nests.
+class EpochGuard {
+public:
+    EpochGuard() { EpochDomain::instance().pin(); }
+    ~EpochGuard() { EpochDomain::instance().unpin(); }
+    EpochGuard(const EpochGuard&) = delete;
+    EpochGuard& operator=(const EpochGuard&) = delete;
+};
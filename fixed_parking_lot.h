@@ -0,0 +1,305 @@
+#pragma once
+// ===================== Fixed-size engine =====================
+// Local fallback engine for gate controllers on small boards. Floor count,
+// slots per floor and open-ticket capacity are template parameters; every
+// table is a fixed array inside the object, so there is no heap, and errors
+// come back as FixedLotStatus codes. Builds with -fno-exceptions -fno-rtti.
+// Slot allocation (first fit, floors in order) and fees come from
+// parking_core.h, as in the main engine; fees follow the FeeSchedule given
+// to setFeeSchedule (defaults until then). Expression tariffs, coupons,
+// day passes and fleet accounts exist only in the main engine.
+//
+//   static FixedParkingLot<4, 256, 1024> lot; // ~54KB, no allocation
+//   FixedFloorLayout layout[] = {{1, {40, 200, 16}}, {2, {0, 256, 0}}};
+//   lot.configure(layout, 2);
+//   TicketId t;
+//   if (lot.enterVehicle(VehicleType::Car, "KA01AB1234", t) == FixedLotStatus::Ok) ...
+//
+// Bills are returned to the caller, not stored: the fallback engine hands
+// them to whatever reconciles with the main engine later. Not thread-safe
+// by default; pass a mutex type as Lock when several threads share a lot.
+
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+
+#include "lot_clock.h"
+#include "parking_core.h"
+
+enum class FixedLotStatus : uint8_t {
+    Ok,
+    NoFreeSlot,
+    TicketTableFull, // MaxActive tickets already open
+    UnknownTicket,   // invalid or already closed
+    BadLayout,       // too many floors / slots for the template sizes, or an unregistered slot type
+    UnknownType,     // vehicle type not registered (TypeRegistry)
+};
+
+inline const char* fixedLotStatusName(FixedLotStatus s) {
+    switch (s) {
+        case FixedLotStatus::Ok:              return "ok";
+        case FixedLotStatus::NoFreeSlot:      return "no free slot";
+        case FixedLotStatus::TicketTableFull: return "ticket table full";
+        case FixedLotStatus::UnknownTicket:   return "invalid or already-closed ticket";
+        case FixedLotStatus::BadLayout:       return "layout exceeds engine size";
+        case FixedLotStatus::UnknownType:     return "unknown vehicle type";
+    }
+    return "?";
+}
+
+// Slots of each SlotType on one floor, indexed and laid out by type id
+// (two-wheeler, four-wheeler, heavy, then registered types).
+struct FixedFloorLayout {
+    int floorNo;
+    int slots[MAX_SLOT_TYPES];
+};
+
+constexpr std::size_t FIXED_REG_LEN = 16; // registration, NUL-terminated, truncated
+
+struct FixedSlot {
+    SlotType type = SlotType::FourWheeler;
+    bool isFree = true;
+};
+
+struct FixedTicket {
+    TicketId id = 0; // 0 = unused record
+    std::chrono::system_clock::time_point inTime;
+    uint16_t floor = 0; // floor index
+    uint16_t slot = 0;  // slot index on the floor
+    VehicleType vtype = VehicleType::Car;
+    SlotType stype = SlotType::FourWheeler;
+    char reg[FIXED_REG_LEN] = {};
+};
+
+struct FixedBill {
+    BillId id = 0;
+    TicketId ticket = 0;
+    int floorNo = 0;
+    int slot = 0; // 1-based, as in "F<floorNo>-S<slot>"
+    char reg[FIXED_REG_LEN] = {};
+    std::chrono::system_clock::time_point inTime, outTime;
+    unsigned long long parkedMinutes = 0;
+    unsigned long long billedHours = 0;
+    unsigned long long amount = 0; // INR
+};
+
+struct FixedNullLock {
+    void lock() {}
+    void unlock() {}
+};
+
+template <int Floors, int SlotsPerFloor, int MaxActive, class Lock = FixedNullLock>
+class FixedParkingLot {
+    static_assert(Floors > 0 && SlotsPerFloor > 0 && MaxActive > 0, "sizes must be positive");
+    static_assert(Floors <= 65535 && SlotsPerFloor <= 65535, "floor/slot indices are 16-bit");
+
+    // ticket id -> record index, open addressing; at most half full
+    static constexpr int indexSize() {
+        int n = 2;
+        while (n < 2 * MaxActive) n <<= 1;
+        return n;
+    }
+    static constexpr int INDEX_SIZE = indexSize();
+    static constexpr int32_t EMPTY = -1;
+
+public:
+    static constexpr int FLOORS = Floors;
+    static constexpr int SLOTS_PER_FLOOR = SlotsPerFloor;
+    static constexpr int MAX_ACTIVE = MaxActive;
+
+    FixedParkingLot() { reset(); }
+    FixedParkingLot(const FixedParkingLot&) = delete;
+    FixedParkingLot& operator=(const FixedParkingLot&) = delete;
+
+    // The clock must outlive the lot.
+    void setClock(const IClock& c) {
+        Guard g(mu_);
+        clock_ = &c;
+    }
+
+    // Pass the schedule given to ParkingLot::setFeeSchedule to bill alike.
+    void setFeeSchedule(const FeeSchedule& fs) {
+        Guard g(mu_);
+        fees_ = fs;
+    }
+
+    // Lays out floors and closes every ticket. On BadLayout the lot is left empty.
+    FixedLotStatus configure(const FixedFloorLayout* layout, int floorCount) {
+        Guard g(mu_);
+        reset();
+        if (floorCount < 0 || floorCount > Floors) return FixedLotStatus::BadLayout;
+        for (int f = 0; f < floorCount; ++f) {
+            int n = 0;
+            for (int t = 0; t < MAX_SLOT_TYPES; ++t) {
+                if (layout[f].slots[t] < 0 || layout[f].slots[t] > SlotsPerFloor - n ||
+                    (layout[f].slots[t] && !TypeRegistry::instance().isSlotType((SlotType)t))) {
+                    reset();
+                    return FixedLotStatus::BadLayout;
+                }
+                for (int k = 0; k < layout[f].slots[t]; ++k) floors_[f].slots[n++] = FixedSlot{(SlotType)t, true};
+            }
+            floors_[f].floorNo = layout[f].floorNo;
+            floors_[f].count = n;
+            totalSlots_ += n;
+        }
+        floorCount_ = floorCount;
+        return FixedLotStatus::Ok;
+    }
+
+    FixedLotStatus enterVehicle(VehicleType vt, const char* reg, TicketId& out) {
+        Guard g(mu_);
+        if (freeTop_ == 0) return FixedLotStatus::TicketTableFull;
+        if (!TypeRegistry::instance().isVehicleType(vt)) return FixedLotStatus::UnknownType;
+        SlotType need = slotFor(vt);
+        int chosenFloor = -1, idx = -1;
+        for (int f = 0; f < floorCount_; ++f) {
+            idx = firstFreeSlot(floors_[f].slots, floors_[f].count, need);
+            if (idx != -1) { chosenFloor = f; break; }
+        }
+        if (chosenFloor == -1) return FixedLotStatus::NoFreeSlot;
+        floors_[chosenFloor].slots[idx].isFree = false;
+
+        int32_t rec = freeList_[--freeTop_];
+        FixedTicket& tk = tickets_[rec];
+        tk.id = nextTicket_++;
+        tk.inTime = clock_->now();
+        tk.floor = (uint16_t)chosenFloor;
+        tk.slot = (uint16_t)idx;
+        tk.vtype = vt;
+        tk.stype = need;
+        copyReg(tk.reg, reg);
+        indexInsert(tk.id, rec);
+        ++used_;
+        out = tk.id;
+        return FixedLotStatus::Ok;
+    }
+
+    // exit -> compute fee -> bill (returned) -> free slot
+    FixedLotStatus exitVehicle(TicketId tid, bool lostTicket, FixedBill& out) {
+        Guard g(mu_);
+        int pos = indexFind(tid);
+        if (pos < 0) return FixedLotStatus::UnknownTicket;
+        int32_t rec = index_[pos];
+        FixedTicket& tk = tickets_[rec];
+        floors_[tk.floor].slots[tk.slot].isFree = true;
+
+        auto now = clock_->now();
+        FeeBreakup fb = computeFee(fees_, tk.stype, parkedMinutesBetween(tk.inTime, now));
+        if (lostTicket) fb.amount += fees_.lostTicketPenalty;
+
+        out = FixedBill{};
+        out.id = nextBill_++;
+        out.ticket = tid;
+        out.floorNo = floors_[tk.floor].floorNo;
+        out.slot = tk.slot + 1;
+        std::memcpy(out.reg, tk.reg, sizeof out.reg);
+        out.inTime = tk.inTime;
+        out.outTime = now;
+        out.parkedMinutes = fb.parkedMinutes;
+        out.billedHours = fb.billedHours;
+        out.amount = fb.amount;
+
+        indexErase(pos);
+        tk = FixedTicket{};
+        freeList_[freeTop_++] = rec;
+        --used_;
+        return FixedLotStatus::Ok;
+    }
+
+    // Copy of an open ticket; false if tid is not open.
+    bool findTicket(TicketId tid, FixedTicket& out) const {
+        Guard g(mu_);
+        int pos = indexFind(tid);
+        if (pos < 0) return false;
+        out = tickets_[index_[pos]];
+        return true;
+    }
+
+    void occupancy(int& freeCnt, int& usedCnt, int& total) const {
+        Guard g(mu_);
+        total = totalSlots_;
+        usedCnt = used_;
+        freeCnt = totalSlots_ - used_;
+    }
+
+    // "F<floorNo>-S<n>" for a ticket, the main engine's slot id format.
+    void slotLabel(const FixedTicket& tk, char* buf, std::size_t len) const {
+        std::snprintf(buf, len, "F%d-S%d", floors_[tk.floor].floorNo, tk.slot + 1);
+    }
+
+private:
+    struct Guard {
+        Lock& l;
+        explicit Guard(Lock& m) : l(m) { l.lock(); }
+        ~Guard() { l.unlock(); }
+    };
+
+    struct FloorState {
+        int floorNo = 0;
+        int count = 0; // configured slots
+        FixedSlot slots[SlotsPerFloor];
+    };
+
+    void reset() {
+        for (auto& f : floors_) { f.floorNo = 0; f.count = 0; }
+        for (auto& tk : tickets_) tk = FixedTicket{};
+        for (auto& e : index_) e = EMPTY;
+        for (int i = 0; i < MaxActive; ++i) freeList_[i] = MaxActive - 1 - i; // pop record 0 first
+        freeTop_ = MaxActive;
+        floorCount_ = totalSlots_ = used_ = 0;
+        nextTicket_ = 1;
+        nextBill_ = 1;
+    }
+
+    static void copyReg(char* dst, const char* src) {
+        std::size_t n = src ? std::strlen(src) : 0;
+        if (n >= FIXED_REG_LEN) n = FIXED_REG_LEN - 1;
+        if (n) std::memcpy(dst, src, n); // src may be null when n is 0
+        dst[n] = '\0';
+    }
+
+    static int home(TicketId id) {
+        return (int)((id * 0x9E3779B97F4A7C15ULL) >> 40) & (INDEX_SIZE - 1);
+    }
+
+    int indexFind(TicketId id) const {
+        if (id == 0) return -1;
+        for (int p = home(id);; p = (p + 1) & (INDEX_SIZE - 1)) {
+            int32_t rec = index_[p];
+            if (rec == EMPTY) return -1;
+            if (tickets_[rec].id == id) return p;
+        }
+    }
+
+    void indexInsert(TicketId id, int32_t rec) {
+        int p = home(id);
+        while (index_[p] != EMPTY) p = (p + 1) & (INDEX_SIZE - 1);
+        index_[p] = rec;
+    }
+
+    // Backward-shift deletion: no tombstones, so probes stay short forever.
+    void indexErase(int hole) {
+        index_[hole] = EMPTY;
+        for (int p = (hole + 1) & (INDEX_SIZE - 1); index_[p] != EMPTY; p = (p + 1) & (INDEX_SIZE - 1)) {
+            int h = home(tickets_[index_[p]].id);
+            // move p into the hole unless its home lies cyclically in (hole, p]
+            bool stays = hole <= p ? (h > hole && h <= p) : (h > hole || h <= p);
+            if (stays) continue;
+            index_[hole] = index_[p];
+            index_[p] = EMPTY;
+            hole = p;
+        }
+    }
+
+    FloorState floors_[Floors];
+    FixedTicket tickets_[MaxActive];
+    int32_t index_[INDEX_SIZE];
+    int32_t freeList_[MaxActive];
+    int freeTop_ = 0;
+    int floorCount_ = 0, totalSlots_ = 0, used_ = 0;
+    TicketId nextTicket_ = 1;
+    BillId nextBill_ = 1;
+    const IClock* clock_ = &SystemClock::instance();
+    FeeSchedule fees_;
+    mutable Lock mu_;
+};
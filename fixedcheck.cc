@@ -0,0 +1,175 @@
+// ===================== Fixed-engine differential checker =====================
+// Runs random enter/exit/advance sequences on ParkingLot and on the embedded
+// FixedParkingLot (fixed_parking_lot.h) with the same layout, clock and a
+// random FeeSchedule, and compares every ticket id, slot, duration and
+// amount. The fixed engine lives in fixedcheck_engine.cc, built with
+// -fno-exceptions -fno-rtti like a gate controller; its runs must not
+// touch the heap (counted through operator new here).
+//
+//   g++ -std=c++17 -O2 -fno-exceptions -fno-rtti -c fixedcheck_engine.cc
+//   g++ -std=c++17 -O2 -pthread fixedcheck.cc fixedcheck_engine.o -o fixedcheck
+//   ./fixedcheck [--seed S] [--iterations N] [--ops N]
+
+#define PARKINGLOT_NO_MAIN
+#include "Parkinglot.cc"
+#include "fixedcheck.h"
+
+#include <new>
+#include <random>
+#include <sstream>
+
+static std::atomic<uint64_t> g_heapAllocs{0};
+
+// noinline for the same reason as in bench_util.h (-Wmismatched-new-delete).
+__attribute__((noinline)) void* operator new(size_t n) {
+    g_heapAllocs.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = std::malloc(n ? n : 1)) return p;
+    throw std::bad_alloc();
+}
+__attribute__((noinline)) void operator delete(void* p) noexcept { std::free(p); }
+__attribute__((noinline)) void operator delete(void* p, size_t) noexcept { std::free(p); }
+
+struct ManualClock final : IClock {
+    std::chrono::system_clock::time_point t;
+    std::chrono::system_clock::time_point now() const override { return t; }
+};
+
+static const char kExtraSlotType[] = "EVCharging";
+
+// ParkingLot's errors under the fixed engine's status names.
+static const char* statusOf(const string& error) {
+    if (error == "No free slot available") return fixedLotStatusName(FixedLotStatus::NoFreeSlot);
+    if (error == "Unknown vehicle type") return fixedLotStatusName(FixedLotStatus::UnknownType);
+    if (error == "Invalid or already-closed ticket") return fixedLotStatusName(FixedLotStatus::UnknownTicket);
+    return "unexpected error";
+}
+
+static string describe(const FixedCheckOp& op, const FixedCheckResult& r) {
+    static const char* kinds[] = {"enter", "exit", "advance"};
+    ostringstream os;
+    os << kinds[(int)op.kind] << " vtype=" << (int)op.vtype << " tid=" << op.tid << " lost=" << op.lost
+       << " minutes=" << op.minutes << " -> " << r.status << " ticket " << r.ticket << " slot F"
+       << r.floorNo << "-S" << r.slot << " mins " << r.parkedMinutes << " hours " << r.billedHours
+       << " amount " << r.amount;
+    return os.str();
+}
+
+static bool runOnce(uint64_t seed, int ops) {
+    mt19937_64 rng(seed);
+    const int slotTypes = TypeRegistry::instance().slotTypes();
+
+    // Same layout for both engines: per floor, slots grouped by type in id
+    // order, which is how the fixed engine lays them out.
+    FixedFloorLayout layout[FIXEDCHECK_FLOORS] = {};
+    vector<Floor> floors(1 + rng() % FIXEDCHECK_FLOORS);
+    for (size_t f = 0; f < floors.size(); ++f) {
+        layout[f].floorNo = floors[f].floorNo = (int)f + 1;
+        int room = FIXEDCHECK_SLOTS;
+        for (int t = 0; t < slotTypes && room > 0; ++t) {
+            int n = (int)(rng() % (room + 1)) / 2;
+            layout[f].slots[t] = n;
+            room -= n;
+            for (int k = 0; k < n; ++k) {
+                int slotNo = (int)floors[f].slots.size() + 1;
+                floors[f].slots.push_back(ParkingSlot{"F" + to_string(f + 1) + "-S" + to_string(slotNo),
+                                                      (SlotType)t, true});
+            }
+        }
+    }
+
+    FeeSchedule fees;
+    fees.graceMinutes = rng() % 30;
+    fees.lostTicketPenalty = rng() % 500;
+    for (int t = 0; t < slotTypes; ++t)
+        if (rng() % 2) fees.hourly[t] = 5 + rng() % 100;
+
+    vector<FixedCheckOp> seq(ops);
+    TicketId issued = 0;
+    for (auto& op : seq) {
+        unsigned r = (unsigned)(rng() % 100);
+        if (r < 40) {
+            op.kind = FixedCheckOpKind::Enter;
+            // now and then a type nobody registered
+            op.vtype = (VehicleType)(rng() % (TypeRegistry::instance().vehicleTypes() + 1));
+            ++issued;
+        } else if (r < 75) {
+            op.kind = FixedCheckOpKind::Exit;
+            op.tid = 1 + rng() % (issued + 2);
+            op.lost = rng() % 10 == 0;
+        } else {
+            op.minutes = (unsigned)(rng() % 300);
+        }
+    }
+
+    const int64_t start = 29000000 + (int64_t)(rng() % 100000);
+    vector<FixedCheckResult> fixed(ops);
+    uint64_t allocs = g_heapAllocs.load(std::memory_order_relaxed);
+    runFixedEngine(layout, (int)floors.size(), fees, start, seq.data(), seq.size(), fixed.data());
+    if (uint64_t n = g_heapAllocs.load(std::memory_order_relaxed) - allocs) {
+        cerr << "[fixedcheck] HEAP USE seed=" << seed << ": fixed engine made " << n << " allocations\n";
+        return false;
+    }
+
+    ManualClock clock;
+    clock.t = std::chrono::system_clock::time_point(std::chrono::minutes(start));
+    ParkingLot lot;
+    lot.setClock(clock);
+    lot.configure(floors);
+    lot.setFeeSchedule(fees);
+    for (int i = 0; i < ops; ++i) {
+        const FixedCheckOp& op = seq[i];
+        FixedCheckResult want;
+        try {
+            switch (op.kind) {
+            case FixedCheckOpKind::Enter: {
+                Vehicle v("KA01AB1234", op.vtype);
+                want.ticket = lot.enterVehicle("E1", v);
+                break;
+            }
+            case FixedCheckOpKind::Exit: {
+                Bill b = lot.exitVehicle(op.tid, "X1", op.lost);
+                want.ticket = b.ticket;
+                // "F<floorNo>-S<slot>"
+                sscanf(b.slotId.c_str(), "F%d-S%d", &want.floorNo, &want.slot);
+                want.parkedMinutes = b.parkedMinutes;
+                want.billedHours = b.billedHours;
+                want.amount = b.amount;
+                break;
+            }
+            case FixedCheckOpKind::Advance:
+                clock.t += std::chrono::minutes(op.minutes);
+                break;
+            }
+        } catch (const std::exception& e) {
+            want = FixedCheckResult{statusOf(e.what())};
+        }
+        string got = describe(op, fixed[i]), exp = describe(op, want);
+        if (got != exp) {
+            cerr << "[fixedcheck] MISMATCH seed=" << seed << " op#" << i << "\n  fixed:     " << got
+                 << "\n  ParkingLot: " << exp << "\n";
+            return false;
+        }
+    }
+    return true;
+}
+
+int main(int argc, char** argv) {
+    uint64_t seed = std::random_device{}();
+    int iterations = 200, ops = 2000;
+    for (int i = 1; i < argc; ++i) {
+        string a = argv[i];
+        if (i + 1 >= argc) { cerr << "missing value for " << a << "\n"; return 2; }
+        const char* v = argv[++i];
+        if      (a == "--seed")       seed = stoull(v);
+        else if (a == "--iterations") iterations = atoi(v);
+        else if (a == "--ops")        ops = atoi(v);
+        else { cerr << "unknown option " << a << "\n"; return 2; }
+    }
+    if (iterations <= 0 || ops <= 0) { cerr << "--iterations and --ops must be positive\n"; return 2; }
+    registerVehicleType("EVCar", registerSlotType(kExtraSlotType, 30));
+
+    cout << "fixedcheck seed=" << seed << " iterations=" << iterations << "\n";
+    for (int it = 0; it < iterations; ++it)
+        if (!runOnce(seed + (uint64_t)it, ops)) return 1;
+    cout << "fixedcheck: OK\n";
+}
@@ -0,0 +1,38 @@
+#pragma once
+// ===================== Fixed-engine check interface =====================
+// Boundary between fixedcheck.cc (ParkingLot, built with exceptions) and
+// fixedcheck_engine.cc (FixedParkingLot, built -fno-exceptions -fno-rtti,
+// as on a gate controller). Only plain data crosses it.
+
+#include <cstddef>
+#include <cstdint>
+
+#include "fixed_parking_lot.h"
+
+constexpr int FIXEDCHECK_FLOORS = 4;
+constexpr int FIXEDCHECK_SLOTS = 16;  // per floor
+constexpr int FIXEDCHECK_ACTIVE = 64; // = floors x slots, so the ticket table never fills first
+
+enum class FixedCheckOpKind : uint8_t { Enter, Exit, Advance };
+
+struct FixedCheckOp {
+    FixedCheckOpKind kind = FixedCheckOpKind::Advance;
+    VehicleType vtype = VehicleType::Car;
+    TicketId tid = 0;
+    bool lost = false;
+    unsigned minutes = 0; // Advance
+};
+
+// One op's outcome. status is fixedLotStatusName(); fixedcheck.cc maps
+// ParkingLot's errors onto the same names.
+struct FixedCheckResult {
+    const char* status = "ok";
+    TicketId ticket = 0;
+    int floorNo = 0, slot = 0;
+    unsigned long long parkedMinutes = 0, billedHours = 0, amount = 0;
+};
+
+// Configures the statically allocated fixed lot, points its clock at
+// startMinutes since the epoch and runs ops; out[i] is ops[i]'s outcome.
+void runFixedEngine(const FixedFloorLayout* layout, int floors, const FeeSchedule& fees,
+                    std::int64_t startMinutes, const FixedCheckOp* ops, std::size_t n, FixedCheckResult* out);
@@ -0,0 +1,62 @@
+// ===================== Fixed-engine half of fixedcheck =====================
+// Runs fixedcheck's op sequence on FixedParkingLot. Built with the gate
+// controller's flags, so this also proves fixed_parking_lot.h needs no
+// exceptions and no RTTI; see fixedcheck.cc for the build lines.
+
+#include "fixedcheck.h"
+
+#if defined(__cpp_exceptions) || defined(__GXX_RTTI)
+#error "build fixedcheck_engine.cc with -fno-exceptions -fno-rtti"
+#endif
+
+namespace {
+
+struct StepClock final : IClock {
+    std::chrono::system_clock::time_point t;
+    std::chrono::system_clock::time_point now() const override { return t; }
+};
+
+// static storage, as on the board
+FixedParkingLot<FIXEDCHECK_FLOORS, FIXEDCHECK_SLOTS, FIXEDCHECK_ACTIVE> g_lot;
+StepClock g_clock;
+
+} // namespace
+
+void runFixedEngine(const FixedFloorLayout* layout, int floors, const FeeSchedule& fees,
+                    std::int64_t startMinutes, const FixedCheckOp* ops, std::size_t n, FixedCheckResult* out) {
+    g_clock.t = std::chrono::system_clock::time_point(std::chrono::minutes(startMinutes));
+    g_lot.setClock(g_clock);
+    g_lot.setFeeSchedule(fees);
+    FixedLotStatus st = g_lot.configure(layout, floors);
+    if (st != FixedLotStatus::Ok) { // every op reports the layout error
+        for (std::size_t i = 0; i < n; ++i) out[i] = FixedCheckResult{fixedLotStatusName(st)};
+        return;
+    }
+    for (std::size_t i = 0; i < n; ++i) {
+        const FixedCheckOp& op = ops[i];
+        FixedCheckResult& r = out[i] = FixedCheckResult{};
+        switch (op.kind) {
+        case FixedCheckOpKind::Enter:
+            st = g_lot.enterVehicle(op.vtype, "KA01AB1234", r.ticket);
+            break;
+        case FixedCheckOpKind::Exit: {
+            FixedBill b;
+            st = g_lot.exitVehicle(op.tid, op.lost, b);
+            if (st == FixedLotStatus::Ok) {
+                r.ticket = b.ticket;
+                r.floorNo = b.floorNo;
+                r.slot = b.slot;
+                r.parkedMinutes = b.parkedMinutes;
+                r.billedHours = b.billedHours;
+                r.amount = b.amount;
+            }
+            break;
+        }
+        case FixedCheckOpKind::Advance:
+            g_clock.t += std::chrono::minutes(op.minutes);
+            st = FixedLotStatus::Ok;
+            break;
+        }
+        r.status = fixedLotStatusName(st);
+    }
+}
@@ -0,0 +1,238 @@
+#pragma once
+// ===================== Flat combining =====================
+// Delegation instead of lock hand-off: a thread publishes its operation in
+// its own record; whichever thread holds the combiner lock runs every
+// published operation in one pass while the owners spin on their records.
+// Under heavy contention the shared data stays in one core's cache and the
+// lock changes hands once per batch instead of once per operation.
+//
+//   FlatCombiner fc;
+//   int n = fc.run([&] { return table.size(); }); // exceptions reach the caller
+//
+// Each thread claims a record on its first run() against a combiner and
+// returns it when the thread exits; while MAX_RECORDS threads hold one,
+// newcomers take the combiner lock directly, so they are still correct but
+// get no batching, and retry the claim on their next run(). A destroyed
+// combiner drops out of every thread's record list. Claims and both
+// cleanups share one registry lock; run() never takes it once the thread
+// holds a record.
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <new>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+class FlatCombiner {
+public:
+    static constexpr int MAX_RECORDS = 128;
+    static constexpr int COMBINE_PASSES = 3; // re-scan while passes find work
+
+    FlatCombiner() : id_(nextId().fetch_add(1, std::memory_order_relaxed)) {}
+    FlatCombiner(const FlatCombiner&) = delete;
+    FlatCombiner& operator=(const FlatCombiner&) = delete;
+
+    ~FlatCombiner() {
+        Registry& reg = registry();
+        std::lock_guard<std::mutex> lk(reg.mu);
+        for (ThreadRecords* t : reg.threads)
+            for (Entry& e : t->entries)
+                if (e.id.load(std::memory_order_relaxed) == id_) e.id.store(0, std::memory_order_relaxed);
+    }
+
+    // Runs fn() mutually exclusive with every other run() on this combiner.
+    template <class F>
+    auto run(F&& fn) -> decltype(fn()) {
+        using R = decltype(fn());
+        if constexpr (std::is_void_v<R>) {
+            Call<F, char> call(fn);
+            execute(call);
+        } else {
+            Call<F, R> call(fn);
+            execute(call);
+            return std::move(*call.result());
+        }
+    }
+
+    // Operations applied in combining passes, and the number of passes;
+    // combined() / passes() is the mean batch size.
+    uint64_t combined() const { return combined_.load(std::memory_order_relaxed); }
+    uint64_t passes() const { return passes_.load(std::memory_order_relaxed); }
+
+private:
+    struct CallBase {
+        void (*apply)(CallBase*) = nullptr;
+        std::exception_ptr error;
+    };
+
+    template <class F, class R>
+    struct Call : CallBase {
+        F& fn;
+        alignas(R) unsigned char storage[sizeof(R)];
+        bool has = false;
+        explicit Call(F& f) : fn(f) {
+            apply = [](CallBase* b) {
+                auto* self = static_cast<Call*>(b);
+                if constexpr (std::is_void_v<decltype(self->fn())>) {
+                    self->fn();
+                } else {
+                    new (self->storage) R(self->fn());
+                    self->has = true;
+                }
+            };
+        }
+        ~Call() { if (has) result()->~R(); }
+        R* result() { return reinterpret_cast<R*>(storage); }
+    };
+
+    enum : uint32_t { IDLE, PENDING, DONE };
+
+    struct alignas(64) Record {
+        std::atomic<uint32_t> state{IDLE};
+        CallBase* call = nullptr;
+        bool owned = false; // under the registry lock
+    };
+
+    // One combiner this thread has used. id 0 marks a free entry.
+    struct Entry {
+        std::atomic<uint64_t> id{0};
+        FlatCombiner* owner = nullptr;
+        int rec = -1;
+    };
+
+    // A thread's entries. The thread reads them without a lock; inserts,
+    // the combiner destructor and the thread-exit release hold the
+    // registry lock. A deque, so inserts never move an entry.
+    struct ThreadRecords {
+        std::deque<Entry> entries;
+        ThreadRecords() {
+            Registry& reg = registry();
+            std::lock_guard<std::mutex> lk(reg.mu);
+            reg.threads.push_back(this);
+        }
+        ~ThreadRecords() {
+            Registry& reg = registry();
+            std::lock_guard<std::mutex> lk(reg.mu);
+            for (Entry& e : entries)
+                if (e.id.load(std::memory_order_relaxed)) e.owner->records_[e.rec].owned = false;
+            reg.threads.erase(std::find(reg.threads.begin(), reg.threads.end(), this));
+        }
+    };
+
+    struct Registry {
+        std::mutex mu;
+        std::vector<ThreadRecords*> threads;
+    };
+    // Never destroyed: static combiners may outlive function-local statics.
+    static Registry& registry() { static Registry* r = new Registry; return *r; }
+
+    static std::atomic<uint64_t>& nextId() { static std::atomic<uint64_t> n{1}; return n; }
+
+    // This thread's record on this combiner, or -1 when all are taken. A
+    // -1 is not cached, so a later call claims a record freed meanwhile.
+    int myRecord() {
+        thread_local ThreadRecords mine;
+        for (Entry& e : mine.entries)
+            if (e.id.load(std::memory_order_relaxed) == id_) return e.rec;
+        std::lock_guard<std::mutex> lk(registry().mu);
+        int rec = claimRecord();
+        if (rec < 0) return -1;
+        Entry* slot = nullptr;
+        for (Entry& e : mine.entries)
+            if (!e.id.load(std::memory_order_relaxed)) { slot = &e; break; }
+        if (!slot) slot = &mine.entries.emplace_back();
+        slot->owner = this;
+        slot->rec = rec;
+        slot->id.store(id_, std::memory_order_relaxed);
+        return rec;
+    }
+
+    // A record released by an exited thread, else a fresh one; under the
+    // registry lock. combine() scans up to used_, the high-water mark.
+    int claimRecord() {
+        int n = used_.load(std::memory_order_relaxed);
+        for (int i = 0; i < n; ++i)
+            if (!records_[i].owned) { records_[i].owned = true; return i; }
+        if (n >= MAX_RECORDS) return -1;
+        records_[n].owned = true;
+        used_.store(n + 1, std::memory_order_release);
+        return n;
+    }
+
+    void execute(CallBase& call) {
+        int rec = myRecord();
+        if (rec < 0) { // no record: plain spin lock
+            while (!tryLock()) cpuPause();
+            applyOne(call);
+            unlock();
+        } else {
+            Record& r = records_[rec];
+            r.call = &call;
+            r.state.store(PENDING, std::memory_order_release);
+            for (uint32_t spins = 0; r.state.load(std::memory_order_acquire) != DONE; ++spins) {
+                if (tryLock()) {
+                    combine();
+                    unlock();
+                } else if (spins < 1024) {
+                    cpuPause();
+                } else {
+                    std::this_thread::yield();
+                }
+            }
+            r.state.store(IDLE, std::memory_order_relaxed);
+        }
+        if (call.error) std::rethrow_exception(call.error);
+    }
+
+    void combine() {
+        int n = used_.load(std::memory_order_acquire);
+        uint64_t applied = 0;
+        for (int pass = 0; pass < COMBINE_PASSES; ++pass) {
+            bool found = false;
+            for (int i = 0; i < n; ++i) {
+                Record& r = records_[i];
+                if (r.state.load(std::memory_order_acquire) != PENDING) continue;
+                applyOne(*r.call);
+                r.state.store(DONE, std::memory_order_release);
+                found = true;
+                ++applied;
+            }
+            if (!found) break;
+        }
+        passes_.fetch_add(1, std::memory_order_relaxed);
+        combined_.fetch_add(applied, std::memory_order_relaxed);
+    }
+
+    static void applyOne(CallBase& c) {
+        try {
+            c.apply(&c);
+        } catch (...) {
+            c.error = std::current_exception();
+        }
+    }
+
+    bool tryLock() {
+        return !locked_.load(std::memory_order_relaxed) && !locked_.exchange(true, std::memory_order_acquire);
+    }
+    void unlock() { locked_.store(false, std::memory_order_release); }
+
+    static void cpuPause() {
+#if defined(__x86_64__) || defined(__i386__)
+        __builtin_ia32_pause();
+#elif defined(__aarch64__)
+        asm volatile("yield");
+#endif
+    }
+
+    const uint64_t id_;
+    alignas(64) std::atomic<bool> locked_{false};
+    alignas(64) std::atomic<int> used_{0};
+    std::atomic<uint64_t> combined_{0}, passes_{0};
+    Record records_[MAX_RECORDS];
+};
@@ -0,0 +1,198 @@
+#pragma once
+// ===================== Fleet ledger =====================
+// Fleet accounts for logistics partners: their plates are mapped to an
+// account, and an exit of such a plate appends a FleetCharge to the ledger
+// instead of creating a payable Bill. The account is invoiced once a month.
+//
+// Charges are 32-byte records in an append-only log: a fixed directory of
+// 256K-charge (8MB) chunks, as in atomic_status_array.h. A chunk is
+// allocated, uninitialized, when the first charge lands in it and is never
+// moved or freed before the ledger, so readers need no lock. append()
+// writes the record and then publishes the new size with a release store;
+// a reader that loads the size with acquire sees every record below it.
+//
+// aggregate() builds the invoices of a period in one pass over the log.
+// The log is split into equal ranges, one per thread. Each thread sums its
+// range into its own array of per-account totals, indexed by the dense
+// account id, so there is no hashing, locking or shared cache line in the
+// loop. The arrays are then added up, which costs threads x accounts.
+//
+// Accounts, plates and append() are not thread-safe; the caller serializes
+// them (ParkingLot uses its lot lock). aggregate() may run alongside them.
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "memory_accounting.h"
+#include "parking_core.h"
+
+using FleetAccountId = std::uint32_t;
+
+struct FleetCharge {
+    TicketId ticket = 0;
+    std::uint32_t outMinute = 0;     // exit time, minutes since the epoch (UTC)
+    FleetAccountId account = 0;
+    std::uint32_t parkedMinutes = 0;
+    std::uint32_t billedHours = 0;
+    std::uint64_t amount = 0;        // INR, after coupon and lost-ticket penalty
+};
+
+struct FleetInvoice {
+    FleetAccountId account = 0;
+    std::string name;
+    std::uint64_t charges = 0;
+    std::uint64_t parkedMinutes = 0;
+    std::uint64_t billedHours = 0;
+    std::uint64_t amount = 0;
+};
+
+// Days from 1970-01-01 to the given date of the proleptic Gregorian
+// calendar (H. Hinnant's days_from_civil).
+inline long long daysFromCivil(int y, unsigned m, unsigned d) {
+    y -= m <= 2;
+    long long era = (y >= 0 ? y : y - 399) / 400;
+    unsigned yoe = (unsigned)(y - era * 400);
+    unsigned doy = (153 * (m + (m > 2 ? -3 : 9)) + 2) / 5 + d - 1;
+    unsigned doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    return era * 146097 + (long long)doe - 719468;
+}
+
+class FleetLedger {
+public:
+    static constexpr unsigned CHUNK_BITS = 18;
+    static constexpr std::size_t CHUNK = std::size_t(1) << CHUNK_BITS; // charges per chunk
+    static constexpr std::size_t DIR = 4096;                           // chunks
+    // Below this many charges per thread, extra threads cost more than they save.
+    static constexpr std::size_t MIN_PER_THREAD = 1 << 16;
+
+    FleetLedger() {
+        for (auto& d : dir_) d.store(nullptr, std::memory_order_relaxed);
+    }
+    FleetLedger(const FleetLedger&) = delete;
+    FleetLedger& operator=(const FleetLedger&) = delete;
+    ~FleetLedger() {
+        for (auto& d : dir_) ::operator delete(d.load(std::memory_order_relaxed));
+    }
+
+    static constexpr std::uint64_t capacity() { return (std::uint64_t)CHUNK * DIR; }
+
+    // ---- Accounts and plates ----
+    // Returns the new account's id; ids are dense, from 0.
+    FleetAccountId addAccount(const std::string& name) {
+        if (std::find(names_.begin(), names_.end(), name) != names_.end())
+            throw std::runtime_error("Duplicate fleet account: " + name);
+        names_.push_back(name);
+        return (FleetAccountId)(names_.size() - 1);
+    }
+    std::size_t accounts() const { return names_.size(); }
+    const std::string& name(FleetAccountId a) const { return names_.at(a); }
+
+    // A plate belongs to at most one account; assigning it again moves it.
+    void assignPlate(const std::string& plate, FleetAccountId a) {
+        if (a >= names_.size()) throw std::runtime_error("Unknown fleet account");
+        plates_[plate] = a;
+    }
+    void unassignPlate(const std::string& plate) { plates_.erase(plate); }
+    std::optional<FleetAccountId> accountOf(const std::string& plate) const {
+        if (plates_.empty()) return std::nullopt; // no fleets: no hashing on exit
+        auto it = plates_.find(plate);
+        if (it == plates_.end()) return std::nullopt;
+        return it->second;
+    }
+
+    // ---- Charges ----
+    void append(const FleetCharge& c) {
+        std::size_t n = size_.load(std::memory_order_relaxed);
+        if (n >= capacity()) throw std::runtime_error("Fleet ledger full");
+        FleetCharge* chunk = dir_[n >> CHUNK_BITS].load(std::memory_order_relaxed);
+        if (!chunk) {
+            chunk = static_cast<FleetCharge*>(::operator new(CHUNK * sizeof(FleetCharge)));
+            dir_[n >> CHUNK_BITS].store(chunk, std::memory_order_release);
+        }
+        new (chunk + (n & (CHUNK - 1))) FleetCharge(c);
+        size_.store(n + 1, std::memory_order_release);
+    }
+    std::size_t size() const { return size_.load(std::memory_order_acquire); }
+    FleetCharge charge(std::size_t i) const {
+        return dir_[i >> CHUNK_BITS].load(std::memory_order_acquire)[i & (CHUNK - 1)];
+    }
+
+    // Per-account totals of the first `n` charges whose outMinute is in
+    // [fromMinute, toMinute), for accounts [0, accounts); `n` and
+    // `accounts` come from one snapshot, so every charge counted names a
+    // known account. threads == 0 uses every core. Accounts without
+    // charges are left out; names are left empty.
+    std::vector<FleetInvoice> aggregate(std::size_t n, std::uint32_t fromMinute, std::uint32_t toMinute,
+                                        std::size_t accounts, unsigned threads = 0) const {
+        if (threads == 0) threads = std::max(1u, std::thread::hardware_concurrency());
+        threads = (unsigned)std::min<std::size_t>(threads, n / MIN_PER_THREAD + 1);
+        std::vector<std::vector<Totals>> part(threads, std::vector<Totals>(accounts));
+
+        auto work = [&](unsigned t) {
+            Totals* acc = part[t].data();
+            std::size_t i = n * t / threads, hi = n * (t + 1) / threads;
+            while (i < hi) {
+                const FleetCharge* c = dir_[i >> CHUNK_BITS].load(std::memory_order_acquire);
+                std::size_t end = std::min(hi, ((i >> CHUNK_BITS) + 1) << CHUNK_BITS);
+                for (; i < end; ++i) {
+                    const FleetCharge& ch = c[i & (CHUNK - 1)];
+                    if (ch.outMinute < fromMinute || ch.outMinute >= toMinute) continue;
+                    Totals& a = acc[ch.account];
+                    ++a.charges;
+                    a.parkedMinutes += ch.parkedMinutes;
+                    a.billedHours += ch.billedHours;
+                    a.amount += ch.amount;
+                }
+            }
+        };
+        std::vector<std::thread> pool;
+        for (unsigned t = 1; t < threads; ++t) pool.emplace_back(work, t);
+        work(0);
+        for (auto& th : pool) th.join();
+
+        std::vector<FleetInvoice> out;
+        for (std::size_t a = 0; a < accounts; ++a) {
+            FleetInvoice inv;
+            inv.account = (FleetAccountId)a;
+            for (const auto& p : part) {
+                inv.charges += p[a].charges;
+                inv.parkedMinutes += p[a].parkedMinutes;
+                inv.billedHours += p[a].billedHours;
+                inv.amount += p[a].amount;
+            }
+            if (inv.charges) out.push_back(std::move(inv));
+        }
+        return out;
+    }
+
+    // Charge chunks plus the account and plate tables; same threading rule
+    // as the account calls.
+    std::size_t heapBytes() const {
+        std::size_t n = 0;
+        for (auto& d : dir_)
+            if (d.load(std::memory_order_relaxed)) n += mallocChunkBytes(CHUNK * sizeof(FleetCharge));
+        n += vectorHeapBytes(names_) + hashMapHeapBytes(plates_);
+        for (auto& s : names_) n += stringHeapBytes(s);
+        for (auto& [plate, a] : plates_) n += stringHeapBytes(plate);
+        return n;
+    }
+
+private:
+    struct Totals {
+        std::uint64_t charges = 0, parkedMinutes = 0, billedHours = 0, amount = 0;
+    };
+
+    std::vector<std::string> names_;
+    std::unordered_map<std::string, FleetAccountId> plates_;
+    std::atomic<std::size_t> size_{0};
+    std::atomic<FleetCharge*> dir_[DIR];
+};
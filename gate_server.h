@@ -0,0 +1,350 @@
+#pragma once
+// ===================== Gate request loop =====================
+// Gate clients (barrier controllers, kiosks, dashboards) submit GateCalls;
+// worker threads pop them from a lock-free queue and run them against the
+// ParkingLot. Include after Parkinglot.cc.
+//
+//   GateServer srv(lot, cfg);
+//   GateCall call;
+//   call.req = GateRequest::enter("E1", car);
+//   if (srv.submit(call)) call.wait();
+//
+// WaitMode::Block (default): idle workers sleep on a condition variable and
+// clients block until their call completes; cheap on CPU, but every
+// request after a quiet spell pays a wake-up.
+// WaitMode::BusyPoll: workers own dedicated cores (GateServerConfig::cpus)
+// and poll the queue; when idle they back off adaptively (pause-spin, then
+// yield, then exponentially longer sleeps up to maxIdleSleep) and snap back
+// to spinning on the next request. Clients spin on their call.
+//
+// Requests are split into classes served in strict priority order
+// (exit > entry > payment > status), each with its own queue. A class is
+// shed, i.e. its calls complete at once with resp.busy, when its own lane
+// holds LaneLimits::maxQueued calls or the whole server holds maxBacklog;
+// low classes get low backlog limits so reporting load is refused long
+// before it can delay a barrier.
+//
+// Each call is one traced request (tracing.h): its root span, "gate.exit"
+// etc., opens in submit() and closes when the call completes, so queue
+// time shows up ahead of the engine's own lot.* spans.
+
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+#include "mpmc_queue.h"
+
+enum class GateOp { Enter, Exit, Pay, Status };
+enum class WaitMode { Block, BusyPoll };
+
+// Priority order: lower value is served first.
+enum class GateClass { Exit, Entry, Payment, Status };
+constexpr int GATE_CLASSES = 4;
+
+inline GateClass gateClassOf(GateOp op) {
+    switch (op) {
+    case GateOp::Exit:   return GateClass::Exit;
+    case GateOp::Enter:  return GateClass::Entry;
+    case GateOp::Pay:    return GateClass::Payment;
+    case GateOp::Status: return GateClass::Status;
+    }
+    return GateClass::Status;
+}
+
+inline const char* gateClassName(GateClass c) {
+    static const char* names[GATE_CLASSES] = {"exit", "entry", "payment", "status"};
+    return names[(int)c];
+}
+
+// Root span names; literals, as TraceEvent requires.
+inline const char* gateSpanName(GateOp op) {
+    switch (op) {
+    case GateOp::Enter:  return "gate.enter";
+    case GateOp::Exit:   return "gate.exit";
+    case GateOp::Pay:    return "gate.pay";
+    case GateOp::Status: return "gate.status";
+    }
+    return "gate.status";
+}
+
+struct GateRequest {
+    GateOp op = GateOp::Status;
+    string gate;
+    Vehicle vehicle{"", VehicleType::Car};
+    TicketId ticket = 0;
+    bool lostTicket = false;
+    PaymentRequest payment;
+
+    static GateRequest enter(string gate, const Vehicle& v) {
+        GateRequest r; r.op = GateOp::Enter; r.gate = std::move(gate); r.vehicle = v; return r;
+    }
+    static GateRequest exit(string gate, TicketId t, bool lost = false) {
+        GateRequest r; r.op = GateOp::Exit; r.gate = std::move(gate); r.ticket = t; r.lostTicket = lost; return r;
+    }
+    static GateRequest pay(const PaymentRequest& p) {
+        GateRequest r; r.op = GateOp::Pay; r.payment = p; return r;
+    }
+    static GateRequest status() { return GateRequest{}; }
+};
+
+struct GateResponse {
+    bool ok = false;
+    bool busy = false;   // shed by admission control; nothing was executed
+    string error;        // when !ok
+    TicketId ticket = 0; // Enter
+    Bill bill;           // Exit
+    Receipt receipt;     // Pay
+    int freeSlots = 0, usedSlots = 0, totalSlots = 0; // Status
+};
+
+inline void cpuRelax() {
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__)
+    asm volatile("yield");
+#endif
+}
+
+// One request and its completion; reusable after wait() returns.
+class GateCall {
+public:
+    GateRequest req;
+    GateResponse resp;
+
+    void wait() {
+        if (!blocking_) {
+            // yield past a few microseconds so an oversubscribed worker can run
+            for (uint32_t n = 0; !done_.load(std::memory_order_acquire); ++n)
+                n < CLIENT_SPINS ? cpuRelax() : std::this_thread::yield();
+            return;
+        }
+        std::unique_lock<std::mutex> lk(m_);
+        cv_.wait(lk, [this] { return done_.load(std::memory_order_acquire); });
+    }
+    bool done() const { return done_.load(std::memory_order_acquire); }
+
+private:
+    friend class GateServer;
+    static constexpr uint32_t CLIENT_SPINS = 4096;
+
+    void arm(bool blocking) {
+        blocking_ = blocking;
+        done_.store(false, std::memory_order_relaxed);
+    }
+    // Closes the root span first: the client may reuse the call at once.
+    void complete() {
+        trace_.finish();
+        if (!blocking_) { done_.store(true, std::memory_order_release); return; }
+        std::lock_guard<std::mutex> lk(m_);
+        done_.store(true, std::memory_order_release);
+        cv_.notify_one();
+    }
+
+    std::atomic<bool> done_{true};
+    bool blocking_ = true;
+    TraceHandoff trace_; // root span, submit() to complete()
+    std::mutex m_;
+    std::condition_variable cv_;
+};
+
+struct LaneLimits {
+    size_t maxQueued;  // calls waiting in this class's queue
+    size_t maxBacklog; // calls waiting in the whole server
+};
+
+struct GateServerConfig {
+    int workers = 2;              // each tracing worker also holds a Tracer ring (tracing.h)
+    WaitMode mode = WaitMode::Block;
+    vector<int> cpus;             // worker i pins to cpus[i % size]; empty = unpinned
+    LaneLimits lanes[GATE_CLASSES] = {
+        {1024, 4096}, // exit
+        {1024, 2048}, // entry
+        {256, 512},   // payment
+        {64, 128},    // status
+    };
+    // BusyPoll back-off after the last request
+    uint32_t idleSpins = 20000;   // pause-spins before yielding
+    uint32_t idleYields = 200;    // yields before sleeping
+    std::chrono::microseconds maxIdleSleep{200};
+};
+
+struct GateLaneStats {
+    uint64_t accepted = 0, shed = 0;
+    size_t queued = 0;
+};
+
+class GateServer {
+public:
+    GateServer(ParkingLot& lot, GateServerConfig cfg = {}) : lot_(lot), cfg_(std::move(cfg)) {
+        if (cfg_.workers <= 0) throw runtime_error("GateServer needs at least one worker");
+        for (int c = 0; c < GATE_CLASSES; ++c) {
+            if (cfg_.lanes[c].maxQueued == 0) throw runtime_error("GateServer lane limit must be positive");
+            size_t cap = 2;
+            while (cap < cfg_.lanes[c].maxQueued) cap <<= 1;
+            lanes_[c].queue = std::make_unique<MpmcQueue<GateCall*>>(cap);
+        }
+        for (int i = 0; i < cfg_.workers; ++i) workers_.emplace_back([this, i] { workerLoop(i); });
+    }
+    GateServer(const GateServer&) = delete;
+    GateServer& operator=(const GateServer&) = delete;
+    ~GateServer() { stop(); }
+
+    // Queues `call` in its class's lane and returns true. Returns false if
+    // the class is being shed or the server is stopped; the call is then
+    // already complete with resp.busy set. The call must stay alive until
+    // wait() returns.
+    bool submit(GateCall& call) {
+        call.arm(cfg_.mode == WaitMode::Block);
+        call.trace_.begin(gateSpanName(call.req.op),
+                          call.req.op == GateOp::Pay ? call.req.payment.bill : call.req.ticket);
+        int c = (int)gateClassOf(call.req.op);
+        Lane& lane = lanes_[c];
+        const LaneLimits& lim = cfg_.lanes[c];
+        // stop() waits for submitters counted here before letting workers exit
+        submitting_.fetch_add(1, std::memory_order_seq_cst);
+        if (!running_.load(std::memory_order_seq_cst)) {
+            submitting_.fetch_sub(1, std::memory_order_release);
+            refuse(call, "busy: gate server stopped");
+            return false;
+        }
+        if (lane.queue->sizeApprox() >= lim.maxQueued || backlog() >= lim.maxBacklog ||
+            !lane.queue->tryPush(&call)) {
+            submitting_.fetch_sub(1, std::memory_order_release);
+            lane.shed.fetch_add(1, std::memory_order_relaxed);
+            refuse(call, string("busy: ") + gateClassName((GateClass)c) + " requests shed");
+            return false;
+        }
+        lane.accepted.fetch_add(1, std::memory_order_relaxed);
+        // Pairs with the fence in sleepUntilWork(): either we see the
+        // sleeper or it sees our call in the queue.
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (cfg_.mode == WaitMode::Block && sleepers_.load(std::memory_order_relaxed) > 0) {
+            std::lock_guard<std::mutex> lk(idleMu_);
+            idleCv_.notify_one();
+        }
+        submitting_.fetch_sub(1, std::memory_order_release); // last touch of *this
+        return true;
+    }
+
+    // Refuses new calls, finishes queued ones, then joins the workers.
+    void stop() {
+        if (!running_.exchange(false, std::memory_order_seq_cst)) return;
+        // a submit that saw running_ may still be pushing its call
+        while (submitting_.load(std::memory_order_seq_cst)) std::this_thread::yield();
+        {
+            std::lock_guard<std::mutex> lk(idleMu_);
+            stopped_.store(true, std::memory_order_release);
+            idleCv_.notify_all();
+        }
+        for (auto& t : workers_) t.join();
+    }
+
+    WaitMode mode() const { return cfg_.mode; }
+
+    GateLaneStats laneStats(GateClass c) const {
+        const Lane& lane = lanes_[(int)c];
+        GateLaneStats s;
+        s.accepted = lane.accepted.load(std::memory_order_relaxed);
+        s.shed = lane.shed.load(std::memory_order_relaxed);
+        s.queued = lane.queue->sizeApprox();
+        return s;
+    }
+
+private:
+    struct Lane {
+        std::unique_ptr<MpmcQueue<GateCall*>> queue;
+        std::atomic<uint64_t> accepted{0}, shed{0};
+    };
+
+    void refuse(GateCall& call, string why) {
+        call.resp = GateResponse{};
+        call.resp.busy = true;
+        call.resp.error = std::move(why);
+        call.complete();
+    }
+
+    size_t backlog() const {
+        size_t n = 0;
+        for (const Lane& l : lanes_) n += l.queue->sizeApprox();
+        return n;
+    }
+
+    // Highest-priority waiting call, if any.
+    bool popNext(GateCall*& call) {
+        for (Lane& l : lanes_)
+            if (l.queue->tryPop(call)) return true;
+        return false;
+    }
+
+    void workerLoop(int idx) {
+        if (!cfg_.cpus.empty()) pinThisThread({cfg_.cpus[idx % cfg_.cpus.size()]});
+        uint32_t idle = 0;
+        for (;;) {
+            // read before popping: once stopped_ is set no call is pushed
+            bool stopping = stopped_.load(std::memory_order_acquire);
+            GateCall* call = nullptr;
+            if (popNext(call)) {
+                execute(*call);
+                idle = 0;
+                continue;
+            }
+            if (stopping) return; // queues drained
+            if (cfg_.mode == WaitMode::BusyPoll) backOff(idle++);
+            else sleepUntilWork();
+        }
+    }
+
+    void backOff(uint32_t idle) {
+        if (idle < cfg_.idleSpins) { cpuRelax(); return; }
+        if (idle < cfg_.idleSpins + cfg_.idleYields) { std::this_thread::yield(); return; }
+        uint32_t step = std::min<uint32_t>(idle - cfg_.idleSpins - cfg_.idleYields, 16);
+        auto sleep = std::chrono::microseconds(1u << step);
+        std::this_thread::sleep_for(std::min(sleep, cfg_.maxIdleSleep));
+    }
+
+    void sleepUntilWork() {
+        std::unique_lock<std::mutex> lk(idleMu_);
+        sleepers_.fetch_add(1, std::memory_order_relaxed);
+        // Pairs with the fence in submit(): re-check after announcing
+        // ourselves, so a concurrent submit either is seen here or sees us
+        // and notifies once we wait (it needs idleMu_, held until then).
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (backlog() == 0 && !stopped_.load(std::memory_order_acquire)) idleCv_.wait(lk);
+        sleepers_.fetch_sub(1, std::memory_order_relaxed);
+    }
+
+    void execute(GateCall& call) {
+        const GateRequest& r = call.req;
+        GateResponse& out = call.resp;
+        out = GateResponse{};
+        TraceHandoff::Scope scope(call.trace_);
+        try {
+            switch (r.op) {
+            case GateOp::Enter: {
+                Vehicle v = r.vehicle;
+                out.ticket = lot_.enterVehicle(r.gate, v);
+                call.trace_.setArg(out.ticket);
+                break;
+            }
+            case GateOp::Exit:   out.bill = lot_.exitVehicle(r.ticket, r.gate, r.lostTicket); break;
+            case GateOp::Pay:    out.receipt = lot_.payBill(r.payment); break;
+            case GateOp::Status: lot_.occupancy(out.freeSlots, out.usedSlots, out.totalSlots); break;
+            }
+            out.ok = true;
+        } catch (const std::exception& e) {
+            out.error = e.what();
+        }
+        call.complete();
+    }
+
+    ParkingLot& lot_;
+    GateServerConfig cfg_;
+    Lane lanes_[GATE_CLASSES];
+    std::atomic<bool> running_{true};  // accepting calls
+    std::atomic<bool> stopped_{false}; // no more calls can arrive; workers exit once drained
+    std::atomic<int> submitting_{0};
+    std::atomic<int> sleepers_{0};
+    std::mutex idleMu_;
+    std::condition_variable idleCv_;
+    vector<std::thread> workers_;
+};
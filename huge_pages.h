@@ -0,0 +1,173 @@
+#pragma once
+// ===================== Huge-page storage =====================
+// Backing store for the lot's big tables (slot arrays, slot index, active
+// ticket table) so million-slot scans and lookups touch a few 2MB pages
+// instead of thousands of 4KB ones.
+//
+//   PARKINGLOT_HUGEPAGES=off|thp|explicit   (or setHugePageMode() before the first allocation)
+//
+// off       plain operator new (default)
+// thp       2MB-aligned anonymous mappings with madvise(MADV_HUGEPAGE)
+// explicit  MAP_HUGETLB from the hugetlbfs pool; falls back to thp when the
+//           pool is empty or missing
+//
+// Requests of 1MB and up get their own 2MB-rounded mapping. Requests up to
+// 1KB (hash nodes) come from 2MB chunks split into 16-byte size classes;
+// freed blocks return to per-class free lists and the chunks are kept.
+// Anything in between uses operator new: too small to span many pages, too
+// big to pool. The path is a pure function of the size, so deallocate()
+// needs no header. The mode is latched on first use.
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#ifdef __linux__
+#include <sys/mman.h>
+#endif
+
+enum class HugePageMode { Off, Transparent, Explicit };
+
+struct HugePageStats {
+    std::size_t explicitBytes = 0; // mapped from the hugetlbfs pool
+    std::size_t thpBytes = 0;      // mapped with MADV_HUGEPAGE (kernel may still split)
+    std::size_t fallbacks = 0;     // explicit requests served by thp instead
+};
+
+class HugePageArena {
+public:
+    static constexpr std::size_t HUGE_PAGE = 2u << 20;
+    static constexpr std::size_t SMALL_MAX = 1024;
+    static constexpr std::size_t LARGE_MIN = 1u << 20;
+    static constexpr std::size_t CLASS_BYTES = 16;
+
+    static HugePageArena& instance() { static HugePageArena a; return a; }
+
+    // Must run before the first allocation through the arena.
+    void setMode(HugePageMode m) {
+        std::lock_guard<std::mutex> lk(mu_);
+        if (used_.load(std::memory_order_relaxed) && m != mode())
+            throw std::runtime_error("Huge-page mode must be set before the first allocation");
+        mode_.store(m, std::memory_order_relaxed);
+    }
+    HugePageMode mode() const { return mode_.load(std::memory_order_relaxed); }
+
+    HugePageStats stats() const {
+        HugePageStats s;
+        s.explicitBytes = explicitBytes_.load(std::memory_order_relaxed);
+        s.thpBytes = thpBytes_.load(std::memory_order_relaxed);
+        s.fallbacks = fallbacks_.load(std::memory_order_relaxed);
+        return s;
+    }
+
+    void* allocate(std::size_t n) {
+        // Load first: a store on every call keeps the shared line bouncing.
+        if (!used_.load(std::memory_order_relaxed)) used_.store(true, std::memory_order_relaxed);
+        if (mode() == HugePageMode::Off || (n > SMALL_MAX && n < LARGE_MIN)) return ::operator new(n);
+        if (n >= LARGE_MIN) return mapRegion(roundUp(n));
+
+        std::size_t cls = (n + CLASS_BYTES - 1) / CLASS_BYTES;
+        std::lock_guard<std::mutex> lk(mu_);
+        if (void* p = free_[cls]) {
+            free_[cls] = *static_cast<void**>(p);
+            return p;
+        }
+        std::size_t bytes = cls * CLASS_BYTES;
+        if (bumpLeft_ < bytes) {
+            bump_ = static_cast<char*>(mapRegion(HUGE_PAGE)); // tail of the old chunk is abandoned
+            bumpLeft_ = HUGE_PAGE;
+        }
+        void* p = bump_;
+        bump_ += bytes;
+        bumpLeft_ -= bytes;
+        return p;
+    }
+
+    void deallocate(void* p, std::size_t n) noexcept {
+        if (!p) return;
+        if (mode() == HugePageMode::Off || (n > SMALL_MAX && n < LARGE_MIN)) { ::operator delete(p); return; }
+        if (n >= LARGE_MIN) {
+#ifdef __linux__
+            munmap(p, roundUp(n));
+#endif
+            return;
+        }
+        std::size_t cls = (n + CLASS_BYTES - 1) / CLASS_BYTES;
+        std::lock_guard<std::mutex> lk(mu_);
+        *static_cast<void**>(p) = free_[cls];
+        free_[cls] = p;
+    }
+
+private:
+    HugePageArena() {
+        if (const char* env = std::getenv("PARKINGLOT_HUGEPAGES")) {
+            std::string v = env;
+            if (v == "thp") mode_.store(HugePageMode::Transparent);
+            else if (v == "explicit") mode_.store(HugePageMode::Explicit);
+        }
+    }
+
+    static std::size_t roundUp(std::size_t n) { return (n + HUGE_PAGE - 1) / HUGE_PAGE * HUGE_PAGE; }
+
+    // `bytes` is a multiple of HUGE_PAGE; the result is HUGE_PAGE aligned.
+    void* mapRegion(std::size_t bytes) {
+#ifdef __linux__
+        if (mode() == HugePageMode::Explicit) {
+            void* p = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+            if (p != MAP_FAILED) {
+                explicitBytes_.fetch_add(bytes, std::memory_order_relaxed);
+                return p;
+            }
+            fallbacks_.fetch_add(1, std::memory_order_relaxed);
+        }
+        // over-map by one huge page, then trim to an aligned window
+        void* raw = mmap(nullptr, bytes + HUGE_PAGE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (raw == MAP_FAILED) throw std::bad_alloc();
+        std::uintptr_t start = reinterpret_cast<std::uintptr_t>(raw);
+        std::uintptr_t aligned = (start + HUGE_PAGE - 1) & ~(std::uintptr_t)(HUGE_PAGE - 1);
+        if (aligned > start) munmap(raw, aligned - start);
+        std::size_t tail = (start + bytes + HUGE_PAGE) - (aligned + bytes);
+        if (tail) munmap(reinterpret_cast<void*>(aligned + bytes), tail);
+        madvise(reinterpret_cast<void*>(aligned), bytes, MADV_HUGEPAGE);
+        thpBytes_.fetch_add(bytes, std::memory_order_relaxed);
+        return reinterpret_cast<void*>(aligned);
+#else
+        return ::operator new(bytes);
+#endif
+    }
+
+    std::atomic<HugePageMode> mode_{HugePageMode::Off};
+    std::atomic<bool> used_{false};
+    std::mutex mu_; // small-object pool
+    void* free_[SMALL_MAX / CLASS_BYTES + 1] = {};
+    char* bump_ = nullptr;
+    std::size_t bumpLeft_ = 0;
+    std::atomic<std::size_t> explicitBytes_{0}, thpBytes_{0}, fallbacks_{0};
+};
+
+inline void setHugePageMode(HugePageMode m) { HugePageArena::instance().setMode(m); }
+
+// Stateless allocator over HugePageArena for the lot's containers.
+template <class T>
+struct HugePageAllocator {
+    using value_type = T;
+    static_assert(alignof(T) <= HugePageArena::CLASS_BYTES, "over-aligned types not supported");
+
+    HugePageAllocator() = default;
+    template <class U> HugePageAllocator(const HugePageAllocator<U>&) noexcept {}
+
+    T* allocate(std::size_t n) {
+        return static_cast<T*>(HugePageArena::instance().allocate(n * sizeof(T)));
+    }
+    void deallocate(T* p, std::size_t n) noexcept { HugePageArena::instance().deallocate(p, n * sizeof(T)); }
+
+    template <class U> bool operator==(const HugePageAllocator<U>&) const noexcept { return true; }
+    template <class U> bool operator!=(const HugePageAllocator<U>&) const noexcept { return false; }
+};
@@ -0,0 +1,18 @@
+#pragma once
+// ===================== Clock =====================
+// Pluggable time source for the engine. Production uses SystemClock; the
+// simulator (sim.h) and tests inject their own.
+
+#include <chrono>
+
+struct IClock {
+    virtual ~IClock() = default;
+    virtual std::chrono::system_clock::time_point now() const = 0;
+};
+
+struct SystemClock final : IClock {
+    std::chrono::system_clock::time_point now() const override {
+        return std::chrono::system_clock::now();
+    }
+    static const SystemClock& instance() { static SystemClock c; return c; }
+};
@@ -0,0 +1,550 @@
+// ===================== Differential checker =====================
+// Runs long random enter/exit/pay/adjust/sweep/evacuate/configure sequences against the
+// engine (ParkingLot) and the reference model (reference_lot.h) and
+// compares every result plus occupancy (per slot type). A quarter of the configures
+// carry a layout that must be rejected without touching the lot. The threaded mode runs small
+// concurrent histories on one ParkingLot and checks they are linearizable
+// with respect to the reference model.
+//
+//   g++ -std=c++17 -O2 -pthread lotcheck.cc -o lotcheck
+//   ./lotcheck [--seed S] [--iterations N] [--ops N] [--threads T] [--mode seq|mt|reclaim|all]
+//             [--sim] [--payment mutex|combining|striped] [--log FILE]
+//
+// --sim runs the threaded histories under the deterministic scheduler
+// (sim.h): threads, engine locks and the clock are driven by the seed, so a
+// failing interleaving replays exactly. Every failure prints the seed that
+// reproduces it. --payment runs the engine's bill table in that
+// PaymentConcurrency mode. --log starts the async logger at Info into
+// FILE, so the engine's log statements run too (e.g. /dev/null under ASan).
+//
+// --mode reclaim checks epoch reclamation (epoch.h): one writer keeps
+// swapping fee schedules and reconfiguring the lot (which retires the bill
+// status chunks) while T readers quote fees and read bill status. Quotes
+// must come from a whole schedule, and retired-but-unfreed garbage must
+// stay bounded throughout and drain to zero afterwards.
+//
+// Half the sequential runs install an expression tariff (tariff_vm.h) that
+// must bill exactly like the reference's fee schedule. Sequential runs also
+// buy day passes and exit/re-enter on them, and half put plates on fleet
+// accounts; the account invoices are compared at the end.
+
+#define PARKINGLOT_NO_MAIN
+#include "Parkinglot.cc"
+#include "reference_lot.h"
+
+#include <random>
+#include <sstream>
+#include <thread>
+
+// ---- Operations ----
+enum class OpKind { Enter, Exit, Pay, Adjust, Occupancy, Configure, Evacuate, Sweep, EnterPass, Reenter };
+
+struct Op {
+    OpKind kind = OpKind::Occupancy;
+    VehicleType vtype = VehicleType::Car;
+    TicketId tid = 0;
+    BillId bill = 0;
+    bool lost = false;
+    PaymentMethod method = PaymentMethod::Cash;
+    string card, upi;
+    long long minutes = 0;
+    vector<Floor> layout;
+    EvacuationBilling billing = EvacuationBilling::Waive;
+    vector<TicketId> evacTids; // empty: evacuate all
+};
+
+static vector<Floor> randomLayout(mt19937_64& rng) {
+    vector<Floor> fs(1 + rng() % 4);
+    for (size_t f = 0; f < fs.size(); ++f) {
+        fs[f].floorNo = (int)f + 1;
+        int n = 1 + (int)(rng() % 6);
+        for (int i = 0; i < n; ++i)
+            fs[f].slots.push_back(ParkingSlot{"F" + to_string(f + 1) + "-S" + to_string(i + 1),
+                                              (SlotType)(rng() % TypeRegistry::instance().slotTypes()), true});
+    }
+    return fs;
+}
+
+// A layout configure() must reject: a duplicate slot id or an unregistered
+// slot type. The lot must then carry on with the layout it had.
+static void breakLayout(vector<Floor>& fs, mt19937_64& rng) {
+    Floor& last = fs.back();
+    if (rng() % 2) last.slots.push_back(ParkingSlot{fs.front().slots.front().id, SlotType::FourWheeler, true});
+    else last.slots.push_back(ParkingSlot{"BAD", (SlotType)TypeRegistry::instance().slotTypes(), true});
+}
+
+// Ticket/bill ids are drawn slightly past what was issued so unknown ids
+// are exercised too.
+static Op randomOp(mt19937_64& rng, TicketId ticketsIssued, BillId billsIssued) {
+    Op op;
+    unsigned r = (unsigned)(rng() % 100);
+    if      (r < 30) op.kind = OpKind::Enter;
+    else if (r < 35) op.kind = OpKind::EnterPass;
+    else if (r < 60) op.kind = OpKind::Exit;
+    else if (r < 80) op.kind = OpKind::Pay;
+    else if (r < 85) op.kind = OpKind::Adjust;
+    else if (r < 88) op.kind = OpKind::Reenter;
+    else if (r < 94) op.kind = OpKind::Occupancy;
+    else if (r < 96) op.kind = OpKind::Sweep;
+    else if (r < 98) op.kind = OpKind::Evacuate;
+    else             op.kind = OpKind::Configure;
+
+    op.vtype = (VehicleType)(rng() % TypeRegistry::instance().vehicleTypes());
+    op.tid = 1 + rng() % (ticketsIssued + 2);
+    op.bill = 1 + rng() % (billsIssued + 2);
+    op.lost = rng() % 10 == 0;
+    op.method = (PaymentMethod)(rng() % 3);
+    op.card = rng() % 4 ? "4242424242" : "42";
+    op.upi = rng() % 4 ? "user@bank" : "userbank";
+    // now and then a whole day, so day passes expire
+    op.minutes = (long long)(rng() % 16 ? rng() % 600 : DAY_PASS_MINUTES + rng() % 600);
+    if (op.kind == OpKind::Configure) {
+        op.layout = randomLayout(rng);
+        if (rng() % 4 == 0) breakLayout(op.layout, rng);
+    }
+    if (op.kind == OpKind::Evacuate) {
+        op.billing = rng() % 2 ? EvacuationBilling::Defer : EvacuationBilling::Waive;
+        if (rng() % 2)
+            for (int i = 1 + (int)(rng() % 4); i > 0; --i)
+                op.evacTids.push_back(1 + rng() % (ticketsIssued + 2));
+    }
+    return op;
+}
+
+// Canonical text of an op's outcome; equal strings == equal behaviour.
+template <class Lot>
+static string applyOp(Lot& lot, const Op& op) {
+    ostringstream os;
+    try {
+        switch (op.kind) {
+        case OpKind::Enter: {
+            Vehicle v("REG" + to_string((int)op.vtype), op.vtype);
+            TicketId tid = lot.enterVehicle("E1", v);
+            os << "ticket " << tid;
+            break;
+        }
+        case OpKind::EnterPass: {
+            Vehicle v("PASS" + to_string((int)op.vtype), op.vtype);
+            TicketId tid = lot.enterWithDayPass("E1", v);
+            os << "pass " << tid;
+            break;
+        }
+        case OpKind::Reenter:
+            lot.reenterVehicle(op.tid, "E2");
+            os << "reentered " << op.tid;
+            break;
+        case OpKind::Exit: {
+            Bill b = lot.exitVehicle(op.tid, "X1", op.lost);
+            os << "bill " << b.id << " ticket " << b.ticket << " slot " << b.slotId
+               << " mins " << b.parkedMinutes << " hours " << b.billedHours
+               << " amount " << b.amount << " status " << (int)b.status;
+            break;
+        }
+        case OpKind::Pay: {
+            Receipt rc = lot.payBill(PaymentRequest{op.bill, 0, op.method, op.card, op.upi});
+            os << "receipt " << rc.bill << " ticket " << rc.ticket << " amount " << rc.amount
+               << " method " << rc.method;
+            break;
+        }
+        case OpKind::Adjust:
+            lot.adjustInTimeForTest(op.tid, op.minutes);
+            os << "adjusted";
+            break;
+        case OpKind::Occupancy: {
+            int f, u, t;
+            lot.occupancy(f, u, t);
+            os << "occupancy " << f << "/" << u << "/" << t;
+            break;
+        }
+        case OpKind::Configure:
+            lot.configure(op.layout);
+            os << "configured";
+            break;
+        case OpKind::Evacuate: {
+            EvacuationSummary sum = op.evacTids.empty() ? lot.evacuateAll("X1", op.billing)
+                                                        : lot.evacuate(op.evacTids, "X1", op.billing);
+            os << "evacuated " << sum.closed << " first " << sum.firstBill
+               << " amount " << sum.deferredAmount;
+            break;
+        }
+        case OpKind::Sweep: {
+            SweepResult res = lot.sweepAbandoned();
+            os << "swept " << res.closed << " flagged " << res.flagged << " amount " << res.amount;
+            break;
+        }
+        }
+    } catch (const std::exception& e) {
+        os << "error: " << e.what();
+    }
+    return os.str();
+}
+
+static string describe(const Op& op) {
+    static const char* names[] = {"enter", "exit", "pay", "adjust", "occupancy", "configure", "evacuate", "sweep",
+                                  "enter_pass", "reenter"};
+    ostringstream os;
+    os << names[(int)op.kind] << " vtype=" << (int)op.vtype << " tid=" << op.tid
+       << " bill=" << op.bill << " lost=" << op.lost << " method=" << (int)op.method;
+    return os.str();
+}
+
+// Bill-table mode for every engine lot (--payment).
+static PaymentConcurrency g_payment = PaymentConcurrency::Mutex;
+
+// One runtime-registered class on top of the built-ins (see main), so
+// layouts, entries and fees cover registry ids too.
+static const char kExtraSlotType[] = "EVCharging";
+static const unsigned long long kExtraSlotRate = 30;
+
+// Tariff rules (tariff_vm.h) that bill exactly like the default
+// FeeSchedule, written so that folding, short-circuits, min/max and the
+// class names all get exercised; every vehicle here is "regular".
+static const char* const kDefaultEquivalentTariffs[] = {
+    "minutes <= 10 ? 0 : hours * (slot == Heavy ? 50 : slot == EVCharging ? 30 : slot == FourWheeler ? 20 : 10)",
+    "class == staff && 1 ? 0 : (minutes > 2 * 5) * hours * (slot == TwoWheeler ? 100 / 10 :"
+    " slot == EVCharging ? 3 * 10 : 4 * (3 + 2) * (slot - 0) + (slot == Heavy) * 10)",
+    "!(minutes > 10 || 0) ? 0 : max(min(hours, hours), 1) * (slot == 2 ? 50 : slot == 1 ? 20 : slot == 3 ? 30 : 10)"
+    " + out_hour * 0",
+    "slot != Heavy && !(minutes >= 11) ? 0 : minutes <= 10 ? 0 : hours * (10 + 10 * (slot >= FourWheeler) +"
+    " 30 * (slot == Heavy) + 10 * (slot == EVCharging)) + (class == staff) * 1000",
+};
+
+// ---- Sequential differential run ----
+static bool runSequential(uint64_t seed, int ops) {
+    mt19937_64 rng(seed);
+    ParkingLot lot;
+    lot.setPaymentConcurrency(g_payment);
+    ReferenceLot ref;
+    vector<Floor> layout = randomLayout(rng);
+    lot.configure(layout);
+    ref.configure(layout);
+    // short max age and tiny slices so sweeps find tickets and resume mid-wheel
+    SweepPolicy sweep;
+    sweep.maxAge = std::chrono::minutes(240);
+    sweep.action = rng() % 2 ? AbandonAction::Close : AbandonAction::Flag;
+    sweep.sliceBudget = 1 + rng() % 4;
+    lot.setSweepPolicy(sweep);
+    ref.sweep = sweep;
+    // half the seeds price through the tariff VM instead of the schedule
+    if (rng() % 2) {
+        size_t n = sizeof(kDefaultEquivalentTariffs) / sizeof(kDefaultEquivalentTariffs[0]);
+        lot.setTariff(kDefaultEquivalentTariffs[rng() % n], {"regular", "staff"}, (int)(rng() % 720));
+    }
+    // half the seeds put some plates on fleet accounts
+    if (rng() % 2) {
+        FleetAccountId acme = lot.addFleetAccount("ACME"), haul = lot.addFleetAccount("Haulers");
+        ref.addFleetAccount("ACME");
+        ref.addFleetAccount("Haulers");
+        const pair<const char*, FleetAccountId> plates[] = {{"REG0", acme}, {"REG2", haul}, {"PASS2", haul}};
+        for (auto [plate, account] : plates) {
+            lot.assignFleetPlate(plate, account);
+            ref.assignFleetPlate(plate, account);
+        }
+    }
+
+    TicketId tickets = 0;
+    BillId bills = 0;
+    for (int i = 0; i < ops; ++i) {
+        Op op = randomOp(rng, tickets, bills);
+        string got = applyOp(lot, op);
+        string want = applyOp(ref, op);
+        if (got != want) {
+            cerr << "[lotcheck] MISMATCH seed=" << seed << " op#" << i << " " << describe(op)
+                 << "\n  engine:    " << got << "\n  reference: " << want << "\n";
+            return false;
+        }
+        if (op.kind == OpKind::Enter && got.rfind("ticket", 0) == 0) ++tickets;
+        if (op.kind == OpKind::EnterPass && got.rfind("pass", 0) == 0) ++tickets;
+        // pass purchases bill; in-pass exits return the pass bill
+        if (op.kind == OpKind::Exit || op.kind == OpKind::EnterPass || op.kind == OpKind::Evacuate ||
+            op.kind == OpKind::Sweep)
+            bills = ref.bills.size();
+        if (op.kind == OpKind::Configure && got == "configured") tickets = bills = 0;
+
+        // occupancy must agree after every step, not only when sampled
+        string occ = applyOp(lot, Op{}) + " active " + to_string(lot.activeCount());
+        string refOcc = applyOp(ref, Op{}) + " active " + to_string(ref.activeCount());
+        for (int t = 0; t < TypeRegistry::instance().slotTypes(); ++t) {
+            occ += " free" + to_string(t) + " " + to_string(lot.freeSlots((SlotType)t));
+            refOcc += " free" + to_string(t) + " " + to_string(ref.freeSlots((SlotType)t));
+        }
+        if (occ != refOcc) {
+            cerr << "[lotcheck] OCCUPANCY MISMATCH seed=" << seed << " after op#" << i << " "
+                 << describe(op) << "\n  engine:    " << occ << "\n  reference: " << refOcc << "\n";
+            return false;
+        }
+        // lock-free status read of the op's bill must match the reference
+        auto st = lot.billStatus(op.bill), refSt = ref.billStatus(op.bill);
+        if (st != refSt) {
+            cerr << "[lotcheck] BILL STATUS MISMATCH seed=" << seed << " after op#" << i << " "
+                 << describe(op) << "\n  engine:    " << (st ? (int)*st : -1)
+                 << "\n  reference: " << (refSt ? (int)*refSt : -1) << "\n";
+            return false;
+        }
+    }
+
+    // the account ledgers must invoice the same
+    auto invoices = [](const vector<FleetInvoice>& v) {
+        ostringstream os;
+        for (const auto& inv : v)
+            os << " " << inv.name << ":" << inv.charges << "/" << inv.parkedMinutes << "/"
+               << inv.billedHours << "/" << inv.amount;
+        return os.str();
+    };
+    std::chrono::system_clock::time_point from{}, to = from + std::chrono::hours(24 * 365 * 200);
+    string got = invoices(lot.fleetInvoices(from, to, 2)), want = invoices(ref.fleetInvoices(from, to));
+    if (got != want) {
+        cerr << "[lotcheck] INVOICE MISMATCH seed=" << seed << "\n  engine:   " << got
+             << "\n  reference:" << want << "\n";
+        return false;
+    }
+    return true;
+}
+
+// ---- Concurrent history + linearizability check ----
+struct HistoryEntry {
+    int thread = 0;
+    Op op;
+    string result;
+    uint64_t invoke = 0, response = 0; // positions in the global event order
+};
+
+// Wing & Gong style search: pick any op no other pending op precedes in
+// real time, replay it on a copy of the model, recurse while results match.
+static bool linearizable(const ReferenceLot& model, const vector<HistoryEntry>& h,
+                         vector<bool>& done, size_t remaining) {
+    if (remaining == 0) return true;
+    for (size_t i = 0; i < h.size(); ++i) {
+        if (done[i]) continue;
+        bool minimal = true;
+        for (size_t j = 0; j < h.size() && minimal; ++j)
+            if (!done[j] && j != i && h[j].response < h[i].invoke) minimal = false;
+        if (!minimal) continue;
+        ReferenceLot next = model;
+        if (applyOp(next, h[i].op) != h[i].result) continue;
+        done[i] = true;
+        if (linearizable(next, h, done, remaining - 1)) return true;
+        done[i] = false;
+    }
+    return false;
+}
+
+// Runs one concurrent history. Under `sim` the interleaving is a pure
+// function of the seed; otherwise it is whatever the OS produced.
+static vector<HistoryEntry> recordHistory(uint64_t seed, const vector<Floor>& layout,
+                                          const vector<vector<Op>>& plans, bool sim) {
+    ParkingLot lot;
+    lot.setPaymentConcurrency(g_payment);
+    lot.configure(layout);
+    int threads = (int)plans.size();
+
+    std::atomic<uint64_t> clock{0};
+    std::atomic<int> ready{0};
+    vector<vector<HistoryEntry>> perThread(threads);
+    auto worker = [&](int t) {
+        vector<TicketId> mine;
+        vector<BillId> myBills;
+        if (!sim) {
+            ready.fetch_add(1);
+            while (ready.load() < threads) std::this_thread::yield();
+        }
+        for (Op op : plans[t]) {
+            if (SimScheduler* s = SimScheduler::current()) s->yield();
+            // resolve ids from this thread's own earlier results
+            if (op.kind == OpKind::Exit) op.tid = mine.empty() ? 999 : mine.back();
+            if (op.kind == OpKind::Pay) op.bill = myBills.empty() ? 999 : myBills.back();
+            HistoryEntry e;
+            e.thread = t;
+            e.invoke = clock.fetch_add(1);
+            e.result = applyOp(lot, op);
+            e.response = clock.fetch_add(1);
+            e.op = op;
+            if (op.kind == OpKind::Enter && e.result.rfind("ticket ", 0) == 0)
+                mine.push_back(stoull(e.result.substr(7)));
+            if (op.kind == OpKind::Exit && e.result.rfind("bill ", 0) == 0) {
+                mine.pop_back();
+                myBills.push_back(stoull(e.result.substr(5)));
+            }
+            perThread[t].push_back(e);
+        }
+    };
+
+    if (sim) {
+        SimScheduler scheduler(seed);
+        lot.setClock(scheduler.clock());
+        for (int t = 0; t < threads; ++t) scheduler.spawn([&worker, t] { worker(t); });
+        scheduler.run();
+    } else {
+        vector<std::thread> pool;
+        for (int t = 0; t < threads; ++t) pool.emplace_back(worker, t);
+        for (auto& th : pool) th.join();
+    }
+
+    vector<HistoryEntry> history;
+    for (auto& v : perThread) history.insert(history.end(), v.begin(), v.end());
+    return history;
+}
+
+static void printHistory(const vector<HistoryEntry>& history) {
+    for (const auto& e : history)
+        cerr << "  t" << e.thread << " [" << e.invoke << "," << e.response << "] "
+             << describe(e.op) << " -> " << e.result << "\n";
+}
+
+static bool runConcurrent(uint64_t seed, int threads, int opsPerThread, bool sim) {
+    mt19937_64 rng(seed);
+    vector<Floor> layout = randomLayout(rng);
+
+    // each thread enters, exits its own tickets, pays its bills, polls occupancy
+    vector<vector<Op>> plans(threads);
+    for (auto& plan : plans)
+        for (int i = 0; i < opsPerThread; ++i) {
+            Op op;
+            unsigned r = (unsigned)(rng() % 10);
+            op.kind = r < 4 ? OpKind::Enter : r < 7 ? OpKind::Exit : r < 9 ? OpKind::Pay : OpKind::Occupancy;
+            op.vtype = (VehicleType)(rng() % TypeRegistry::instance().vehicleTypes());
+            plan.push_back(op);
+        }
+
+    vector<HistoryEntry> history = recordHistory(seed, layout, plans, sim);
+    string replay = sim ? " (replay: --mode mt --sim --iterations 1 --threads " + to_string(threads) +
+                              " --seed " + to_string(seed) + ")" : "";
+
+    if (sim) {
+        // the same seed must reproduce the same history
+        vector<HistoryEntry> again = recordHistory(seed, layout, plans, sim);
+        for (size_t i = 0; i < history.size(); ++i)
+            if (again[i].result != history[i].result || again[i].invoke != history[i].invoke) {
+                cerr << "[lotcheck] NON-DETERMINISTIC simulation seed=" << seed << "\n";
+                return false;
+            }
+    }
+
+    ReferenceLot model;
+    model.configure(layout);
+    vector<bool> done(history.size(), false);
+    if (linearizable(model, history, done, history.size())) return true;
+
+    cerr << "[lotcheck] NOT LINEARIZABLE seed=" << seed << replay << "\n";
+    printHistory(history);
+    return false;
+}
+
+// ---- Epoch reclamation under continuous updates ----
+static bool runReclaim(uint64_t seed, int readers, int rounds) {
+    mt19937_64 rng(seed);
+    vector<Floor> layout = randomLayout(rng);
+    ParkingLot lot;
+    lot.setPaymentConcurrency(g_payment);
+    lot.configure(layout);
+
+    // every schedule charges one rate from this set for all slot types
+    const unsigned long long rates[] = {10, 20, 30, 50, 70};
+    std::atomic<bool> stop{false};
+    std::atomic<uint64_t> quotes{0};
+    std::atomic<int> bad{0};
+    vector<std::thread> pool;
+    for (int t = 0; t < readers; ++t)
+        pool.emplace_back([&, t] {
+            mt19937_64 r(seed * 31 + (uint64_t)t);
+            while (!stop.load(std::memory_order_relaxed)) {
+                unsigned long long mins = 11 + r() % 600;
+                FeeBreakup fb = lot.quoteFee((SlotType)(r() % TypeRegistry::instance().slotTypes()), mins);
+                unsigned long long rate = fb.billedHours ? fb.amount / fb.billedHours : 0;
+                if (fb.billedHours != ceilHours(mins) || fb.amount != fb.billedHours * rate ||
+                    find(begin(rates), end(rates), rate) == end(rates))
+                    bad.fetch_add(1);
+                if (auto st = lot.billStatus(1 + r() % 64); st && *st != BillStatus::Pending) bad.fetch_add(1);
+                quotes.fetch_add(1, std::memory_order_relaxed);
+            }
+        });
+
+    // one schedule per round, plus a lot reset every 64 rounds
+    // steady state stays under 4 batches; the rest is slack for a reader
+    // descheduled while pinned
+    const size_t bound = 8 * EpochDomain::RETIRE_BATCH;
+    size_t maxPending = 0;
+    for (int i = 0; i < rounds; ++i) {
+        FeeSchedule fs;
+        unsigned long long rate = rates[rng() % size(rates)];
+        for (auto& h : fs.hourly) h = rate;
+        lot.setFeeSchedule(fs);
+        if (i % 64 == 63) {
+            Vehicle v("RC" + to_string(i), VehicleType::Car);
+            try {
+                TicketId tid = lot.enterVehicle("E1", v);
+                lot.exitVehicle(tid, "X1");
+            } catch (const std::exception&) {} // layout may have no car slot
+            lot.configure(layout);
+        }
+        maxPending = std::max(maxPending, EpochDomain::instance().pending());
+        if (i % 16 == 0) std::this_thread::yield(); // let pinned readers finish on small machines
+    }
+    stop.store(true);
+    for (auto& th : pool) th.join();
+
+    EpochDomain& ebr = EpochDomain::instance();
+    for (int i = 0; i < 4 && ebr.pending(); ++i) ebr.collect();
+    cout << "reclaim: rounds=" << rounds << " readers=" << readers << " quotes=" << quotes.load()
+         << " max_pending=" << maxPending << " (bound " << bound << ") left=" << ebr.pending() << "\n";
+    if (bad.load()) {
+        cerr << "[lotcheck] TORN FEE SCHEDULE seed=" << seed << " quotes=" << bad.load() << "\n";
+        return false;
+    }
+    if (maxPending > bound || ebr.pending()) {
+        cerr << "[lotcheck] UNBOUNDED GARBAGE seed=" << seed << " max_pending=" << maxPending
+             << " left=" << ebr.pending() << "\n";
+        return false;
+    }
+    return true;
+}
+
+int main(int argc, char** argv) {
+    uint64_t seed = std::random_device{}();
+    int iterations = 200, ops = 2000, threads = 3;
+    string mode = "all";
+    bool sim = false;
+    std::FILE* logFile = nullptr;
+    for (int i = 1; i < argc; ++i) {
+        string a = argv[i];
+        if (a == "--sim") { sim = true; continue; }
+        if (i + 1 >= argc) { cerr << "missing value for " << a << "\n"; return 2; }
+        const char* v = argv[++i];
+        if      (a == "--seed")       seed = stoull(v);
+        else if (a == "--iterations") iterations = atoi(v);
+        else if (a == "--ops")        ops = atoi(v);
+        else if (a == "--threads")    threads = atoi(v);
+        else if (a == "--mode")       mode = v;
+        else if (a == "--log") {
+            if (!(logFile = std::fopen(v, "w"))) { cerr << "cannot open " << v << "\n"; return 2; }
+        }
+        else if (a == "--payment") {
+            if (string(v) == "combining") g_payment = PaymentConcurrency::FlatCombining;
+            else if (string(v) == "striped") g_payment = PaymentConcurrency::Striped;
+            else if (string(v) != "mutex") { cerr << "--payment must be mutex, combining or striped\n"; return 2; }
+        }
+        else { cerr << "unknown option " << a << "\n"; return 2; }
+    }
+    if (mode != "seq" && mode != "mt" && mode != "reclaim" && mode != "all") {
+        cerr << "--mode must be seq, mt, reclaim or all\n";
+        return 2;
+    }
+    registerVehicleType("EVCar", registerSlotType(kExtraSlotType, kExtraSlotRate));
+    if (logFile) AsyncLogger::instance().start(logFile, LogLevel::Info);
+    if (mode == "reclaim") {
+        cout << "lotcheck seed=" << seed << " mode=reclaim\n";
+        if (!runReclaim(seed, threads, 200 * iterations)) return 1;
+        cout << "lotcheck: OK\n";
+        return 0;
+    }
+
+    cout << "lotcheck seed=" << seed << " iterations=" << iterations << (sim ? " (simulated)" : "") << "\n";
+    for (int it = 0; it < iterations; ++it) {
+        uint64_t s = seed + (uint64_t)it;
+        if (mode != "mt" && !runSequential(s, ops)) return 1;
+        // histories stay small: the search is exponential in overlapping ops
+        if (mode != "seq" && !runConcurrent(s, threads, 4, sim)) return 1;
+    }
+    if (mode == "all" && !sim && !runReclaim(seed, threads, 20000)) return 1;
+    cout << "lotcheck: OK\n";
+}
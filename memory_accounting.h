@@ -0,0 +1,86 @@
+#pragma once
+// ===================== Memory accounting =====================
+// Estimates heap bytes held by engine containers, including allocator
+// overhead. Sizes follow libstdc++ container layouts and glibc malloc
+// chunk rounding (16-byte aligned, 8-byte header, 32-byte minimum); on
+// other toolchains the figures are close estimates, not exact.
+
+#include <algorithm>
+#include <cstddef>
+#include <deque>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+struct MemoryUsage {
+    std::size_t slotArrays = 0;    // floors_ and Floor::slots storage
+    std::size_t slotStrings = 0;   // heap owned by slot ids
+    std::size_t slotIndex = 0;     // slot id -> handle index (keys included)
+    std::size_t activeTable = 0;   // active_ buckets + nodes
+    std::size_t ticketStrings = 0; // heap owned by Ticket text fields
+    std::size_t billTable = 0;     // bills_ buckets + nodes
+    std::size_t billStrings = 0;   // heap owned by Bill text fields
+    std::size_t passTable = 0;     // day passes_ + passExpiry_ queue
+    std::size_t couponTable = 0;   // published coupon table
+    std::size_t fleetLedger = 0;   // fleet charge log, accounts and plates
+
+    std::size_t total() const {
+        return slotArrays + slotStrings + slotIndex + activeTable + ticketStrings + billTable + billStrings +
+               passTable + couponTable + fleetLedger;
+    }
+    MemoryUsage& operator+=(const MemoryUsage& o) {
+        slotArrays += o.slotArrays;   slotStrings += o.slotStrings;
+        slotIndex += o.slotIndex;
+        activeTable += o.activeTable; ticketStrings += o.ticketStrings;
+        billTable += o.billTable;     billStrings += o.billStrings;
+        passTable += o.passTable;     couponTable += o.couponTable;
+        fleetLedger += o.fleetLedger;
+        return *this;
+    }
+};
+
+// Bytes malloc really reserves for an n-byte request.
+inline std::size_t mallocChunkBytes(std::size_t n) {
+    if (n == 0) return 0;
+    std::size_t chunk = (n + sizeof(std::size_t) + 15) & ~std::size_t(15);
+    return chunk < 32 ? 32 : chunk;
+}
+
+// 0 while the string fits the small-string buffer inside the object.
+inline std::size_t stringHeapBytes(const std::string& s) {
+    const char* p = s.data();
+    const char* self = reinterpret_cast<const char*>(&s);
+    if (p >= self && p < self + sizeof(std::string)) return 0;
+    return mallocChunkBytes(s.capacity() + 1);
+}
+
+template <class T, class A>
+inline std::size_t vectorHeapBytes(const std::vector<T, A>& v) {
+    return mallocChunkBytes(v.capacity() * sizeof(T));
+}
+
+// Bucket array plus one node (next pointer + value, + cached hash for
+// "slow" hashers such as std::string's) per element. A single bucket lives
+// inside the map object and costs nothing.
+template <class K, class V, class H, class E, class A>
+inline std::size_t hashMapHeapBytes(const std::unordered_map<K, V, H, E, A>& m) {
+#ifdef __GLIBCXX__
+    constexpr bool cachesHash = !std::__is_fast_hash<H>::value;
+#else
+    constexpr bool cachesHash = false;
+#endif
+    std::size_t node = sizeof(void*) + sizeof(std::pair<const K, V>) + (cachesHash ? sizeof(std::size_t) : 0);
+    std::size_t buckets = m.bucket_count() > 1 ? mallocChunkBytes(m.bucket_count() * sizeof(void*)) : 0;
+    return buckets + m.size() * mallocChunkBytes(node);
+}
+
+// libstdc++ deque: 512-byte node buffers (one element if larger) plus the
+// node map, which starts at 8 pointers and keeps a spare at each end.
+template <class T, class A>
+inline std::size_t dequeHeapBytes(const std::deque<T, A>& d) {
+    constexpr std::size_t perNode = sizeof(T) < 512 ? 512 / sizeof(T) : 1;
+    std::size_t nodes = d.size() / perNode + 1;
+    std::size_t map = std::max<std::size_t>(8, nodes + 2);
+    return mallocChunkBytes(map * sizeof(T*)) + nodes * mallocChunkBytes(perNode * sizeof(T));
+}
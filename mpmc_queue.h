@@ -0,0 +1,82 @@
+#pragma once
+// ===================== Bounded MPMC queue =====================
+// Vyukov's array queue: every cell carries a sequence number, producers and
+// consumers claim positions with one CAS each and never take a lock. Used
+// for gate request queues (gate_server.h).
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <stdexcept>
+
+template <class T>
+class MpmcQueue {
+public:
+    // capacity: power of two
+    explicit MpmcQueue(std::size_t capacity) : mask_(capacity - 1), cells_(new Cell[capacity]) {
+        if (capacity < 2 || (capacity & (capacity - 1)))
+            throw std::runtime_error("MpmcQueue capacity must be a power of two >= 2");
+        for (std::size_t i = 0; i < capacity; ++i) cells_[i].seq.store(i, std::memory_order_relaxed);
+    }
+    MpmcQueue(const MpmcQueue&) = delete;
+    MpmcQueue& operator=(const MpmcQueue&) = delete;
+
+    // false when full
+    bool tryPush(const T& v) {
+        std::size_t pos = tail_.load(std::memory_order_relaxed);
+        for (;;) {
+            Cell& c = cells_[pos & mask_];
+            std::size_t seq = c.seq.load(std::memory_order_acquire);
+            auto diff = (std::ptrdiff_t)seq - (std::ptrdiff_t)pos;
+            if (diff == 0) {
+                if (tail_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    c.data = v;
+                    c.seq.store(pos + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if (diff < 0) {
+                return false;
+            } else {
+                pos = tail_.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    // false when empty
+    bool tryPop(T& out) {
+        std::size_t pos = head_.load(std::memory_order_relaxed);
+        for (;;) {
+            Cell& c = cells_[pos & mask_];
+            std::size_t seq = c.seq.load(std::memory_order_acquire);
+            auto diff = (std::ptrdiff_t)seq - (std::ptrdiff_t)(pos + 1);
+            if (diff == 0) {
+                if (head_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    out = c.data;
+                    c.seq.store(pos + mask_ + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if (diff < 0) {
+                return false;
+            } else {
+                pos = head_.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    // Racy snapshot; for admission decisions and stats only.
+    std::size_t sizeApprox() const {
+        std::size_t t = tail_.load(std::memory_order_relaxed), h = head_.load(std::memory_order_relaxed);
+        return t > h ? t - h : 0;
+    }
+    std::size_t capacity() const { return mask_ + 1; }
+
+private:
+    struct Cell {
+        std::atomic<std::size_t> seq;
+        T data;
+    };
+    const std::size_t mask_;
+    std::unique_ptr<Cell[]> cells_;
+    alignas(64) std::atomic<std::size_t> tail_{0}; // producers
+    alignas(64) std::atomic<std::size_t> head_{0}; // consumers
+};
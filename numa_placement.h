@@ -0,0 +1,156 @@
+#pragma once
+// ===================== NUMA placement & CPU pinning =====================
+// The lot's tables (slot arrays, slot index, ticket and bill tables) are
+// ordinary heap memory, and Linux puts each page on the node of the thread
+// that first touches it. runOnNumaNode() runs a setup step (configure,
+// warmUp, restore) on a thread bound to one node's CPUs with that node as
+// its preferred memory node, so the tables land next to the gate threads
+// that will serve them. ThreadPlacement pins gate, payment and I/O threads.
+//
+//   ThreadPlacement tp = ...;                     // e.g. from the "placement" config
+//   runOnNumaNode(tp.memoryNode, [&] { lot.configure(loadConfigFromJson(path)); lot.warmUp(); });
+//   tp.pin(ThreadRole::Gate);                     // on each gate thread
+//
+// Uses raw syscalls (no libnuma). Everything degrades to a no-op that
+// returns false/-1 on single-node machines, non-Linux builds or when the
+// kernel refuses.
+
+#include <cstdint>
+#include <exception>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+// "0-3,8,10-11" -> {0,1,2,3,8,10,11}; empty string -> {}.
+inline std::vector<int> parseCpuList(const std::string& s) {
+    std::vector<int> out;
+    std::stringstream ss(s);
+    for (std::string part; std::getline(ss, part, ',');) {
+        if (part.empty() || part == "\n") continue;
+        auto dash = part.find('-');
+        try {
+            int lo = std::stoi(part.substr(0, dash));
+            int hi = dash == std::string::npos ? lo : std::stoi(part.substr(dash + 1));
+            if (lo < 0 || hi < lo) throw std::invalid_argument(part);
+            for (int c = lo; c <= hi; ++c) out.push_back(c);
+        } catch (const std::logic_error&) {
+            throw std::runtime_error("Invalid CPU list: " + s);
+        }
+    }
+    return out;
+}
+
+namespace numa_detail {
+inline std::string readSysfs(const std::string& path) {
+    std::ifstream f(path);
+    std::string s;
+    std::getline(f, s);
+    return s;
+}
+} // namespace numa_detail
+
+// Number of online NUMA nodes (1 when unknown).
+inline int numaNodeCount() {
+    std::vector<int> nodes = parseCpuList(numa_detail::readSysfs("/sys/devices/system/node/online"));
+    return nodes.empty() ? 1 : nodes.back() + 1;
+}
+
+inline std::vector<int> numaCpusOfNode(int node) {
+    std::vector<int> cpus =
+        parseCpuList(numa_detail::readSysfs("/sys/devices/system/node/node" + std::to_string(node) + "/cpulist"));
+    if (cpus.empty() && node == 0) // no sysfs node info: treat the machine as one node
+        for (unsigned c = 0; c < std::thread::hardware_concurrency(); ++c) cpus.push_back((int)c);
+    return cpus;
+}
+
+// Restricts the calling thread to `cpus`; false if empty or refused.
+inline bool pinThisThread(const std::vector<int>& cpus) {
+#ifdef __linux__
+    if (cpus.empty()) return false;
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (int c : cpus)
+        if (c < CPU_SETSIZE) CPU_SET(c, &set);
+    return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#else
+    (void)cpus;
+    return false;
+#endif
+}
+
+// Memory policy of the calling thread (set_mempolicy(2) modes).
+enum class NumaPolicy { Default = 0, Preferred = 1, Bind = 2 };
+
+inline bool numaSetPolicy(NumaPolicy mode, int node = -1) {
+#if defined(__linux__) && defined(SYS_set_mempolicy)
+    unsigned long mask[16] = {}; // up to 1024 nodes
+    if (mode != NumaPolicy::Default) {
+        if (node < 0 || node >= (int)(sizeof(mask) * 8)) return false;
+        mask[node / (8 * sizeof(unsigned long))] |= 1UL << (node % (8 * sizeof(unsigned long)));
+    }
+    return syscall(SYS_set_mempolicy, (int)mode,
+                   mode == NumaPolicy::Default ? nullptr : mask,
+                   mode == NumaPolicy::Default ? 0UL : sizeof(mask) * 8 + 1) == 0;
+#else
+    (void)mode; (void)node;
+    return false;
+#endif
+}
+
+// Node holding the page at `p` (touching it first if unmapped); -1 if unknown.
+inline int numaNodeOfAddress(const void* p) {
+#if defined(__linux__) && defined(SYS_get_mempolicy)
+    int node = -1;
+    constexpr unsigned long MPOL_F_NODE_ = 1, MPOL_F_ADDR_ = 2;
+    if (syscall(SYS_get_mempolicy, &node, nullptr, 0UL, p, MPOL_F_NODE_ | MPOL_F_ADDR_) != 0) return -1;
+    return node;
+#else
+    (void)p;
+    return -1;
+#endif
+}
+
+// Runs fn() on a fresh thread pinned to `node` with a preferred-node memory
+// policy, and waits for it; exceptions propagate. node < 0 runs fn() inline.
+template <class F>
+void runOnNumaNode(int node, F&& fn) {
+    if (node < 0) { fn(); return; }
+    std::exception_ptr err;
+    std::thread t([&] {
+        pinThisThread(numaCpusOfNode(node));
+        numaSetPolicy(NumaPolicy::Preferred, node);
+        try { fn(); } catch (...) { err = std::current_exception(); }
+    });
+    t.join();
+    if (err) std::rethrow_exception(err);
+}
+
+// ---- Thread roles ----
+// Gate: threads calling enter/exit. Payment: threads calling payBill.
+// Io: logger writer, sweeper and other background threads.
+enum class ThreadRole { Gate, Payment, Io };
+
+struct ThreadPlacement {
+    int memoryNode = -1; // node for the lot's tables; -1 = wherever configure runs
+    std::vector<int> gateCpus, paymentCpus, ioCpus;
+
+    // Pins the calling thread per its role, and prefers memoryNode for its
+    // allocations (tickets, bills). No-op for roles without CPUs.
+    bool pin(ThreadRole role) const {
+        const std::vector<int>& cpus =
+            role == ThreadRole::Gate ? gateCpus : role == ThreadRole::Payment ? paymentCpus : ioCpus;
+        if (cpus.empty()) return false;
+        if (memoryNode >= 0) numaSetPolicy(NumaPolicy::Preferred, memoryNode);
+        return pinThisThread(cpus);
+    }
+};
@@ -0,0 +1,198 @@
+#pragma once
+// ===================== Parking core =====================
+// Vehicle/slot types, slot allocation and fee rules shared by the main
+// engine (Parkinglot.cc) and the fixed-size embedded engine
+// (fixed_parking_lot.h). Everything here is heap-free, exception-free and
+// RTTI-free so it also builds with -fno-exceptions -fno-rtti.
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+
+using TicketId = unsigned long long;
+using BillId   = unsigned long long;
+
+// Dense small-integer ids. The named values are the built-in classes;
+// more are registered at runtime (TypeRegistry), e.g. VehicleType{3}.
+enum class VehicleType : std::uint8_t { Bike, Car, Truck };
+enum class SlotType    : std::uint8_t { TwoWheeler, FourWheeler, Heavy };
+
+constexpr int MAX_VEHICLE_TYPES = 32;
+constexpr int MAX_SLOT_TYPES = 16; // per-slot-type tables are this long
+
+// ---- Type registry ----
+// Vehicle and slot classes by id: name, the slot type a vehicle class
+// parks in, and the default hourly rate of a slot class. Every per-type
+// question is a table read. Starts with the built-in classes; config adds
+// more (EV car, minibus, bicycle). Registration is append-only and meant
+// for startup; lookups are lock-free and may run alongside it.
+class TypeRegistry {
+public:
+    static constexpr std::size_t NAME_LEN = 24; // including the NUL
+    static constexpr std::uint8_t NONE = 0xff;
+
+    static TypeRegistry& instance() {
+        static TypeRegistry r;
+        return r;
+    }
+
+    // Id of a new slot class, or of an identical existing one; -1 if the
+    // name is empty, too long or taken with a different rate, or the table
+    // is full.
+    int addSlotType(const char* name, unsigned long long hourlyRate) {
+        int id = findSlotType(name);
+        if (id >= 0) return slots_[id].rate == hourlyRate ? id : -1;
+        int n = slotCount_.load(std::memory_order_relaxed);
+        if (n == MAX_SLOT_TYPES || !setName(slots_[n].name, name)) return -1;
+        slots_[n].rate = hourlyRate;
+        slotCount_.store(n + 1, std::memory_order_release);
+        return n;
+    }
+    // As addSlotType, for a vehicle class parking in `slot`.
+    int addVehicleType(const char* name, SlotType slot) {
+        if (!isSlotType(slot)) return -1;
+        int id = findVehicleType(name);
+        if (id >= 0) return vehicles_[id].slot == slot ? id : -1;
+        int n = vehicleCount_.load(std::memory_order_relaxed);
+        if (n == MAX_VEHICLE_TYPES || !setName(vehicles_[n].name, name)) return -1;
+        vehicles_[n].slot = slot;
+        vehicleCount_.store(n + 1, std::memory_order_release);
+        return n;
+    }
+
+    int slotTypes() const { return slotCount_.load(std::memory_order_acquire); }
+    int vehicleTypes() const { return vehicleCount_.load(std::memory_order_acquire); }
+    bool isSlotType(SlotType s) const { return (int)s < slotTypes(); }
+    bool isVehicleType(VehicleType v) const { return (int)v < vehicleTypes(); }
+
+    // Callers pass registered ids.
+    SlotType slotFor(VehicleType v) const { return vehicles_[(int)v].slot; }
+    unsigned long long hourlyRate(SlotType s) const { return slots_[(int)s].rate; }
+    const char* name(SlotType s) const { return slots_[(int)s].name; }
+    const char* name(VehicleType v) const { return vehicles_[(int)v].name; }
+
+    // Id for `name`, or -1.
+    int findSlotType(const char* name) const {
+        for (int i = 0, n = slotTypes(); i < n; ++i)
+            if (std::strcmp(slots_[i].name, name) == 0) return i;
+        return -1;
+    }
+    int findVehicleType(const char* name) const {
+        for (int i = 0, n = vehicleTypes(); i < n; ++i)
+            if (std::strcmp(vehicles_[i].name, name) == 0) return i;
+        return -1;
+    }
+
+private:
+    struct SlotClass {
+        char name[NAME_LEN] = {};
+        unsigned long long rate = 0; // INR per started hour
+    };
+    struct VehicleClass {
+        char name[NAME_LEN] = {};
+        SlotType slot = SlotType::FourWheeler;
+    };
+
+    TypeRegistry() {
+        addSlotType("TwoWheeler", 10);
+        addSlotType("FourWheeler", 20);
+        addSlotType("Heavy", 50);
+        addVehicleType("Bike", SlotType::TwoWheeler);
+        addVehicleType("Car", SlotType::FourWheeler);
+        addVehicleType("Truck", SlotType::Heavy);
+    }
+
+    static bool setName(char (&dst)[NAME_LEN], const char* src) {
+        std::size_t n = std::strlen(src);
+        if (n == 0 || n >= NAME_LEN) return false;
+        std::memcpy(dst, src, n + 1);
+        return true;
+    }
+
+    SlotClass slots_[MAX_SLOT_TYPES];
+    VehicleClass vehicles_[MAX_VEHICLE_TYPES];
+    std::atomic<int> slotCount_{0}, vehicleCount_{0};
+};
+
+inline SlotType slotFor(VehicleType t) { return TypeRegistry::instance().slotFor(t); }
+
+// ---- Allocation ----
+// First free slot of type t in slots[0, n), or -1. Slot needs `type` and
+// `isFree`. Both engines scan floors in order and take the first fit.
+template <class Slot>
+inline int firstFreeSlot(const Slot* slots, int n, SlotType t) {
+    for (int i = 0; i < n; ++i)
+        if (slots[i].type == t && slots[i].isFree) return i;
+    return -1;
+}
+
+// ---- Fees ----
+struct FeeBreakup {
+    unsigned long long amount = 0;   // INR
+    unsigned long long billedHours = 0;
+    unsigned long long parkedMinutes = 0;
+    unsigned long long discount = 0; // INR already taken off amount (coupon)
+};
+
+constexpr unsigned long long GRACE_MINUTES = 10;        // Stage 5 add-on
+constexpr unsigned long long LOST_TICKET_PENALTY = 200; // flat, on top of the fee
+constexpr unsigned long long DAY_PASS_HOURS = 8;         // day pass price, in hours at the slot rate
+constexpr unsigned long long DAY_PASS_MINUTES = 24 * 60; // day pass validity from purchase
+
+inline unsigned long long hourlyRate(SlotType s) { return TypeRegistry::instance().hourlyRate(s); }
+
+constexpr unsigned long long ceilHours(unsigned long long minutes) {
+    return minutes == 0 ? 0 : (minutes + 59) / 60;
+}
+
+// Tariff the lot bills with. An hourly entry left at REGISTERED_RATE
+// takes the slot type's rate from the registry, so types registered later
+// are priced too. ParkingLot swaps whole schedules at runtime
+// (setFeeSchedule), never edits one.
+struct FeeSchedule {
+    static constexpr unsigned long long REGISTERED_RATE = ~0ull;
+
+    unsigned long long hourly[MAX_SLOT_TYPES];
+    unsigned long long graceMinutes = GRACE_MINUTES;
+    unsigned long long lostTicketPenalty = LOST_TICKET_PENALTY;
+    unsigned long long dayPassHours = DAY_PASS_HOURS;
+
+    FeeSchedule() {
+        for (auto& h : hourly) h = REGISTERED_RATE;
+    }
+    unsigned long long rate(SlotType s) const {
+        unsigned long long h = hourly[(int)s];
+        return h == REGISTERED_RATE ? hourlyRate(s) : h;
+    }
+};
+
+// Grace period free, then every started hour at the slot type's rate.
+inline FeeBreakup computeFee(const FeeSchedule& fs, SlotType s, unsigned long long minutes) {
+    FeeBreakup r;
+    r.parkedMinutes = minutes;
+    if (minutes <= fs.graceMinutes) return r;
+    r.billedHours = ceilHours(minutes);
+    r.amount = r.billedHours * fs.rate(s);
+    return r;
+}
+
+// A day pass: dayPassHours at the slot type's rate, however long it is used.
+inline FeeBreakup computeDayPassFee(const FeeSchedule& fs, SlotType s) {
+    FeeBreakup r;
+    r.billedHours = fs.dayPassHours;
+    r.amount = fs.dayPassHours * fs.rate(s);
+    return r;
+}
+
+inline FeeBreakup computeFee(SlotType s, unsigned long long minutes) {
+    static const FeeSchedule defaults;
+    return computeFee(defaults, s, minutes);
+}
+
+// Whole minutes from `in` to `out`, clamped at zero (clock steps back).
+inline unsigned long long parkedMinutesBetween(std::chrono::system_clock::time_point in,
+                                               std::chrono::system_clock::time_point out) {
+    auto mins = std::chrono::duration_cast<std::chrono::minutes>(out - in).count();
+    return mins < 0 ? 0 : (unsigned long long)mins;
+}
@@ -0,0 +1,114 @@
+#pragma once
+// ===================== USDT probes =====================
+// Static tracepoints for perf / bpftrace (provider "parkinglot").
+// Compiled in only with -DPARKINGLOT_USDT and <sys/sdt.h> available
+// (systemtap-sdt-dev); otherwise every PL_PROBE* expands to nothing and
+// its arguments are never evaluated.
+//
+//   bpftrace -e 'usdt:./parking_lot:parkinglot:enter__end { @ns = hist(arg3); }'
+//
+// A "slot handle" is (floorIndex << 32) | slotIndex. Durations are ns.
+//
+//   enter__start     (gate: char*, vehicleType: int)
+//   enter__slot      (floorNo: int, slotHandle: u64)
+//   enter__end       (ticket: u64, floorNo: int, slotHandle: u64, ns)
+//   exit__found      (ticket: u64, slotHandle: u64)
+//   exit__fee        (ticket: u64, parkedMinutes: u64, amount: u64)
+//   exit__bill       (ticket: u64, bill: u64, ns)
+//   pay__start       (bill: u64, method: int)
+//   pay__end         (bill: u64, ok: int, ns)
+//   lock__acquired   (mutex: void*, waitNs)
+//   lock__released   (mutex: void*, holdNs)
+//
+// Every probe has a USDT semaphore, so the ns arguments cost a
+// steady_clock read only while a tracer is attached to that probe; with
+// nothing attached they are 0 and the hot path takes no timestamps.
+
+#include <chrono>
+#include <cstdint>
+
+#if defined(PARKINGLOT_USDT) && defined(__has_include)
+#  if __has_include(<sys/sdt.h>)
+// Semaphores make DTRACE_PROBE* reference parkinglot_<probe>_semaphore,
+// which the tracer increments on attach.
+#    define _SDT_HAS_SEMAPHORES 1
+#    include <sys/sdt.h>
+#    define PL_USDT_ENABLED 1
+#  endif
+#endif
+
+#ifdef PL_USDT_ENABLED
+#  define PL_PROBE1(n, a)             DTRACE_PROBE1(parkinglot, n, a)
+#  define PL_PROBE2(n, a, b)          DTRACE_PROBE2(parkinglot, n, a, b)
+#  define PL_PROBE3(n, a, b, c)       DTRACE_PROBE3(parkinglot, n, a, b, c)
+#  define PL_PROBE4(n, a, b, c, d)    DTRACE_PROBE4(parkinglot, n, a, b, c, d)
+// Weak, so a second TU including this header links to the same counter.
+#  define PL_PROBE_SEMAPHORE(n) \
+    extern "C" { __attribute__((weak, section(".probes"))) volatile unsigned short parkinglot_##n##_semaphore = 0; }
+#  define PL_PROBE_ENABLED(n)         __builtin_expect(parkinglot_##n##_semaphore != 0, 0)
+PL_PROBE_SEMAPHORE(enter__start)
+PL_PROBE_SEMAPHORE(enter__slot)
+PL_PROBE_SEMAPHORE(enter__end)
+PL_PROBE_SEMAPHORE(exit__found)
+PL_PROBE_SEMAPHORE(exit__fee)
+PL_PROBE_SEMAPHORE(exit__bill)
+PL_PROBE_SEMAPHORE(pay__start)
+PL_PROBE_SEMAPHORE(pay__end)
+PL_PROBE_SEMAPHORE(lock__acquired)
+PL_PROBE_SEMAPHORE(lock__released)
+#else
+#  define PL_USDT_ENABLED 0
+// sizeof keeps the arguments "used" without evaluating them.
+#  define PL_PROBE1(n, a)             ((void)sizeof((a)))
+#  define PL_PROBE2(n, a, b)          ((void)sizeof((a), (b)))
+#  define PL_PROBE3(n, a, b, c)       ((void)sizeof((a), (b), (c)))
+#  define PL_PROBE4(n, a, b, c, d)    ((void)sizeof((a), (b), (c), (d)))
+#  define PL_PROBE_ENABLED(n)         false
+#endif
+
+// Timestamp for probe durations; 0 unless `armed` (PL_PROBE_ENABLED of the
+// probe that reports it), and folds to 0 when probes are compiled out.
+inline std::uint64_t probeNowNs(bool armed) {
+#if PL_USDT_ENABLED
+    if (!armed) return 0;
+    return (std::uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+#else
+    (void)armed;
+    return 0;
+#endif
+}
+
+// Start/elapsed pair for one probe's ns argument. elapsed() is 0 when the
+// start was not armed, so a tracer attaching mid-call never sees a
+// duration measured from 0.
+class ProbeTimer {
+    std::uint64_t t0_;
+public:
+    explicit ProbeTimer(bool armed) : t0_(probeNowNs(armed)) {}
+    std::uint64_t elapsed() const { return t0_ ? probeNowNs(true) - t0_ : 0; }
+};
+
+inline std::uint64_t slotHandle(std::size_t floorIdx, std::size_t slotIdx) {
+    return ((std::uint64_t)floorIdx << 32) | (std::uint64_t)slotIdx;
+}
+
+// lock_guard that fires lock__acquired / lock__released.
+template <class Mutex>
+class ProbedLock {
+    Mutex& m_;
+    ProbeTimer held_{false};
+public:
+    explicit ProbedLock(Mutex& m) : m_(m) {
+        ProbeTimer wait(PL_PROBE_ENABLED(lock__acquired));
+        m_.lock();
+        held_ = ProbeTimer(PL_PROBE_ENABLED(lock__released));
+        PL_PROBE2(lock__acquired, (void*)&m_, wait.elapsed());
+    }
+    ~ProbedLock() {
+        PL_PROBE2(lock__released, (void*)&m_, held_.elapsed());
+        m_.unlock();
+    }
+    ProbedLock(const ProbedLock&) = delete;
+    ProbedLock& operator=(const ProbedLock&) = delete;
+};
@@ -0,0 +1,403 @@
+#pragma once
+// ===================== Reference model =====================
+// The original, deliberately simple lot: linear free-slot scan, linear slot
+// lookup, one map per table, no locks. It defines the semantics the
+// optimized ParkingLot must keep, and lotcheck.cc compares the two.
+// Include after Parkinglot.cc (it reuses the domain types); copyable so the
+// linearizability checker can branch on states.
+
+#include <map>
+#include <set>
+
+struct ReferenceLot {
+    // A day pass: its bill, expiry, last floor and whether the vehicle is in.
+    struct RefPass {
+        BillId bill = 0;
+        std::chrono::system_clock::time_point expiresAt;
+        size_t floor = 0;
+        Ticket ticket; // vehicle, class and slot type for re-entry
+        bool inside = false;
+    };
+
+    vector<Floor> floors;
+    map<TicketId, Ticket> active;
+    map<BillId, Bill> bills;
+    map<TicketId, RefPass> passes;
+    vector<string> fleetAccounts; // kept across configure, like the engine's
+    map<string, FleetAccountId> fleetPlates;
+    vector<FleetCharge> fleetCharges;
+    TicketId nextTicket = 1;
+    BillId nextBill = 1;
+    const IClock* clock = &SystemClock::instance();
+    SweepPolicy sweep;
+
+    // A rejected layout leaves the lot as it was.
+    void configure(vector<Floor> fs) {
+        set<string> ids;
+        for (auto& f : fs)
+            for (auto& s : f.slots) {
+                if (!TypeRegistry::instance().isSlotType(s.type))
+                    throw runtime_error("Unregistered slot type in layout: " + s.id);
+                if (!ids.insert(s.id).second) throw runtime_error("Duplicate slot id in layout: " + s.id);
+            }
+        floors = std::move(fs);
+        active.clear();
+        bills.clear();
+        passes.clear();
+        nextTicket = 1;
+        nextBill = 1;
+    }
+
+    TicketId enterVehicle(const string& gate, const Vehicle& v) {
+        SlotType need = slotFor(v.type);
+        for (auto& f : floors)
+            for (auto& s : f.slots)
+                if (s.type == need && s.isFree) {
+                    s.isFree = false;
+                    Ticket tk;
+                    tk.id = nextTicket++;
+                    tk.entryGateId = gate;
+                    tk.inTime = clock->now();
+                    tk.slotId = s.id;
+                    tk.vtype = v.type;
+                    tk.stype = s.type;
+                    tk.vehicleReg = v.regNo;
+                    active.emplace(tk.id, tk);
+                    return tk.id;
+                }
+        throw runtime_error("No free slot available");
+    }
+
+    // First free slot of type `need`, floor `prefer` first.
+    ParkingSlot& takeSlot(SlotType need, size_t prefer, size_t& floor) {
+        for (int pass = 0; pass < 2; ++pass)
+            for (size_t f = 0; f < floors.size(); ++f) {
+                if (pass == 0 && f != prefer) continue;
+                for (auto& s : floors[f].slots)
+                    if (s.type == need && s.isFree) {
+                        s.isFree = false;
+                        floor = f;
+                        return s;
+                    }
+            }
+        throw runtime_error("No free slot available");
+    }
+
+    TicketId enterWithDayPass(const string& gate, const Vehicle& v) {
+        SlotType need = slotFor(v.type);
+        RefPass p;
+        ParkingSlot& s = takeSlot(need, floors.size(), p.floor);
+        Ticket tk;
+        tk.id = nextTicket++;
+        tk.entryGateId = gate;
+        tk.inTime = clock->now();
+        tk.slotId = s.id;
+        tk.vtype = v.type;
+        tk.stype = s.type;
+        tk.vehicleReg = v.regNo;
+        tk.dayPass = true;
+        active.emplace(tk.id, tk);
+
+        Bill b;
+        b.id = nextBill++;
+        b.ticket = tk.id;
+        b.vehicleReg = tk.vehicleReg;
+        b.slotId = tk.slotId;
+        b.entryGateId = gate;
+        b.exitGateId = "DAYPASS";
+        b.inTime = tk.inTime;
+        b.outTime = clock->now();
+        b.billedHours = DAY_PASS_HOURS;
+        b.amount = DAY_PASS_HOURS * hourlyRate(need);
+        b.status = BillStatus::Pending;
+        bills.emplace(b.id, b);
+
+        p.bill = b.id;
+        p.expiresAt = std::chrono::time_point_cast<std::chrono::minutes>(tk.inTime) +
+                      std::chrono::minutes(DAY_PASS_MINUTES);
+        p.ticket = tk;
+        p.inside = true;
+        passes.emplace(tk.id, p);
+        return tk.id;
+    }
+
+    void reenterVehicle(TicketId pass, const string& gate) {
+        auto it = passes.find(pass);
+        if (it == passes.end() || clock->now() >= it->second.expiresAt)
+            throw runtime_error("Invalid or expired day pass");
+        RefPass& p = it->second;
+        if (p.inside) throw runtime_error("Day pass vehicle is already inside");
+        ParkingSlot& s = takeSlot(p.ticket.stype, p.floor, p.floor);
+        Ticket tk = p.ticket;
+        tk.entryGateId = gate;
+        tk.inTime = clock->now();
+        tk.slotId = s.id;
+        active.emplace(tk.id, tk);
+        p.inside = true;
+    }
+
+    Bill exitVehicle(TicketId tid, const string& exitGate, bool lostTicket = false) {
+        using namespace std::chrono;
+        auto it = active.find(tid);
+        if (it == active.end()) throw runtime_error("Invalid or already-closed ticket");
+        Ticket tk = it->second;
+        BillId passBill = 0;
+        if (tk.dayPass) {
+            RefPass& p = passes.at(tid);
+            if (clock->now() < p.expiresAt) {
+                if (bills.at(p.bill).status != BillStatus::Paid) throw runtime_error("Day pass not paid");
+                p.inside = false;
+                passBill = p.bill;
+            } else {
+                tk.inTime = p.expiresAt; // overstay billed from the expiry
+                passes.erase(tid);
+            }
+        }
+        active.erase(it);
+        for (auto& f : floors)
+            for (auto& s : f.slots)
+                if (s.id == tk.slotId) s.isFree = true;
+        if (passBill && !lostTicket) {
+            Bill b = bills.at(passBill); // stamped with this exit, stored one unchanged
+            b.exitGateId = exitGate;
+            b.outTime = clock->now();
+            return b;
+        }
+        if (passBill) {
+            // lost pass ticket: a bill for the penalty alone
+            auto mins = duration_cast<minutes>(clock->now() - tk.inTime).count();
+            Bill b;
+            b.id = nextBill++;
+            b.ticket = tk.id;
+            b.vehicleReg = tk.vehicleReg;
+            b.slotId = tk.slotId;
+            b.entryGateId = tk.entryGateId;
+            b.exitGateId = exitGate;
+            b.inTime = tk.inTime;
+            b.outTime = clock->now();
+            b.parkedMinutes = (unsigned long long)(mins < 0 ? 0 : mins);
+            b.amount = 200;
+            b.status = BillStatus::Pending;
+            bills.emplace(b.id, b);
+            return b;
+        }
+
+        auto mins = duration_cast<minutes>(clock->now() - tk.inTime).count();
+        if (mins < 0) mins = 0;
+        FeeBreakup fb = FeeStrategyFactory::make(tk.stype)->compute((unsigned long long)mins);
+        if (lostTicket) fb.amount += 200;
+
+        auto fleet = fleetPlates.find(tk.vehicleReg);
+        if (fleet != fleetPlates.end()) {
+            FleetCharge c;
+            c.ticket = tk.id;
+            c.outMinute = (uint32_t)duration_cast<minutes>(clock->now().time_since_epoch()).count();
+            c.account = fleet->second;
+            c.parkedMinutes = (uint32_t)fb.parkedMinutes;
+            c.billedHours = (uint32_t)fb.billedHours;
+            c.amount = fb.amount;
+            fleetCharges.push_back(c);
+        }
+
+        Bill b;
+        b.ticket = tk.id;
+        b.vehicleReg = tk.vehicleReg;
+        b.slotId = tk.slotId;
+        b.entryGateId = tk.entryGateId;
+        b.exitGateId = exitGate;
+        b.inTime = tk.inTime;
+        b.outTime = clock->now();
+        b.parkedMinutes = fb.parkedMinutes;
+        b.billedHours = fb.billedHours;
+        b.amount = fb.amount;
+        if (fleet != fleetPlates.end()) {
+            b.status = BillStatus::OnAccount; // id 0, not stored
+            return b;
+        }
+        b.id = nextBill++;
+        b.status = BillStatus::Pending;
+        bills.emplace(b.id, b);
+        return b;
+    }
+
+    FleetAccountId addFleetAccount(const string& name) {
+        if (std::find(fleetAccounts.begin(), fleetAccounts.end(), name) != fleetAccounts.end())
+            throw runtime_error("Duplicate fleet account: " + name);
+        fleetAccounts.push_back(name);
+        return (FleetAccountId)(fleetAccounts.size() - 1);
+    }
+    void assignFleetPlate(const string& plate, FleetAccountId account) {
+        if (account >= fleetAccounts.size()) throw runtime_error("Unknown fleet account");
+        fleetPlates[plate] = account;
+    }
+
+    vector<FleetInvoice> fleetInvoices(std::chrono::system_clock::time_point from,
+                                       std::chrono::system_clock::time_point to) const {
+        using namespace std::chrono;
+        map<FleetAccountId, FleetInvoice> byAccount;
+        for (const FleetCharge& c : fleetCharges) {
+            auto out = system_clock::time_point(minutes(c.outMinute));
+            if (out < time_point_cast<minutes>(from) || out >= time_point_cast<minutes>(to)) continue;
+            FleetInvoice& inv = byAccount[c.account];
+            inv.account = c.account;
+            inv.name = fleetAccounts[c.account];
+            ++inv.charges;
+            inv.parkedMinutes += c.parkedMinutes;
+            inv.billedHours += c.billedHours;
+            inv.amount += c.amount;
+        }
+        vector<FleetInvoice> out;
+        for (auto& [a, inv] : byAccount) out.push_back(inv);
+        return out;
+    }
+
+    optional<BillStatus> billStatus(BillId id) const {
+        auto it = bills.find(id);
+        if (it == bills.end()) return nullopt;
+        return it->second.status;
+    }
+
+    Receipt payBill(const PaymentRequest& req) {
+        auto it = bills.find(req.bill);
+        if (it == bills.end()) throw runtime_error("Bill not found");
+        Bill& b = it->second;
+        if (b.status == BillStatus::Paid)
+            return Receipt{b.id, b.ticket, b.amount, "ALREADY_PAID", clock->now()};
+        if (b.status != BillStatus::Pending && b.status != BillStatus::Deferred &&
+            b.status != BillStatus::Abandoned)
+            throw runtime_error("Bill is not payable (status not Pending/Deferred/Abandoned)");
+        string reason;
+        auto proc = makeProcessor(req.method);
+        if (!proc->charge(req, reason)) {
+            b.status = BillStatus::Failed;
+            throw runtime_error("Payment failed: " + reason);
+        }
+        b.status = BillStatus::Paid;
+        return Receipt{b.id, b.ticket, b.amount, proc->name(), clock->now()};
+    }
+
+    EvacuationSummary evacuateAll(const string& exitGate, EvacuationBilling billing) {
+        return evacuateSome(nullptr, exitGate, billing);
+    }
+    EvacuationSummary evacuate(const vector<TicketId>& tids, const string& exitGate,
+                               EvacuationBilling billing) {
+        return evacuateSome(&tids, exitGate, billing);
+    }
+
+    // Closes the listed open tickets (all when `tids` is null) one by one in
+    // ticket id order; unknown ids are skipped.
+    EvacuationSummary evacuateSome(const vector<TicketId>* tids, const string& exitGate,
+                                   EvacuationBilling billing) {
+        using namespace std::chrono;
+        EvacuationSummary sum;
+        vector<TicketId> ids;
+        for (const auto& [id, tk] : active)
+            if (!tids || std::find(tids->begin(), tids->end(), id) != tids->end()) ids.push_back(id);
+        for (TicketId id : ids) {
+            Ticket tk = active.at(id);
+            active.erase(id);
+            for (auto& f : floors)
+                for (auto& s : f.slots)
+                    if (s.id == tk.slotId) s.isFree = true;
+            if (tk.dayPass) {
+                passes.at(id).inside = false;
+                continue;
+            }
+            auto mins = duration_cast<minutes>(clock->now() - tk.inTime).count();
+            if (mins < 0) mins = 0;
+            FeeBreakup fb;
+            fb.parkedMinutes = (unsigned long long)mins;
+            if (billing == EvacuationBilling::Defer)
+                fb = FeeStrategyFactory::make(tk.stype)->compute((unsigned long long)mins);
+
+            Bill b;
+            b.id = nextBill++;
+            b.ticket = tk.id;
+            b.vehicleReg = tk.vehicleReg;
+            b.slotId = tk.slotId;
+            b.entryGateId = tk.entryGateId;
+            b.exitGateId = exitGate;
+            b.inTime = tk.inTime;
+            b.outTime = clock->now();
+            b.parkedMinutes = fb.parkedMinutes;
+            b.billedHours = fb.billedHours;
+            b.amount = fb.amount;
+            b.status = billing == EvacuationBilling::Waive ? BillStatus::Waived : BillStatus::Deferred;
+            bills.emplace(b.id, b);
+            if (!sum.closed++) sum.firstBill = b.id;
+            sum.deferredAmount += b.amount;
+        }
+        return sum;
+    }
+
+    // Scans every open ticket; closes (or flags) those open for maxAge.
+    SweepResult sweepAbandoned() {
+        using namespace std::chrono;
+        SweepResult res;
+        vector<TicketId> ids;
+        for (const auto& [id, tk] : active) ids.push_back(id);
+        for (TicketId id : ids) {
+            Ticket& tk = active.at(id);
+            auto age = clock->now() - tk.inTime;
+            if (tk.abandoned || age < sweep.maxAge) continue;
+            if (tk.dayPass && clock->now() < passes.at(id).expiresAt) continue;
+            if (sweep.action == AbandonAction::Flag) {
+                tk.abandoned = true;
+                ++res.flagged;
+                continue;
+            }
+            for (auto& f : floors)
+                for (auto& s : f.slots)
+                    if (s.id == tk.slotId) s.isFree = true;
+            if (tk.dayPass) {
+                tk.inTime = passes.at(id).expiresAt; // overstay from the expiry
+                passes.erase(id);
+            }
+            FeeBreakup fb = FeeStrategyFactory::make(tk.stype)->compute(
+                (unsigned long long)duration_cast<minutes>(clock->now() - tk.inTime).count());
+            Bill b;
+            b.id = nextBill++;
+            b.ticket = tk.id;
+            b.vehicleReg = tk.vehicleReg;
+            b.slotId = tk.slotId;
+            b.entryGateId = tk.entryGateId;
+            b.exitGateId = "SWEEP";
+            b.inTime = tk.inTime;
+            b.outTime = clock->now();
+            b.parkedMinutes = fb.parkedMinutes;
+            b.billedHours = fb.billedHours;
+            b.amount = fb.amount;
+            b.status = BillStatus::Abandoned;
+            bills.emplace(b.id, b);
+            active.erase(id);
+            ++res.closed;
+            res.amount += b.amount;
+        }
+        return res;
+    }
+
+    void adjustInTimeForTest(TicketId tid, long long minutesBack) {
+        auto it = active.find(tid);
+        if (it == active.end()) throw runtime_error("Ticket not found for adjustInTime");
+        it->second.inTime -= std::chrono::minutes(minutesBack);
+        if (it->second.dayPass) passes.at(tid).expiresAt -= std::chrono::minutes(minutesBack);
+    }
+
+    void occupancy(int& freeCnt, int& usedCnt, int& total) const {
+        freeCnt = usedCnt = total = 0;
+        for (const auto& f : floors)
+            for (const auto& s : f.slots) {
+                ++total;
+                if (s.isFree) ++freeCnt; else ++usedCnt;
+            }
+    }
+
+    int freeSlots(SlotType t) const {
+        int n = 0;
+        for (const auto& f : floors)
+            for (const auto& s : f.slots) n += s.type == t && s.isFree;
+        return n;
+    }
+
+    size_t activeCount() const { return active.size(); }
+};
@@ -0,0 +1,198 @@
+#pragma once
+// ===================== Deterministic simulation =====================
+// Runs a set of tasks on real threads but lets exactly one run at a time;
+// a seeded RNG picks who runs next at every scheduling point (each engine
+// lock acquisition and every explicit yield()). Simulated time advances by
+// a seeded step at each switch. The same seed therefore replays the same
+// interleaving, lock order and timestamps exactly.
+//
+//   SimScheduler sim(seed);
+//   lot.setClock(sim.clock());
+//   sim.spawn([&] { lot.enterVehicle("E1", car); });
+//   sim.spawn([&] { lot.exitVehicle(1, "X1"); });
+//   sim.run();   // throws SimDeadlock if every live task is blocked
+//
+// Engine locks are EngineMutex: a std::mutex outside simulation, a
+// scheduler-managed lock on simulated task threads.
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "lot_clock.h"
+
+// Thrown into tasks when the simulation is torn down. Deliberately not a
+// std::exception so engine code that catches those lets it through.
+struct SimAborted {};
+struct SimDeadlock {};
+
+class SimClock final : public IClock {
+    std::atomic<std::int64_t> nowUs_;
+public:
+    explicit SimClock(std::chrono::system_clock::time_point start = std::chrono::system_clock::now())
+        : nowUs_(std::chrono::duration_cast<std::chrono::microseconds>(start.time_since_epoch()).count()) {}
+    std::chrono::system_clock::time_point now() const override {
+        return std::chrono::system_clock::time_point(std::chrono::microseconds(nowUs_.load()));
+    }
+    void advance(std::chrono::microseconds d) { nowUs_.fetch_add(d.count()); }
+};
+
+class SimScheduler {
+public:
+    explicit SimScheduler(std::uint64_t seed,
+                          std::chrono::microseconds maxStep = std::chrono::milliseconds(500))
+        : rng_(seed), maxStepUs_((std::uint64_t)maxStep.count() + 1) {}
+    SimScheduler(const SimScheduler&) = delete;
+    SimScheduler& operator=(const SimScheduler&) = delete;
+
+    // Non-null on the thread of a running simulated task.
+    static SimScheduler* current() { return tCurrent(); }
+
+    const SimClock& clock() const { return clock_; }
+    std::uint64_t switches() const { return switches_; }
+
+    void spawn(std::function<void()> fn) { tasks_.push_back(Task{std::move(fn), false, nullptr, nullptr}); }
+
+    // Runs every task to completion; rethrows the first task exception.
+    void run() {
+        std::vector<std::thread> threads;
+        for (int i = 0; i < (int)tasks_.size(); ++i)
+            threads.emplace_back([this, i] { taskMain(i); });
+        {
+            std::unique_lock<std::mutex> lk(mu_);
+            running_ = pickNext_locked();
+            cv_.notify_all();
+            cv_.wait(lk, [&] { return aborted_ || allDone_locked(); });
+        }
+        for (auto& t : threads) t.join();
+        if (deadlocked_) throw SimDeadlock{};
+        for (auto& t : tasks_)
+            if (t.error) std::rethrow_exception(t.error);
+    }
+
+    // Scheduling point: may hand the CPU to another task.
+    void yield() {
+        std::unique_lock<std::mutex> lk(mu_);
+        switch_locked(lk);
+    }
+
+    // EngineMutex hooks.
+    void lockMutex(const void* m) {
+        std::unique_lock<std::mutex> lk(mu_);
+        switch_locked(lk);
+        while (owners_.count(m)) {
+            tasks_[tIndex()].blockedOn = m;
+            switch_locked(lk);
+        }
+        owners_[m] = tIndex();
+    }
+    void unlockMutex(const void* m) {
+        std::lock_guard<std::mutex> lk(mu_);
+        owners_.erase(m);
+        for (auto& t : tasks_)
+            if (t.blockedOn == m) t.blockedOn = nullptr;
+    }
+
+private:
+    struct Task {
+        std::function<void()> fn;
+        bool done = false;
+        const void* blockedOn = nullptr;
+        std::exception_ptr error;
+    };
+
+    static SimScheduler*& tCurrent() { thread_local SimScheduler* s = nullptr; return s; }
+    static int& tIndex() { thread_local int i = -1; return i; }
+
+    void taskMain(int i) {
+        {
+            std::unique_lock<std::mutex> lk(mu_);
+            cv_.wait(lk, [&] { return aborted_ || running_ == i; });
+            if (aborted_) return;
+        }
+        tCurrent() = this;
+        tIndex() = i;
+        try {
+            tasks_[i].fn();
+        } catch (const SimAborted&) {
+        } catch (const SimDeadlock&) {
+        } catch (...) {
+            tasks_[i].error = std::current_exception();
+        }
+        tCurrent() = nullptr;
+
+        std::lock_guard<std::mutex> lk(mu_);
+        tasks_[i].done = true;
+        if (aborted_) return;
+        running_ = pickNext_locked();
+        if (running_ < 0 && !allDone_locked()) abort_locked();
+        cv_.notify_all();
+    }
+
+    // Picks the next task (possibly the caller) and waits for our turn.
+    void switch_locked(std::unique_lock<std::mutex>& lk) {
+        if (aborted_) throw SimAborted{};
+        int self = tIndex();
+        int next = pickNext_locked();
+        if (next < 0) { abort_locked(); throw SimDeadlock{}; }
+        clock_.advance(std::chrono::microseconds(rng_() % maxStepUs_));
+        if (next == self) return;
+        ++switches_;
+        running_ = next;
+        cv_.notify_all();
+        cv_.wait(lk, [&] { return aborted_ || running_ == self; });
+        if (aborted_) throw SimAborted{};
+    }
+
+    int pickNext_locked() {
+        std::vector<int> runnable;
+        for (int i = 0; i < (int)tasks_.size(); ++i)
+            if (!tasks_[i].done && !tasks_[i].blockedOn) runnable.push_back(i);
+        if (runnable.empty()) return -1;
+        return runnable[rng_() % runnable.size()];
+    }
+
+    bool allDone_locked() const {
+        for (const auto& t : tasks_) if (!t.done) return false;
+        return true;
+    }
+
+    void abort_locked() {
+        deadlocked_ = aborted_ = true;
+        owners_.clear();
+        cv_.notify_all();
+    }
+
+    std::mutex mu_;
+    std::condition_variable cv_;
+    std::vector<Task> tasks_;
+    std::map<const void*, int> owners_; // simulated mutex -> owning task
+    int running_ = -1;
+    bool aborted_ = false, deadlocked_ = false;
+    std::mt19937_64 rng_;
+    std::uint64_t maxStepUs_;
+    std::uint64_t switches_ = 0;
+    // fixed epoch so replayed runs also reproduce absolute timestamps
+    SimClock clock_{std::chrono::system_clock::time_point(std::chrono::seconds(1700000000))};
+};
+
+// Engine lock: plain std::mutex unless the caller is a simulated task.
+class EngineMutex {
+    std::mutex m_;
+public:
+    void lock() {
+        if (SimScheduler* s = SimScheduler::current()) s->lockMutex(this);
+        else m_.lock();
+    }
+    void unlock() {
+        if (SimScheduler* s = SimScheduler::current()) s->unlockMutex(this);
+        else m_.unlock();
+    }
+};
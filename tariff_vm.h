@@ -0,0 +1,474 @@
+#pragma once
+// ===================== Tariff rules =====================
+// Tariffs written as one expression in config and compiled to bytecode,
+// so a new tariff ships without a rebuild. The expression gives the fee in
+// INR for one stay:
+//
+//   minutes <= 10 ? 0 : hours * (slot == Heavy ? 50 : slot == FourWheeler ? 20 : 10)
+//   class == member ? 0 : (out_hour >= 22 || out_hour < 6) ? 30 : 20 * max(hours, 1)
+//
+// Language: 64-bit integers; + - * / %, comparisons, && || ! (0 is false),
+// cond ? a : b, min(a, b), max(a, b), parentheses. Division by zero gives
+// 0; a divisor that folds to the constant 0 fails to compile, unless it
+// sits in a branch folding removes. Variables (TariffVar): minutes, hours
+// (started hours), slot, class, in_hour, out_hour (local time, 0..23),
+// out_weekday (Mon = 0 .. Sun = 6).
+// Names: the slot types registered when the rule compiles (TwoWheeler,
+// FourWheeler, Heavy, ...; see TypeRegistry), the weekdays (Mon .. Sun)
+// and the customer classes the caller passes in.
+//
+// compile() parses to a tree, folds constant subtrees (including ?: and
+// && / || whose condition is constant) and emits stack code. A binary op
+// with a constant operand (the right one, or either for + * min max == !=)
+// takes it from the constant pool instead of the stack. run() is a switch
+// loop over 8-byte instructions with a fixed stack, no allocation. Errors
+// throw std::runtime_error, naming the column for syntax errors. Nesting
+// (parentheses, unary operators, ?: chains, operator chains) is capped at
+// MAX_NESTING so a hostile rule cannot overflow the compiler's stack.
+
+#include <cctype>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "parking_core.h"
+
+enum class TariffVar { Minutes, Hours, Slot, Class, InHour, OutHour, OutWeekday, COUNT };
+
+// Variable values for one stay. utcOffsetMinutes places the lot's local
+// day (e.g. 330 for IST).
+struct TariffInput {
+    std::int64_t v[(int)TariffVar::COUNT] = {};
+
+    TariffInput() = default;
+    TariffInput(unsigned long long minutes, SlotType slot, int customerClass,
+                std::chrono::system_clock::time_point in, std::chrono::system_clock::time_point out,
+                int utcOffsetMinutes) {
+        v[(int)TariffVar::Minutes] = (std::int64_t)minutes;
+        v[(int)TariffVar::Hours] = (std::int64_t)ceilHours(minutes);
+        v[(int)TariffVar::Slot] = (std::int64_t)slot;
+        v[(int)TariffVar::Class] = customerClass;
+        std::int64_t inMin = localMinutes(in, utcOffsetMinutes), outMin = localMinutes(out, utcOffsetMinutes);
+        v[(int)TariffVar::InHour] = inMin / 60 % 24;
+        v[(int)TariffVar::OutHour] = outMin / 60 % 24;
+        v[(int)TariffVar::OutWeekday] = (outMin / (24 * 60) + 3) % 7; // 1970-01-01 was a Thursday
+    }
+
+private:
+    static std::int64_t localMinutes(std::chrono::system_clock::time_point t, int utcOffsetMinutes) {
+        std::int64_t m = std::chrono::duration_cast<std::chrono::minutes>(t.time_since_epoch()).count();
+        m += utcOffsetMinutes;
+        return m < 0 ? 0 : m;
+    }
+};
+
+class TariffProgram {
+public:
+    static constexpr int MAX_STACK = 32;
+    static constexpr int MAX_NESTING = 256; // parser recursion and tree height
+
+    TariffProgram() = default; // charges 0
+
+    // names: extra identifiers (customer classes) and their values.
+    static TariffProgram compile(std::string_view source,
+                                 const std::vector<std::pair<std::string, std::int64_t>>& names = {}) {
+        Compiler c(source, names);
+        return c.run();
+    }
+
+    std::int64_t run(const TariffInput& in) const {
+        std::int64_t st[MAX_STACK];
+        int sp = 0;
+        const Insn* code = code_.data();
+        for (std::size_t pc = 0;; ++pc) {
+            const Insn& i = code[pc];
+            if (i.op >= FIRST_BINARY) {
+                std::int64_t b = i.k ? consts_[i.arg] : st[--sp];
+                std::int64_t& a = st[sp - 1];
+                a = binary((Op)i.op, a, b);
+                continue;
+            }
+            switch ((Op)i.op) {
+                case PUSHK: st[sp++] = consts_[i.arg]; break;
+                case LOAD:  st[sp++] = in.v[i.arg]; break;
+                case NEG:   st[sp - 1] = (std::int64_t)(0 - (std::uint64_t)st[sp - 1]); break;
+                case NOT:   st[sp - 1] = !st[sp - 1]; break;
+                case BOOL:  st[sp - 1] = st[sp - 1] != 0; break;
+                case JZ:    if (!st[--sp]) pc = (std::size_t)i.arg - 1; break;
+                case JNZ:   if (st[--sp]) pc = (std::size_t)i.arg - 1; break;
+                case JMP:   pc = (std::size_t)i.arg - 1; break;
+                case RET:   return st[sp - 1];
+                default:    break;
+            }
+        }
+    }
+
+    std::size_t size() const { return code_.size(); }            // instructions
+    bool isConstant() const { return code_.size() == 2 && code_[0].op == PUSHK; }
+
+private:
+    enum Op : std::uint8_t {
+        PUSHK, LOAD, NEG, NOT, BOOL, JZ, JNZ, JMP, RET,
+        FIRST_BINARY,
+        ADD = FIRST_BINARY, SUB, MUL, DIV, MOD, MIN, MAX, EQ, NE, LT, LE, GT, GE,
+    };
+
+    struct Insn {
+        std::uint8_t op = RET;
+        bool k = false;       // binary: right operand is consts_[arg]
+        std::int32_t arg = 0; // constant index, variable or jump target
+    };
+
+    static std::int64_t binary(Op op, std::int64_t a, std::int64_t b) {
+        using U = std::uint64_t; // wrap instead of overflowing
+        switch (op) {
+            case ADD: return (std::int64_t)((U)a + (U)b);
+            case SUB: return (std::int64_t)((U)a - (U)b);
+            case MUL: return (std::int64_t)((U)a * (U)b);
+            case DIV: return b == 0 ? 0 : b == -1 ? (std::int64_t)(0 - (U)a) : a / b;
+            case MOD: return b == 0 || b == -1 ? 0 : a % b;
+            case MIN: return a < b ? a : b;
+            case MAX: return a > b ? a : b;
+            case EQ:  return a == b;
+            case NE:  return a != b;
+            case LT:  return a < b;
+            case LE:  return a <= b;
+            case GT:  return a > b;
+            case GE:  return a >= b;
+            default:  return 0;
+        }
+    }
+
+    // ---- Compiler: source -> tree -> folded tree -> code ----
+    class Compiler {
+    public:
+        Compiler(std::string_view src, const std::vector<std::pair<std::string, std::int64_t>>& names)
+            : src_(src), names_(names) {}
+
+        TariffProgram run() {
+            int root = parseExpr();
+            skipSpace();
+            if (pos_ != src_.size()) fail("unexpected '" + std::string(1, src_[pos_]) + "'");
+            root = fold(root);
+            emit(root, 0);
+            code_.push_back(Insn{RET, false, 0});
+            if (maxDepth_ > MAX_STACK) fail("expression too deep");
+            TariffProgram p;
+            p.code_ = std::move(code_);
+            p.consts_ = std::move(consts_);
+            return p;
+        }
+
+    private:
+        enum Kind { Const, Var, Unary, Binary, And, Or, Cond };
+        struct Node {
+            Kind kind;
+            Op op = RET;
+            std::int64_t value = 0;
+            int a = -1, b = -1, c = -1;
+            int height = 1; // set by node()
+        };
+
+        // Bounds the parser's recursion; fold() and emit() recurse over the
+        // tree, whose height node() bounds.
+        struct Nest {
+            Compiler& c;
+            explicit Nest(Compiler& comp) : c(comp) {
+                if (++c.nesting_ > MAX_NESTING) c.fail("expression too deeply nested");
+            }
+            ~Nest() { --c.nesting_; }
+        };
+
+        std::string_view src_;
+        const std::vector<std::pair<std::string, std::int64_t>>& names_;
+        std::size_t pos_ = 0;
+        std::vector<Node> nodes_;
+        std::vector<Insn> code_;
+        std::vector<std::int64_t> consts_;
+        int maxDepth_ = 0;
+        int nesting_ = 0;
+
+        [[noreturn]] void fail(const std::string& what) const {
+            throw std::runtime_error("tariff: " + what + " at column " + std::to_string(pos_ + 1));
+        }
+
+        int node(Node n) {
+            for (int k : {n.a, n.b, n.c})
+                if (k >= 0 && nodes_[k].height + 1 > n.height) n.height = nodes_[k].height + 1;
+            if (n.height > MAX_NESTING) fail("expression too deeply nested");
+            nodes_.push_back(n);
+            return (int)nodes_.size() - 1;
+        }
+        int constant(std::int64_t v) { return node(Node{Const, RET, v}); }
+
+        void skipSpace() {
+            while (pos_ < src_.size() && (src_[pos_] == ' ' || src_[pos_] == '\t' || src_[pos_] == '\n' ||
+                                          src_[pos_] == '\r'))
+                ++pos_;
+        }
+        bool eat(std::string_view tok) {
+            skipSpace();
+            if (src_.substr(pos_, tok.size()) != tok) return false;
+            pos_ += tok.size();
+            return true;
+        }
+        void expect(std::string_view tok) {
+            if (!eat(tok)) fail("expected '" + std::string(tok) + "'");
+        }
+
+        int parseExpr() {
+            Nest nest(*this);
+            int c = parseOr();
+            if (!eat("?")) return c;
+            int t = parseExpr();
+            expect(":");
+            int e = parseExpr();
+            return node(Node{Cond, RET, 0, c, t, e});
+        }
+        int parseOr() {
+            int l = parseAnd();
+            while (eat("||")) l = node(Node{Or, RET, 0, l, parseAnd()});
+            return l;
+        }
+        int parseAnd() {
+            int l = parseCmp();
+            while (eat("&&")) l = node(Node{And, RET, 0, l, parseCmp()});
+            return l;
+        }
+        int parseCmp() {
+            int l = parseAdd();
+            static const std::pair<std::string_view, Op> ops[] = {
+                {"==", EQ}, {"!=", NE}, {"<=", LE}, {">=", GE}, {"<", LT}, {">", GT}};
+            for (const auto& [tok, op] : ops)
+                if (eat(tok)) return node(Node{Binary, op, 0, l, parseAdd()});
+            return l;
+        }
+        int parseAdd() {
+            int l = parseMul();
+            for (;;) {
+                if (eat("+"))      l = node(Node{Binary, ADD, 0, l, parseMul()});
+                else if (eat("-")) l = node(Node{Binary, SUB, 0, l, parseMul()});
+                else return l;
+            }
+        }
+        int parseMul() {
+            int l = parseUnary();
+            for (;;) {
+                if (eat("*"))      l = node(Node{Binary, MUL, 0, l, parseUnary()});
+                else if (eat("/")) l = node(Node{Binary, DIV, 0, l, parseUnary()});
+                else if (eat("%")) l = node(Node{Binary, MOD, 0, l, parseUnary()});
+                else return l;
+            }
+        }
+        int parseUnary() {
+            Nest nest(*this);
+            skipSpace();
+            if (pos_ < src_.size() && src_[pos_] == '!' && src_.substr(pos_, 2) != "!=") {
+                ++pos_;
+                return node(Node{Unary, NOT, 0, parseUnary()});
+            }
+            if (eat("-")) return node(Node{Unary, NEG, 0, parseUnary()});
+            return parsePrimary();
+        }
+        int parsePrimary() {
+            skipSpace();
+            if (eat("(")) {
+                int e = parseExpr();
+                expect(")");
+                return e;
+            }
+            if (pos_ < src_.size() && src_[pos_] >= '0' && src_[pos_] <= '9') {
+                std::int64_t v = 0;
+                while (pos_ < src_.size() && src_[pos_] >= '0' && src_[pos_] <= '9') {
+                    if (v > (INT64_MAX - 9) / 10) fail("number too large");
+                    v = v * 10 + (src_[pos_++] - '0');
+                }
+                return constant(v);
+            }
+            std::size_t start = pos_;
+            while (pos_ < src_.size() && (std::isalnum((unsigned char)src_[pos_]) || src_[pos_] == '_')) ++pos_;
+            if (start == pos_) fail(pos_ < src_.size() ? "unexpected '" + std::string(1, src_[pos_]) + "'"
+                                                       : std::string("unexpected end"));
+            std::string_view id = src_.substr(start, pos_ - start);
+            if (id == "min" || id == "max") {
+                expect("(");
+                int a = parseExpr();
+                expect(",");
+                int b = parseExpr();
+                expect(")");
+                return node(Node{Binary, id == "min" ? MIN : MAX, 0, a, b});
+            }
+            static const std::pair<std::string_view, TariffVar> vars[] = {
+                {"minutes", TariffVar::Minutes}, {"hours", TariffVar::Hours}, {"slot", TariffVar::Slot},
+                {"class", TariffVar::Class}, {"in_hour", TariffVar::InHour}, {"out_hour", TariffVar::OutHour},
+                {"out_weekday", TariffVar::OutWeekday}};
+            for (const auto& [name, v] : vars)
+                if (id == name) return node(Node{Var, RET, (std::int64_t)v});
+            const TypeRegistry& types = TypeRegistry::instance();
+            for (int i = 0, n = types.slotTypes(); i < n; ++i)
+                if (id == types.name((SlotType)i)) return constant(i);
+            static const std::string_view weekdays[] = {"Mon", "Tue", "Wed", "Thu", "Fri", "Sat", "Sun"};
+            for (int i = 0; i < 7; ++i)
+                if (id == weekdays[i]) return constant(i);
+            for (const auto& [name, v] : names_)
+                if (id == name) return constant(v);
+            pos_ = start;
+            fail("unknown name '" + std::string(id) + "'");
+        }
+
+        // Returns the folded node. The first operand is folded first; when a
+        // constant condition (?:, && ||) drops the other branch, that branch
+        // is never folded, so it cannot fail the compile.
+        int fold(int n) {
+            Node x = nodes_[n];
+            if (x.a >= 0) x.a = fold(x.a);
+            auto isConst = [&](int i) { return i >= 0 && nodes_[i].kind == Const; };
+            auto val = [&](int i) { return nodes_[i].value; };
+            if (isConst(x.a)) {
+                switch (x.kind) {
+                    case And: return val(x.a) ? fold(node(Node{Binary, NE, 0, x.b, constant(0)})) : constant(0);
+                    case Or:  return val(x.a) ? constant(1) : fold(node(Node{Binary, NE, 0, x.b, constant(0)}));
+                    case Cond: return fold(val(x.a) ? x.b : x.c);
+                    default: break;
+                }
+            }
+            if (x.b >= 0) x.b = fold(x.b);
+            if (x.c >= 0) x.c = fold(x.c);
+            switch (x.kind) {
+                case Unary:
+                    if (isConst(x.a)) return constant(x.op == NOT ? !val(x.a) : (std::int64_t)(0 - (std::uint64_t)val(x.a)));
+                    break;
+                case Binary:
+                    if ((x.op == DIV || x.op == MOD) && isConst(x.b) && val(x.b) == 0)
+                        throw std::runtime_error("tariff: division by constant zero");
+                    if (isConst(x.a) && isConst(x.b)) return constant(binary(x.op, val(x.a), val(x.b)));
+                    break;
+                default:
+                    break;
+            }
+            nodes_[n] = x;
+            return n;
+        }
+
+        static bool commutes(Op op) { return op == ADD || op == MUL || op == MIN || op == MAX || op == EQ || op == NE; }
+
+        std::int32_t pool(std::int64_t v) {
+            auto& k = consts_;
+            for (std::size_t i = 0; i < k.size(); ++i)
+                if (k[i] == v) return (std::int32_t)i;
+            k.push_back(v);
+            return (std::int32_t)k.size() - 1;
+        }
+        std::size_t put(Op op, std::int32_t arg = 0, bool k = false) {
+            code_.push_back(Insn{op, k, arg});
+            return code_.size() - 1;
+        }
+        void patch(std::size_t at) { code_[at].arg = (std::int32_t)code_.size(); }
+
+        // Code leaving the node's value on the stack; depth = values below it.
+        void emit(int n, int depth) {
+            if (depth + 1 > maxDepth_) maxDepth_ = depth + 1;
+            const Node& x = nodes_[n];
+            switch (x.kind) {
+                case Const: put(PUSHK, pool(x.value)); break;
+                case Var:   put(LOAD, (std::int32_t)x.value); break;
+                case Unary:
+                    emit(x.a, depth);
+                    put(x.op);
+                    break;
+                case Binary:
+                    if (nodes_[x.a].kind == Const && nodes_[x.b].kind != Const && commutes(x.op)) {
+                        emit(x.b, depth);
+                        put(x.op, pool(nodes_[x.a].value), true);
+                        break;
+                    }
+                    emit(x.a, depth);
+                    if (nodes_[x.b].kind == Const) {
+                        put(x.op, pool(nodes_[x.b].value), true);
+                    } else {
+                        emit(x.b, depth + 1);
+                        put(x.op);
+                    }
+                    break;
+                case And:
+                case Or: { // a; Jx short; b; BOOL; JMP end; short: PUSHK 0|1; end:
+                    emit(x.a, depth);
+                    std::size_t shortcut = put(x.kind == And ? JZ : JNZ);
+                    emit(x.b, depth);
+                    put(BOOL);
+                    std::size_t end = put(JMP);
+                    patch(shortcut);
+                    put(PUSHK, pool(x.kind == And ? 0 : 1));
+                    patch(end);
+                    break;
+                }
+                case Cond: {
+                    emit(x.a, depth);
+                    std::size_t otherwise = put(JZ);
+                    emit(x.b, depth);
+                    std::size_t end = put(JMP);
+                    patch(otherwise);
+                    emit(x.c, depth);
+                    patch(end);
+                    break;
+                }
+            }
+        }
+    };
+
+    std::vector<Insn> code_ = {Insn{PUSHK, false, 0}, Insn{RET, false, 0}};
+    std::vector<std::int64_t> consts_ = {0};
+};
+
+// A compiled rule with the names it was compiled against. Customer class
+// ids are indices into customerClasses; every vehicle starts in class 0,
+// so list the default class ("regular", say) first.
+struct TariffRule {
+    static constexpr std::size_t MAX_CLASSES = 256;
+
+    std::string source;
+    std::vector<std::string> customerClasses;
+    int utcOffsetMinutes = 0;
+    TariffProgram program;
+
+    static TariffRule compile(std::string source, std::vector<std::string> customerClasses, int utcOffsetMinutes) {
+        if (customerClasses.size() > MAX_CLASSES) throw std::runtime_error("tariff: too many customer classes");
+        std::vector<std::pair<std::string, std::int64_t>> names;
+        for (std::size_t i = 0; i < customerClasses.size(); ++i) {
+            for (std::size_t j = 0; j < i; ++j)
+                if (customerClasses[j] == customerClasses[i])
+                    throw std::runtime_error("tariff: duplicate customer class " + customerClasses[i]);
+            names.emplace_back(customerClasses[i], (std::int64_t)i);
+        }
+        TariffRule r;
+        r.program = TariffProgram::compile(source, names);
+        r.source = std::move(source);
+        r.customerClasses = std::move(customerClasses);
+        r.utcOffsetMinutes = utcOffsetMinutes;
+        return r;
+    }
+
+    // Class id for `name`, or -1.
+    int classId(std::string_view name) const {
+        for (std::size_t i = 0; i < customerClasses.size(); ++i)
+            if (customerClasses[i] == name) return (int)i;
+        return -1;
+    }
+
+    // Fee for one stay. Negative results charge 0; billedHours is 0 for a
+    // free stay, else the started hours.
+    FeeBreakup price(SlotType s, int customerClass, unsigned long long minutes,
+                     std::chrono::system_clock::time_point in, std::chrono::system_clock::time_point out) const {
+        FeeBreakup r;
+        r.parkedMinutes = minutes;
+        std::int64_t a = program.run(TariffInput(minutes, s, customerClass, in, out, utcOffsetMinutes));
+        r.amount = a < 0 ? 0 : (unsigned long long)a;
+        r.billedHours = r.amount ? ceilHours(minutes) : 0;
+        return r;
+    }
+};
@@ -0,0 +1,155 @@
+#pragma once
+// ===================== Hierarchical timer wheel =====================
+// Deadlines in integer ticks. Four levels of 64 slots cover 64^4 ticks
+// ahead; later deadlines park in the top level and are re-placed when it
+// cascades. schedule()/cancel() are O(1) (nodes live in a pooled,
+// index-linked list per slot); advance() costs O(ticks passed + timers
+// moved or fired) and stops after `budget` expirations, resuming where it
+// left off on the next call. Deadlines already due go to an overdue list
+// that the next advance() fires first.
+// Not thread-safe: the owner serializes access.
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+class TimerWheel {
+public:
+    using Handle = std::uint32_t; // 0 = no timer
+    static constexpr int LEVELS = 4;
+    static constexpr int SLOT_BITS = 6;
+    static constexpr int SLOTS = 1 << SLOT_BITS;
+
+    struct Fired {
+        std::uint64_t id;
+        Handle handle; // already released; only for matching against stored handles
+    };
+
+    // Drops every timer and restarts the wheel at `nowTick`.
+    void reset(std::uint64_t nowTick) {
+        nodes_.assign(1, Node{});
+        free_ = 0;
+        for (auto& h : heads_) h = 0;
+        now_ = nowTick;
+        draining_ = false;
+        size_ = 0;
+    }
+
+    Handle schedule(std::uint64_t id, std::uint64_t deadlineTick) {
+        Handle h = free_;
+        if (h) free_ = nodes_[h].next;
+        else { h = (Handle)nodes_.size(); nodes_.emplace_back(); }
+        nodes_[h].id = id;
+        nodes_[h].deadline = deadlineTick;
+        place(h);
+        ++size_;
+        return h;
+    }
+
+    void cancel(Handle h) {
+        if (!h) return;
+        unlink(h);
+        release(h);
+        --size_;
+    }
+
+    // Fires timers due at or before `toTick` into `out`. Returns true once
+    // caught up, false if `budget` ran out first.
+    bool advance(std::uint64_t toTick, std::size_t budget, std::vector<Fired>& out) {
+        std::size_t fired = 0;
+        if (!fire(OVERDUE, budget, fired, out)) return false;
+        if (draining_) {
+            if (!fire((int)(now_ & (SLOTS - 1)), budget, fired, out)) return false;
+            draining_ = false;
+        }
+        while (now_ < toTick) {
+            ++now_;
+            draining_ = true;
+            cascade();
+            if (!fire((int)(now_ & (SLOTS - 1)), budget, fired, out)) return false;
+            draining_ = false;
+        }
+        return true;
+    }
+
+    std::uint64_t now() const { return now_; }
+    std::size_t size() const { return size_; }
+    std::size_t heapBytes() const { return nodes_.capacity() * sizeof(Node); }
+
+private:
+    static constexpr int OVERDUE = LEVELS * SLOTS; // extra list for already-due timers
+
+    struct Node {
+        std::uint64_t id = 0;
+        std::uint64_t deadline = 0;
+        Handle prev = 0, next = 0;
+        int slot = -1;
+    };
+
+    void place(Handle h) {
+        Node& n = nodes_[h];
+        int slot = OVERDUE;
+        if (n.deadline > now_ || (n.deadline == now_ && draining_)) {
+            std::uint64_t delta = n.deadline - now_;
+            std::uint64_t d = n.deadline;
+            int level = 0;
+            while (level < LEVELS - 1 && delta >= (1ULL << (SLOT_BITS * (level + 1)))) ++level;
+            if (delta >= (1ULL << (SLOT_BITS * LEVELS)))
+                d = now_ + (1ULL << (SLOT_BITS * LEVELS)) - 1; // beyond range: re-placed on cascade
+            slot = level * SLOTS + (int)((d >> (SLOT_BITS * level)) & (SLOTS - 1));
+        }
+        n.slot = slot;
+        n.prev = 0;
+        n.next = heads_[slot];
+        if (n.next) nodes_[n.next].prev = h;
+        heads_[slot] = h;
+    }
+
+    void unlink(Handle h) {
+        Node& n = nodes_[h];
+        if (n.prev) nodes_[n.prev].next = n.next;
+        else heads_[n.slot] = n.next;
+        if (n.next) nodes_[n.next].prev = n.prev;
+    }
+
+    void release(Handle h) {
+        nodes_[h].slot = -1;
+        nodes_[h].next = free_;
+        free_ = h;
+    }
+
+    // On each wrap of a lower level, re-place the matching slot of the next one.
+    void cascade() {
+        for (int level = 1; level < LEVELS; ++level) {
+            if (now_ & ((1ULL << (SLOT_BITS * level)) - 1)) break;
+            int slot = level * SLOTS + (int)((now_ >> (SLOT_BITS * level)) & (SLOTS - 1));
+            Handle h = heads_[slot];
+            heads_[slot] = 0;
+            while (h) {
+                Handle next = nodes_[h].next;
+                place(h);
+                h = next;
+            }
+        }
+    }
+
+    bool fire(int slot, std::size_t budget, std::size_t& fired, std::vector<Fired>& out) {
+        while (heads_[slot]) {
+            if (fired == budget) return false;
+            Handle h = heads_[slot];
+            unlink(h);
+            out.push_back(Fired{nodes_[h].id, h});
+            release(h);
+            --size_;
+            ++fired;
+        }
+        return true;
+    }
+
+    std::vector<Node> nodes_ = std::vector<Node>(1); // [0] unused so 0 can mean "none"
+    Handle free_ = 0;
+    Handle heads_[LEVELS * SLOTS + 1] = {};
+    std::uint64_t now_ = 0;
+    bool draining_ = false; // level-0 slot of now_ partly fired
+    std::size_t size_ = 0;
+};
@@ -0,0 +1,260 @@
+#pragma once
+// ===================== Span tracing =====================
+// Lightweight request tracing with Chrome / Perfetto trace-event export.
+//
+//   Tracer::instance().enable(/*sampleEvery*/ 100);   // 1 in 100 requests
+//   { TraceRequest req("lot.exit", tid);              // root span, decides sampling
+//     { TraceSpan s("lot.fee_compute"); ... } }       // child spans of a sampled request
+//   Tracer::instance().dumpChromeTrace("trace.json");  // open in ui.perfetto.dev
+//
+// A request served on another thread than the one that accepted it uses a
+// TraceHandoff instead of a TraceRequest (see GateServer).
+//
+// Each thread records into its own fixed-size ring (oldest events are
+// overwritten); the per-ring mutex is only contended while a dump runs.
+// A ring costs RING_CAPACITY x 32 bytes (128KB) per thread that ever
+// records; an exited thread's ring is kept for the next dump (or clear())
+// to show its events and is freed then.
+// When tracing is disabled a span costs one relaxed atomic load.
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+struct TraceEvent {
+    const char* name = nullptr; // must be a string literal
+    std::uint64_t startNs = 0;
+    std::uint64_t durNs = 0;
+    std::uint64_t arg = 0;
+};
+
+class Tracer {
+public:
+    static constexpr std::size_t RING_CAPACITY = 4096;
+
+    static Tracer& instance() { static Tracer t; return t; }
+
+    // sampleEvery = N traces one request in N; 0 disables.
+    void enable(unsigned sampleEvery = 1) { sampleEvery_.store(sampleEvery, std::memory_order_relaxed); }
+    void disable() { enable(0); }
+    bool enabled() const { return sampleEvery_.load(std::memory_order_relaxed) != 0; }
+
+    std::uint64_t nowNs() const {
+        return (std::uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - epoch_).count();
+    }
+
+    // Sampling decision for a new root request.
+    bool sampleNext() {
+        unsigned every = sampleEvery_.load(std::memory_order_relaxed);
+        if (every == 0) return false;
+        if (every == 1) return true;
+        return requestSeq_.fetch_add(1, std::memory_order_relaxed) % every == 0;
+    }
+
+    void record(const TraceEvent& ev) {
+        ThreadRing& r = local();
+        std::lock_guard<std::mutex> lk(r.mu);
+        r.events[r.head] = ev;
+        r.head = (r.head + 1) % RING_CAPACITY;
+        if (r.count < RING_CAPACITY) ++r.count;
+    }
+
+    void clear() {
+        std::lock_guard<std::mutex> lk(regMu_);
+        for (auto& r : rings_) {
+            std::lock_guard<std::mutex> rl(r->mu);
+            r->head = r->count = 0;
+        }
+        dropExited_locked();
+    }
+
+    void dumpChromeTrace(std::ostream& os) const {
+        std::lock_guard<std::mutex> lk(regMu_);
+        os << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+        bool first = true;
+        for (const auto& r : rings_) {
+            std::lock_guard<std::mutex> rl(r->mu);
+            std::size_t start = (r->head + RING_CAPACITY - r->count) % RING_CAPACITY;
+            for (std::size_t i = 0; i < r->count; ++i) {
+                const TraceEvent& e = r->events[(start + i) % RING_CAPACITY];
+                if (!first) os << ",";
+                first = false;
+                // trace-event timestamps are microseconds
+                os << "\n{\"name\":\"" << e.name << "\",\"cat\":\"parkinglot\",\"ph\":\"X\""
+                   << ",\"pid\":1,\"tid\":" << r->tid
+                   << ",\"ts\":" << e.startNs / 1000 << "." << pad3(e.startNs % 1000)
+                   << ",\"dur\":" << e.durNs / 1000 << "." << pad3(e.durNs % 1000)
+                   << ",\"args\":{\"id\":" << e.arg << "}}";
+            }
+        }
+        os << "\n]}\n";
+        dropExited_locked();
+    }
+
+    void dumpChromeTrace(const std::string& path) const {
+        std::ofstream f(path);
+        if (!f) throw std::runtime_error("Could not open trace file: " + path);
+        dumpChromeTrace(f);
+    }
+
+private:
+    struct ThreadRing {
+        mutable std::mutex mu;
+        unsigned tid = 0;
+        bool exited = false; // owning thread is gone; freed by the next dump / clear()
+        std::size_t head = 0, count = 0;
+        std::vector<TraceEvent> events = std::vector<TraceEvent>(RING_CAPACITY);
+    };
+
+    Tracer() : epoch_(std::chrono::steady_clock::now()) {}
+
+    // Marks this thread's ring exited when the thread ends.
+    struct RingOwner {
+        ThreadRing* ring = nullptr;
+        ~RingOwner() {
+            if (!ring) return;
+            std::lock_guard<std::mutex> lk(ring->mu);
+            ring->exited = true;
+            ring = nullptr;
+        }
+    };
+
+    // Rings outlive their threads until the next dump, so it still shows
+    // finished work.
+    ThreadRing& local() {
+        thread_local RingOwner owner;
+        if (!owner.ring) {
+            auto r = std::make_unique<ThreadRing>();
+            std::lock_guard<std::mutex> lk(regMu_);
+            r->tid = ++lastTid_;
+            owner.ring = r.get();
+            rings_.push_back(std::move(r));
+        }
+        return *owner.ring;
+    }
+
+    // Under regMu_.
+    void dropExited_locked() const {
+        rings_.erase(std::remove_if(rings_.begin(), rings_.end(),
+                                    [](const std::unique_ptr<ThreadRing>& r) {
+                                        std::lock_guard<std::mutex> rl(r->mu);
+                                        return r->exited;
+                                    }),
+                     rings_.end());
+    }
+
+    static std::string pad3(std::uint64_t v) {
+        std::string s = std::to_string(v);
+        return std::string(3 - s.size(), '0') + s;
+    }
+
+    std::chrono::steady_clock::time_point epoch_;
+    std::atomic<unsigned> sampleEvery_{0};
+    std::atomic<std::uint64_t> requestSeq_{0};
+    mutable std::mutex regMu_; // guards rings_ and lastTid_
+    mutable std::vector<std::unique_ptr<ThreadRing>> rings_; // a dump frees exited threads' rings
+    unsigned lastTid_ = 0;
+};
+
+namespace tracing_detail {
+// Depth of the current request on this thread; > 0 only while sampled.
+inline thread_local int sampledDepth = 0;
+// > 0 while serving a handed-off request that was not sampled, so its
+// TraceRequests do not sample on their own.
+inline thread_local int unsampledDepth = 0;
+}
+
+// Child span: recorded only inside a sampled request.
+class TraceSpan {
+    const char* name_;
+    std::uint64_t arg_;
+    std::uint64_t start_ = 0;
+    bool live_;
+public:
+    explicit TraceSpan(const char* name, std::uint64_t arg = 0)
+        : name_(name), arg_(arg), live_(tracing_detail::sampledDepth > 0) {
+        if (live_) start_ = Tracer::instance().nowNs();
+    }
+    void setArg(std::uint64_t arg) { arg_ = arg; }
+    // Ends the span early (e.g. a lock wait); the destructor is then a no-op.
+    void end() {
+        if (!live_) return;
+        live_ = false;
+        auto& t = Tracer::instance();
+        t.record(TraceEvent{name_, start_, t.nowNs() - start_, arg_});
+    }
+    ~TraceSpan() { end(); }
+    TraceSpan(const TraceSpan&) = delete;
+    TraceSpan& operator=(const TraceSpan&) = delete;
+};
+
+// Root span of a request (enter / exit / pay). Nested roots act as children.
+class TraceRequest {
+    bool sampled_;
+    TraceSpan span_;
+    static bool begin() {
+        if (tracing_detail::sampledDepth > 0) { ++tracing_detail::sampledDepth; return true; }
+        if (tracing_detail::unsampledDepth > 0 || !Tracer::instance().sampleNext()) return false;
+        tracing_detail::sampledDepth = 1;
+        return true;
+    }
+public:
+    explicit TraceRequest(const char* name, std::uint64_t arg = 0)
+        : sampled_(begin()), span_(name, arg) {}
+    void setArg(std::uint64_t arg) { span_.setArg(arg); }
+    ~TraceRequest() {
+        span_.end();
+        if (sampled_) --tracing_detail::sampledDepth;
+    }
+    TraceRequest(const TraceRequest&) = delete;
+    TraceRequest& operator=(const TraceRequest&) = delete;
+};
+
+// Root span of a request that crosses threads (a gate call): begin() on the
+// submitting thread decides sampling and takes the start time; the thread
+// that serves it opens a Scope, so its TraceRequests and TraceSpans become
+// children (or stay silent if the request was not sampled), and finish()
+// records the whole span, queueing included, there.
+class TraceHandoff {
+    const char* name_ = nullptr;
+    std::uint64_t arg_ = 0;
+    std::uint64_t start_ = 0;
+    bool live_ = false;
+public:
+    void begin(const char* name, std::uint64_t arg = 0) {
+        name_ = name;
+        arg_ = arg;
+        live_ = tracing_detail::sampledDepth > 0 ||
+                (tracing_detail::unsampledDepth == 0 && Tracer::instance().sampleNext());
+        if (live_) start_ = Tracer::instance().nowNs();
+    }
+    void setArg(std::uint64_t arg) { arg_ = arg; }
+    void finish() {
+        if (!live_) return;
+        live_ = false;
+        auto& t = Tracer::instance();
+        t.record(TraceEvent{name_, start_, t.nowNs() - start_, arg_});
+    }
+
+    class Scope {
+        bool sampled_;
+    public:
+        explicit Scope(const TraceHandoff& h) : sampled_(h.live_) {
+            ++(sampled_ ? tracing_detail::sampledDepth : tracing_detail::unsampledDepth);
+        }
+        ~Scope() {
+            --(sampled_ ? tracing_detail::sampledDepth : tracing_detail::unsampledDepth);
+        }
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+    };
+};